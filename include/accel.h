@@ -0,0 +1,117 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- 指针加速 ---
+// 速度 -> 增益 的查找表采用 Q12 定点（4096 = 1.0），每个样本只做一次查表和两次乘法，
+// 运行时间与曲线类型无关。曲线在配置时（而不是逐样本）用浮点生成。
+// 速度按发送端的报告周期归一化为 计数/毫秒，同一条曲线在 125Hz 和 8kHz 的发送端上手感一致。
+
+constexpr int ACCEL_GAIN_SHIFT = 12;
+constexpr int32_t ACCEL_GAIN_ONE = 1 << ACCEL_GAIN_SHIFT;
+constexpr size_t ACCEL_LUT_SIZE = 64;       // 速度单位：计数/毫秒，超过 63 的按 63 取表
+constexpr size_t ACCEL_MAX_POINTS = 8;      // 分段曲线的最大控制点数
+constexpr float ACCEL_MAX_GAIN = 15.9f;     // uint16 Q12 可表示的上限附近
+constexpr int ACCEL_SPEED_SHIFT = 8;        // 计数/样本 -> 计数/毫秒 的换算系数为 Q8
+constexpr uint16_t ACCEL_DEFAULT_INTERVAL_US = 1000;  // 发送端未报告周期时按 1kHz 计
+constexpr uint16_t ACCEL_MIN_INTERVAL_US = 125;       // 更短的周期按 8kHz 计，换算不会溢出
+
+typedef enum : uint8_t {
+    ACCEL_CURVE_LINEAR = 0,   // gain = sensitivity + slope * speed
+    ACCEL_CURVE_POWER,        // gain = sensitivity * (speed / refSpeed)^(exponent - 1)
+    ACCEL_CURVE_PIECEWISE,    // 控制点之间线性插值
+} AccelCurveType;
+
+struct AccelPoint {
+    uint8_t speed;
+    float gain;
+};
+
+struct AccelCurveParams {
+    AccelCurveType type;
+    float sensitivity;
+    float slope;
+    float exponent;
+    float refSpeed;
+    AccelPoint points[ACCEL_MAX_POINTS];
+    uint8_t pointCount;
+};
+
+struct AccelCurve {
+    uint16_t gain[ACCEL_LUT_SIZE];
+};
+
+// 由参数生成查找表；参数非法时返回 false 且不修改 out
+bool buildAccelCurve(const AccelCurveParams& params, AccelCurve& out);
+
+// 解析一个分段曲线控制点 "速度:增益"；速度须为 0~255 的整数，增益须在 [0, ACCEL_MAX_GAIN] 内，
+// 格式或范围不对时返回 false 且不修改 out
+bool accelParsePoint(const char* token, AccelPoint& out);
+
+// 打印曲线参数（串口调试用）
+void printAccelCurveParams(const AccelCurveParams& params);
+
+// 基准测试：用伪随机运动样本测量每样本的 CPU 周期数（主机上为纳秒），打印并返回
+float benchAccel(const AccelCurve& curve, uint32_t samples);
+
+// 常数时间的向量长度近似：max + min/2，误差约 ±12%，足以用作查表索引
+inline uint32_t approxSpeed(int32_t dx, int32_t dy) {
+    uint32_t ax = dx < 0 ? -dx : dx;
+    uint32_t ay = dy < 0 ? -dy : dy;
+    return ax > ay ? ax + (ay >> 1) : ay + (ax >> 1);
+}
+
+// 计数/样本 -> 计数/毫秒 的 Q8 换算系数
+constexpr uint32_t accelSpeedScale(uint16_t intervalUs) {
+    const uint32_t us = intervalUs < ACCEL_MIN_INTERVAL_US ? ACCEL_MIN_INTERVAL_US : intervalUs;
+    return ((1000u << ACCEL_SPEED_SHIFT) + us / 2) / us;
+}
+
+// 加速引擎：保存查找表、当前的速度换算系数以及 X/Y 的亚计数余量
+class AccelEngine {
+public:
+    void setCurve(const AccelCurve& curve) { curve_ = curve; }
+
+    // 发送端的报告周期；0 表示未知，沿用上一次的值。只在周期变化时做一次除法
+    void setSampleInterval(uint16_t intervalUs) {
+        if (intervalUs != 0 && intervalUs != intervalUs_) {
+            intervalUs_ = intervalUs;
+            speedScale_ = accelSpeedScale(intervalUs);
+        }
+    }
+
+    void reset() {
+        remX_ = 0;
+        remY_ = 0;
+        intervalUs_ = ACCEL_DEFAULT_INTERVAL_US;
+        speedScale_ = accelSpeedScale(ACCEL_DEFAULT_INTERVAL_US);
+    }
+
+    // 对一个样本应用加速；小数部分累积到下一个样本，慢速移动不会被吞掉
+    void apply(int16_t& dx, int16_t& dy) {
+        uint32_t speed = (approxSpeed(dx, dy) * speedScale_) >> ACCEL_SPEED_SHIFT;
+        if (speed >= ACCEL_LUT_SIZE) {
+            speed = ACCEL_LUT_SIZE - 1;
+        }
+        const int32_t gain = curve_.gain[speed];
+        dx = scaleAxis(dx, gain, remX_);
+        dy = scaleAxis(dy, gain, remY_);
+    }
+
+private:
+    static int16_t scaleAxis(int32_t v, int32_t gain, int32_t& rem) {
+        int32_t acc = v * gain + rem;
+        int32_t out = acc >> ACCEL_GAIN_SHIFT;  // 算术右移 = 向下取整，余量恒为非负
+        rem = acc - (out << ACCEL_GAIN_SHIFT);
+        if (out > INT16_MAX) out = INT16_MAX;
+        if (out < INT16_MIN) out = INT16_MIN;
+        return (int16_t)out;
+    }
+
+    AccelCurve curve_ = {};
+    int32_t remX_ = 0;
+    int32_t remY_ = 0;
+    uint16_t intervalUs_ = ACCEL_DEFAULT_INTERVAL_US;
+    uint32_t speedScale_ = accelSpeedScale(ACCEL_DEFAULT_INTERVAL_US);
+};
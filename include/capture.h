@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- 帧捕获 ---
+// 在接收回调中记录解析器看到的原始数据帧（已去掉认证标签）及其到达时间，供回放复现现场问题。
+//   RAM   ：32KB 环形缓冲，满了覆盖最旧的记录，停止后保留最近约一两千帧
+//   闪存  ：先写入 RAM 缓冲，由控制任务搬到 spiffs 分区（原始写入，不经文件系统），写满即停；
+//           闪存写入期间缓存被关闭，会轻微影响处理延迟，复现对时序敏感的问题时优先用 RAM。
+// 闪存布局：第 0 扇区为 CaptureFileHeader，记录从 CAPTURE_FLASH_DATA_OFFSET 起连续存放。
+// 每条记录 = CaptureRecordHeader + len 字节的帧数据。
+
+enum CaptureMode : uint8_t {
+    CAPTURE_OFF = 0,
+    CAPTURE_RAM,
+    CAPTURE_FLASH,
+};
+
+struct CaptureRecordHeader {
+    uint32_t arrivalUs;
+    uint8_t mac[6];
+    uint8_t len;
+    uint8_t flags;   // CAPTURE_RECORD_WRAP：RAM 环形缓冲的回绕标记，不是数据
+};
+
+enum : uint8_t {
+    CAPTURE_RECORD_WRAP = 0x80,
+};
+
+struct CaptureFileHeader {
+    uint32_t magic;       // CAPTURE_MAGIC
+    uint32_t version;
+    uint32_t records;
+    uint32_t dataBytes;
+};
+
+constexpr uint32_t CAPTURE_MAGIC = 0x50435943; // "CYCP"
+constexpr uint32_t CAPTURE_VERSION = 1;
+constexpr size_t CAPTURE_RAM_SIZE = 32 * 1024;
+constexpr size_t CAPTURE_MAX_FRAME = 250;       // ESP_NOW_MAX_DATA_LEN
+constexpr uint32_t CAPTURE_FLASH_DATA_OFFSET = 4096;
+
+// 以下在控制任务（串口命令）中调用
+bool captureStart(CaptureMode mode, uint32_t flashBytes);
+void captureStop();
+bool captureActive();
+void captureService();      // 闪存模式下把 RAM 中的记录写入分区
+void capturePrintStatus();
+void captureDump(CaptureMode source); // 以文本行输出记录，便于保存到主机
+
+// 在接收回调中调用；未开启捕获时只做一次判断
+void captureFrame(const uint8_t mac[6], const uint8_t* data, int len, uint32_t arrivalUs);
+
+// 顺序读取已停止的捕获（RAM 或闪存）
+class CaptureReader {
+public:
+    bool open(CaptureMode source);
+    bool next(CaptureRecordHeader& header, uint8_t data[CAPTURE_MAX_FRAME]);
+
+private:
+    CaptureMode source_ = CAPTURE_OFF;
+    size_t pos_ = 0;
+    uint32_t remaining_ = 0;
+};
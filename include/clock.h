@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+
+// --- 时钟 ---
+// 连接状态机和管线（外推、按键保活、HID 计时）的时间都来自构造时传入的 Clock，不直接调用
+// millis()/micros()。固件用 SystemClock；主机测试用 VirtualClock，时间只在 advance*() 时前进，
+// 几小时的配对/超时/广播过程可以逐拍、确定地走完。
+class Clock {
+public:
+    virtual uint32_t nowMs() const = 0;
+    virtual uint32_t nowUs() const = 0;
+
+protected:
+    ~Clock() = default;
+};
+
+class SystemClock final : public Clock {
+public:
+    uint32_t nowMs() const override { return (uint32_t)millis(); }
+    uint32_t nowUs() const override { return (uint32_t)micros(); }
+};
+
+inline SystemClock systemClock;
+
+// 虚拟时钟：内部按 64 位微秒计时，毫秒与微秒读数和系统时钟一样各自在 32 位处回绕
+class VirtualClock final : public Clock {
+public:
+    explicit VirtualClock(uint32_t startMs = 0) : us_((uint64_t)startMs * 1000) {}
+
+    uint32_t nowMs() const override { return (uint32_t)(us_ / 1000); }
+    uint32_t nowUs() const override { return (uint32_t)us_; }
+
+    void advanceUs(uint32_t us) { us_ += us; }
+    void advanceMs(uint32_t ms) { us_ += (uint64_t)ms * 1000; }
+    // 前进到给定的毫秒读数（按回绕后的差值前进，不会倒退）
+    void advanceToMs(uint32_t ms) { advanceMs(ms - nowMs()); }
+
+private:
+    uint64_t us_;
+};
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "accel.h"
+#include "jitter_buffer.h"
+#include "jitter_filter.h"
+#include "motion_predictor.h"
+#include "protocol.h"
+
+// --- 编译期配置 ---
+// 接收端的全部可调参数集中在一个 constexpr 结构中，由它驱动模板化的处理管线。
+// 被关闭的功能在编译期裁剪掉，不会生成任何代码。
+
+// HID 鼠标按键位（即鼠标输入报告中按键字节的位）
+enum : uint8_t {
+    HID_BUTTON_LEFT     = 0x01,
+    HID_BUTTON_RIGHT    = 0x02,
+    HID_BUTTON_MIDDLE   = 0x04,
+    HID_BUTTON_BACKWARD = 0x08,
+    HID_BUTTON_FORWARD  = 0x10,
+};
+
+// 数据包 buttons 字段中的一位 -> HID 按键
+struct ButtonMapEntry {
+    uint8_t packetMask;
+    uint8_t hidButton;
+};
+
+constexpr size_t MAX_BUTTON_MAP = 8;
+
+// 功能开关：为 false 时对应代码在编译期被裁剪
+struct FeatureToggles {
+    bool filters;  // 运动变换/滤波阶段（总开关）
+    bool dpiScale; // 按发送端的 DPI 缩放
+    bool jitter;   // 自适应抖动滤波
+    bool predictor; // 丢包时的运动外推
+    bool jitterBuffer; // 按发送端时间戳回放的抖动缓冲
+    bool feedback; // 向发送端回报链路质量
+    bool accel;    // 指针加速
+    bool stats;    // 管线统计计数
+    bool tracing;  // 逐包串口追踪（调试用，开销大）
+    bool keyboard; // 复合 HID 中的全键无冲键盘
+};
+
+struct ReceiverConfig {
+    // 无线
+    uint8_t wifiChannel;
+    uint32_t connectionTimeoutMs;  // 超过该时间无数据则认为连接丢失
+    uint32_t beaconIntervalMs;     // 未连接时的身份广播间隔
+    uint32_t loopIntervalMs;       // 主循环休眠时间
+
+    // 握手时声明的能力
+    uint16_t minReportIntervalUs;  // USB 全速 HID 最快 1ms 轮询一次，更快的报告没有意义
+    uint16_t hidResolution;        // 期望的 HID 分辨率（CPI）
+
+    // 队列与任务：接收解析在 Wi-Fi 任务（核 0）中完成，经无锁通道交给 HID 输出任务；
+    // 配对、对等设备增删、NVS 读写和日志都在低优先级的控制任务中进行
+    size_t queueLength;            // 接收 -> HID 输出通道的容量（2 的幂）
+    uint32_t mouseTaskStackSize;
+    uint8_t mouseTaskPriorityBelowMax;  // 实际优先级 = configMAX_PRIORITIES - 1 - 该值
+    int mouseTaskCore;             // HID 输出任务所在的核，与 Wi-Fi 任务分开
+    uint32_t controlTaskStackSize;
+    uint8_t controlTaskPriority;
+    int controlTaskCore;
+
+    // 按键映射表
+    ButtonMapEntry buttonMap[MAX_BUTTON_MAP];
+    size_t buttonCount;
+
+    FeatureToggles features;
+    uint32_t statsReportIntervalMs;
+    uint32_t feedbackIntervalMs;   // 链路质量反馈的发送周期
+    uint32_t hidKeepAliveMs;       // 按键按住期间至少每隔这么久向主机重发一次报告（0 = 只在变化时发送）
+    uint16_t suspendedIntervalUs;  // USB 主机挂起期间建议发送端使用的报告周期
+    uint16_t remoteWakeMotion;     // 挂起期间 250ms 内累计移动达到这么多计数时请求远程唤醒（0 = 只由按键唤醒）
+    bool preferFrameTags;          // 认证配对后优先用明文帧 + 认证标签（更低延迟）代替硬件加密
+
+    // 上电默认的加速曲线，可通过串口 accel 命令修改
+    AccelCurveParams accel;
+
+    // 上电默认的抖动滤波参数，可通过串口 jitter 命令修改
+    JitterFilterParams jitter;
+
+    // 上电默认的丢包外推参数，可通过串口 predict 命令修改
+    PredictorParams predictor;
+
+    // 上电默认的抖动缓冲参数，可通过串口 playout 命令修改
+    JitterBufferParams jitterBuffer;
+};
+
+inline constexpr ReceiverConfig kReceiverConfig = {
+    /* wifiChannel               */ 13,
+    /* connectionTimeoutMs       */ 3000,
+    /* beaconIntervalMs          */ 1000,
+    /* loopIntervalMs            */ 100,
+    /* minReportIntervalUs       */ 1000,
+    /* hidResolution             */ 800,
+    /* queueLength               */ 32,
+    /* mouseTaskStackSize        */ 4096,
+    /* mouseTaskPriorityBelowMax */ 0,
+    /* mouseTaskCore             */ 1,
+    /* controlTaskStackSize      */ 8192,
+    /* controlTaskPriority       */ 1,
+    /* controlTaskCore           */ 0,
+    /* buttonMap */ {
+        {0x01, HID_BUTTON_LEFT},
+        {0x02, HID_BUTTON_RIGHT},
+        {0x04, HID_BUTTON_MIDDLE},
+        {0x08, HID_BUTTON_BACKWARD},
+        {0x10, HID_BUTTON_FORWARD},
+    },
+    /* buttonCount               */ 5,
+    /* features: filters, dpiScale, jitter, predictor, jitterBuffer, feedback, accel, stats, tracing, keyboard */
+    {true, true, true, true, true, true, true, true, false, true},
+    /* statsReportIntervalMs     */ 10000,
+    /* feedbackIntervalMs        */ 500,
+    /* hidKeepAliveMs            */ 0,
+    /* suspendedIntervalUs       */ 20000,
+    /* remoteWakeMotion          */ 40,
+    /* preferFrameTags           */ false,
+    /* accel: 增益恒为 1.0，即不加速 */ {ACCEL_CURVE_LINEAR, 1.0f, 0.0f, 1.0f, 1.0f, {}, 0},
+    /* jitter: 默认关闭 */ {false, 1.0f, 1.0f, 1.0f, 4.0f},
+    /* predictor: 默认关闭，最多外推 3 帧，每帧衰减到 0.75，宽限 50% */ {false, 3, 192, 50},
+    /* jitterBuffer: 默认关闭，播放延迟 0~800us，抖动估计的 3 倍 */ {false, 0, 800, 3},
+};
+
+// 编译期校验配置的合法性
+constexpr bool buttonMapIsValid(const ReceiverConfig& cfg) {
+    if (cfg.buttonCount > MAX_BUTTON_MAP) {
+        return false;
+    }
+    uint8_t seen = 0;
+    for (size_t i = 0; i < cfg.buttonCount; i++) {
+        const uint8_t mask = cfg.buttonMap[i].packetMask;
+        // 每个表项必须恰好占用一个位，且不能重复
+        if (mask == 0 || (mask & (mask - 1)) != 0 || (seen & mask) != 0) {
+            return false;
+        }
+        seen |= mask;
+    }
+    return true;
+}
+
+static_assert(kReceiverConfig.wifiChannel >= 1 && kReceiverConfig.wifiChannel <= 14, "Wi-Fi 频道必须在 1~14 之间");
+static_assert(kReceiverConfig.queueLength >= 2 && (kReceiverConfig.queueLength & (kReceiverConfig.queueLength - 1)) == 0,
+              "队列长度必须是 2 的幂");
+static_assert(kReceiverConfig.queueLength <= UINT8_MAX, "队列深度在反馈中以单字节上报");
+static_assert(kReceiverConfig.controlTaskCore != kReceiverConfig.mouseTaskCore, "控制任务不能与 HID 输出任务共用一个核");
+static_assert(kReceiverConfig.connectionTimeoutMs > kReceiverConfig.loopIntervalMs, "连接超时必须大于主循环间隔");
+static_assert(buttonMapIsValid(kReceiverConfig), "按键映射表非法");
+static_assert(kReceiverConfig.suspendedIntervalUs >= kReceiverConfig.minReportIntervalUs, "挂起期间的报告周期不能短于最短周期");
+
+// 接收端在握手中声明的能力，由编译期配置推导
+constexpr Capabilities receiverCapabilities(const ReceiverConfig& cfg) {
+    Capabilities caps = {};
+    caps.wireVersion = WIRE_FORMAT_VERSION;
+    caps.features = CAP_SEQUENCE | CAP_FEC | CAP_CUMULATIVE | CAP_PACKED | CAP_BATCHING | CAP_HIRES_SCROLL;
+    if (cfg.features.jitterBuffer) {
+        caps.features |= CAP_TIMESTAMPS | CAP_CLOCK_SYNC;
+    }
+    if (cfg.features.feedback) {
+        caps.features |= CAP_FEEDBACK;
+    }
+    if (cfg.features.keyboard) {
+        caps.features |= CAP_KEYBOARD;
+    }
+    caps.minIntervalUs = cfg.minReportIntervalUs;
+    caps.channel = cfg.wifiChannel;
+    caps.maxRedundancy = FEC_MAX_REDUNDANCY;
+    caps.resolution = cfg.hidResolution;
+    return caps;
+}
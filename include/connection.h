@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "clock.h"
+#include "handshake.h"
+#include "protocol.h"
+#include "seqlock.h"
+
+// --- 连接状态机 ---
+// 未连接时按 beaconIntervalMs 广播身份；已连接时超过 timeoutMs 没有数据包就断开，回到广播。
+// 旧发送端不握手，首个数据包即建立连接；握手/认证完成后由控制任务调用 connect()。
+// 时间全部来自构造时传入的时钟，对外的动作（广播、对等设备增删、日志）通过 ConnectionEvents
+// 回调完成，状态机本身不碰无线和串口：固件与主机测试（test/test_connection）运行的是同一份代码。
+//
+// 只有一个任务（固件中是控制任务）调用它的方法。每次状态变化后发布一份快照，接收回调、
+// mouseTask 等其他任务只通过 snapshot() 读取，不会读到写了一半的对端 MAC。
+
+struct ConnectionParams {
+    uint32_t timeoutMs;         // 超过该时间无数据则认为连接丢失
+    uint32_t beaconIntervalMs;  // 未连接时的身份广播间隔
+};
+
+// 发布给其他任务的连接状态
+struct ConnectionSnapshot {
+    uint32_t generation;   // 每建立一次连接加一
+    uint32_t disconnects;
+    uint8_t peer[6];
+    bool connected;
+
+    bool isPeer(const uint8_t mac[6]) const { return connected && memcmp(mac, peer, 6) == 0; }
+};
+
+enum DisconnectReason : uint8_t {
+    DISCONNECT_TIMEOUT,    // 超过 timeoutMs 没有对端的数据包
+    DISCONNECT_REQUESTED,  // 调用方主动断开（回放、仿真、负载测试收尾）
+};
+
+class ConnectionEvents {
+public:
+    virtual void onConnected(const uint8_t mac[6], const LinkMode& mode) = 0;
+    virtual void onDisconnected(const uint8_t mac[6], DisconnectReason reason) = 0;  // mac 为断开前的对端
+    virtual void onBeacon() = 0;  // 到了广播时刻（是否真的发出由回调决定）
+
+protected:
+    ~ConnectionEvents() = default;
+};
+
+class ConnectionManager {
+public:
+    ConnectionManager(const ConnectionParams& params, const Clock& clock, ConnectionEvents& events)
+        : params_(params), clock_(clock), events_(events), mode_(legacyLinkMode()) {
+        publish();
+    }
+
+    // 收到数据包：来自对端时刷新心跳时间；未连接时以旧式链路模式建立连接并返回 true
+    bool packetSeen(const uint8_t mac[6]);
+
+    // 对端的数据包在 atMs 到达（由 mouseTask 转交）：比记录的心跳时间新才刷新
+    void heartbeat(uint32_t atMs);
+
+    // 握手或认证完成，建立（或以新的链路模式重建）连接
+    void connect(const uint8_t mac[6], const LinkMode& mode);
+
+    // 断开并回到广播；心跳超时由 service() 以 DISCONNECT_TIMEOUT 调用
+    void disconnect(DisconnectReason reason = DISCONNECT_REQUESTED);
+
+    // 已连接的对端重新认证：暂停连接，不删除对等设备，也不计入断开次数；认证通过后 connect() 恢复
+    void pause();
+
+    // 周期调用（控制任务每拍一次）：未连接时按间隔广播，已连接时检查心跳超时
+    void service();
+
+    bool connected() const { return connected_; }
+    bool isPeer(const uint8_t mac[6]) const { return connected_ && memcmp(mac, peer_, 6) == 0; }
+    const uint8_t* peer() const { return peer_; }
+    const LinkMode& mode() const { return mode_; }
+    uint32_t generation() const { return generation_; }  // 每建立一次连接加一
+    uint32_t disconnects() const { return disconnects_; }
+    uint32_t beacons() const { return beacons_; }         // 到达广播时刻的次数
+
+    // 任意任务调用：最近一次发布的连接状态
+    ConnectionSnapshot snapshot() const { return published_.load(); }
+
+private:
+    void publish();
+
+    ConnectionParams params_;
+    const Clock& clock_;
+    ConnectionEvents& events_;
+
+    bool connected_ = false;
+    uint8_t peer_[6] = {};
+    LinkMode mode_;
+    uint32_t lastPacketMs_ = 0;
+    uint32_t generation_ = 0;
+    uint32_t disconnects_ = 0;
+    uint32_t lastBeaconMs_ = 0;
+    uint32_t beacons_ = 0;
+    SeqLock<ConnectionSnapshot> published_;
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --- 串口命令行 ---
+// 在控制任务中非阻塞轮询串口，读满一行后按命令表分发，用于运行时调参。
+
+constexpr size_t CONSOLE_MAX_ARGS = 12;
+
+typedef void (*ConsoleHandler)(int argc, char* argv[]);
+
+struct ConsoleCommand {
+    const char* name;
+    const char* usage;
+    ConsoleHandler handler;
+};
+
+// 解析 "AA:BB:CC:DD:EE:FF" 形式的MAC地址
+bool parseMacAddress(const char* text, uint8_t mac[6]);
+
+// 读取串口中已到达的字符；遇到换行时解析并执行命令（内置 help）
+void consolePoll(const ConsoleCommand* commands, size_t count);
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "protocol.h"
+
+// --- 累计计数解码 ---
+// 在接收回调中运行：按发送端 MAC 记录上次已送出的累计值，收到新帧时相减得到增量。
+// 增量超出队列项字段范围时只送出能表示的部分，其余留在差值里随下一帧送出，不会丢计数。
+
+constexpr size_t CUMULATIVE_MAX_PEERS = 4;
+constexpr int16_t CUMULATIVE_RESYNC_WINDOW = 64;  // 序号回退超过该值视为发送端重启
+
+class CumulativeDecoder {
+public:
+    void reset() { count_ = 0; }
+
+    // 解码成功时填充 item 并返回 true；重复/过期帧返回 false。
+    // 首次见到的发送端只建立基准，送出零位移（按键状态仍然有效）。
+    bool decode(const uint8_t mac[6], const CumulativeMotionPacket& packet, QueueItem_t& item) {
+        Peer* peer = find(mac);
+        if (peer != NULL) {
+            const int16_t ahead = (int16_t)(uint16_t)(packet.seq - peer->seq);
+            if (ahead <= 0 && ahead > -CUMULATIVE_RESYNC_WINDOW) {
+                return false;
+            }
+            if (ahead <= 0) {
+                peer = NULL; // 发送端重启，计数器已清零，重新建立基准
+                resyncs_++;
+            }
+        }
+        if (peer == NULL) {
+            peer = insert(mac);
+            peer->x = packet.totalX;
+            peer->y = packet.totalY;
+            peer->wheel = packet.totalWheel;
+        }
+
+        memcpy(item.mac_addr, mac, 6);
+        item.type = PACKET_TYPE_MOUSE_DATA;
+        item.flags = QUEUE_ITEM_HAS_SEQ | QUEUE_ITEM_COVERS_GAP;
+        item.seq = packet.seq;
+        item.intervalUs = packet.intervalUs;
+        item.deltaX = (int16_t)take(peer->x, packet.totalX, INT16_MIN, INT16_MAX);
+        item.deltaY = (int16_t)take(peer->y, packet.totalY, INT16_MIN, INT16_MAX);
+        item.wheel = (int8_t)take(peer->wheel, packet.totalWheel, INT8_MIN, INT8_MAX);
+        item.buttons = packet.buttons;
+        peer->seq = packet.seq;
+        return true;
+    }
+
+    uint32_t resyncs() const { return resyncs_; }
+
+private:
+    struct Peer {
+        uint8_t mac[6];
+        uint16_t seq;
+        uint32_t x;
+        uint32_t y;
+        uint32_t wheel;
+    };
+
+    // 回绕相减得到增量，按 [lo, hi] 截断，基准只前进实际送出的部分
+    static int32_t take(uint32_t& last, uint32_t total, int32_t lo, int32_t hi) {
+        int32_t delta = (int32_t)(total - last);
+        if (delta > hi) delta = hi;
+        if (delta < lo) delta = lo;
+        last += (uint32_t)delta;
+        return delta;
+    }
+
+    Peer* find(const uint8_t mac[6]) {
+        for (size_t i = 0; i < count_; i++) {
+            if (memcmp(peers_[i].mac, mac, 6) == 0) {
+                return &peers_[i];
+            }
+        }
+        return NULL;
+    }
+
+    // 表满时淘汰最早的表项
+    Peer* insert(const uint8_t mac[6]) {
+        Peer* peer = find(mac);
+        if (peer == NULL) {
+            if (count_ < CUMULATIVE_MAX_PEERS) {
+                peer = &peers_[count_++];
+            } else {
+                memmove(&peers_[0], &peers_[1], sizeof(Peer) * (CUMULATIVE_MAX_PEERS - 1));
+                peer = &peers_[CUMULATIVE_MAX_PEERS - 1];
+            }
+            memcpy(peer->mac, mac, 6);
+        }
+        return peer;
+    }
+
+    Peer peers_[CUMULATIVE_MAX_PEERS] = {};
+    size_t count_ = 0;
+    uint32_t resyncs_ = 0;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// --- DPI 缩放 ---
+// 每个发送端独立的 X/Y 缩放系数，Q16 定点（65536 = 1.0）。
+// 小数部分逐样本累积，缩放 0.37 这样的系数既不会产生偏差，也不会吞掉慢速移动。
+
+constexpr int DPI_SCALE_SHIFT = 16;
+constexpr int32_t DPI_SCALE_ONE = 1 << DPI_SCALE_SHIFT;
+constexpr float DPI_SCALE_MAX = 16.0f;
+constexpr size_t DPI_MAX_PEERS = 8;
+
+struct DpiScaleEntry {
+    uint8_t mac[6];
+    int32_t scaleX;
+    int32_t scaleY;
+};
+
+// 持久化到 NVS 的缩放表：未单独配置的发送端使用默认系数
+struct DpiScaleTable {
+    uint32_t version;
+    int32_t defaultX;
+    int32_t defaultY;
+    uint8_t count;
+    DpiScaleEntry entries[DPI_MAX_PEERS];
+};
+
+constexpr uint32_t DPI_TABLE_VERSION = 1;
+
+// 浮点系数 -> Q16，超出 [0, DPI_SCALE_MAX] 返回 false
+bool dpiScaleFromFloat(float scale, int32_t& out);
+
+// Q16 系数是否在 [0, DPI_SCALE_MAX] 内
+inline bool dpiScaleIsValid(int32_t scale) {
+    return scale >= 0 && scale <= (int32_t)(DPI_SCALE_MAX * DPI_SCALE_ONE);
+}
+
+// 查找发送端的缩放系数（找不到时返回默认值）
+void dpiTableLookup(const DpiScaleTable& table, const uint8_t mac[6], int32_t& scaleX, int32_t& scaleY);
+
+// 设置/删除某个发送端的系数，mac 为 NULL 表示默认系数；表满时返回 false
+bool dpiTableSet(DpiScaleTable& table, const uint8_t* mac, int32_t scaleX, int32_t scaleY);
+bool dpiTableRemove(DpiScaleTable& table, const uint8_t* mac);
+
+void dpiTableReset(DpiScaleTable& table);
+
+// 把超出范围的系数（默认值或某个发送端的任一轴）恢复为 1.0，返回被修正的项数
+uint8_t dpiTableSanitize(DpiScaleTable& table);
+void dpiTablePrint(const DpiScaleTable& table);
+
+// NVS 读写（需在 nvs_flash_init 之后调用）；读取失败时表被重置为默认值，
+// 读到的表中损坏的系数逐项恢复为 1.0
+bool dpiTableLoad(DpiScaleTable& table);
+bool dpiTableSave(const DpiScaleTable& table);
+
+class DpiScaler {
+public:
+    void setScale(int32_t scaleX, int32_t scaleY) {
+        scaleX_ = scaleX;
+        scaleY_ = scaleY;
+        reset();
+    }
+
+    void reset() {
+        remX_ = 0;
+        remY_ = 0;
+    }
+
+    void apply(int16_t& dx, int16_t& dy) {
+        dx = scaleAxis(dx, scaleX_, remX_);
+        dy = scaleAxis(dy, scaleY_, remY_);
+    }
+
+private:
+    static int16_t scaleAxis(int32_t v, int32_t scale, int32_t& rem) {
+        int64_t acc = (int64_t)v * scale + rem;
+        int64_t out = acc >> DPI_SCALE_SHIFT;  // 向下取整，余量恒在 [0, 1.0)
+        rem = (int32_t)(acc - (out << DPI_SCALE_SHIFT));
+        if (out > INT16_MAX) out = INT16_MAX;
+        if (out < INT16_MIN) out = INT16_MIN;
+        return (int16_t)out;
+    }
+
+    int32_t scaleX_ = DPI_SCALE_ONE;
+    int32_t scaleY_ = DPI_SCALE_ONE;
+    int32_t remX_ = 0;
+    int32_t remY_ = 0;
+};
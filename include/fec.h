@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "protocol.h"
+
+// --- 前向纠错重组 ---
+// 在接收回调中运行：记住每个发送端最后一个已送出的序号，收到 FEC 帧时先用 history
+// 补出中间缺失的样本（按序号升序），再送出当前样本。重复帧直接丢弃。
+
+constexpr int16_t FEC_RESYNC_WINDOW = 64;  // 序号回退超过该值视为发送端重启
+
+class FecReassembler {
+public:
+    void reset() { synced_ = false; }
+
+    // emit(const QueueItem_t&) 对每个应入队的样本调用一次；返回 false 表示重复帧
+    template <typename Emit>
+    bool accept(const uint8_t mac[6], const MotionFecPacket& packet, Emit&& emit) {
+        if (synced_ && memcmp(mac, mac_, 6) != 0) {
+            synced_ = false; // 换了发送端
+        }
+        int gap = 0;
+        if (synced_) {
+            const int16_t ahead = (int16_t)(uint16_t)(packet.seq - lastSeq_);
+            if (ahead <= 0 && ahead > -FEC_RESYNC_WINDOW) {
+                return false;
+            }
+            if (ahead > 0) {
+                gap = ahead - 1;
+            }
+        }
+
+        QueueItem_t item = {};
+        memcpy(item.mac_addr, mac, 6);
+        item.type = PACKET_TYPE_MOUSE_DATA;
+        item.intervalUs = packet.intervalUs;
+
+        // 只能恢复冗余覆盖到的那部分缺口
+        const int recoverable = gap < packet.redundancy ? gap : packet.redundancy;
+        for (int i = recoverable - 1; i >= 0; i--) {
+            const RedundantSample& h = packet.history[i];
+            item.flags = QUEUE_ITEM_HAS_SEQ | QUEUE_ITEM_RECOVERED;
+            item.seq = (uint16_t)(packet.seq - 1 - i);
+            item.deltaX = h.deltaX;
+            item.deltaY = h.deltaY;
+            item.wheel = h.wheel;
+            item.buttons = h.buttons;
+            emit(item);
+        }
+
+        item.flags = QUEUE_ITEM_HAS_SEQ;
+        item.seq = packet.seq;
+        item.deltaX = packet.deltaX;
+        item.deltaY = packet.deltaY;
+        item.wheel = packet.wheel;
+        item.buttons = packet.buttons;
+        emit(item);
+
+        synced_ = true;
+        lastSeq_ = packet.seq;
+        memcpy(mac_, mac, 6);
+        recovered_ += recoverable;
+        unrecoverable_ += gap - recoverable;
+        return true;
+    }
+
+    uint32_t recovered() const { return recovered_; }
+    uint32_t unrecoverable() const { return unrecoverable_; }
+
+private:
+    uint32_t recovered_ = 0;
+    uint32_t unrecoverable_ = 0;
+    bool synced_ = false;
+    uint16_t lastSeq_ = 0;
+    uint8_t mac_[6] = {};
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "protocol.h"
+
+// --- 明文帧认证 ---
+// 不启用硬件加密的“快速模式”下，发送端在每个运动/心跳帧末尾附加 FRAME_TAG_SIZE 字节的
+// 认证标签：SipHash-2-4(帧密钥, 扩展序号(4, 小端) | 去掉标签的整帧) 的低位截断。
+// 扩展序号 = 32 位发送计数，低 16 位即帧中的 seq（所有带序号的帧都位于偏移 1 处）；
+// 配对后发送端从 0 开始计数。接收端按最近接受的序号推算高 16 位，并用 64 帧的滑动窗口
+// 拒绝重放。键盘帧有独立的序号空间（不能占用运动帧的序号，否则会被当成丢包），单独维护窗口。帧密钥在认证配对时由配对密钥派生（见 link_security.h）。
+
+constexpr size_t FRAME_TAG_SIZE = 4;
+constexpr size_t FRAME_KEY_SIZE = 16;
+constexpr uint32_t FRAME_REPLAY_WINDOW = 64;
+// 接收端 HelloAck 的标签使用的保留扩展序号，发送端据此确认接收端同样持有配对密钥
+constexpr uint32_t FRAME_SEQ_HELLO_ACK = 0xFFFFFFFFu;
+
+uint64_t siphash24(const uint8_t key[FRAME_KEY_SIZE], const uint8_t* data, size_t len);
+
+// 计算 data[0..len) 的标签
+void frameAuthSign(const uint8_t key[FRAME_KEY_SIZE], uint32_t extSeq, const uint8_t* data, size_t len,
+                   uint8_t tag[FRAME_TAG_SIZE]);
+
+// 板上基准测试：不同帧长下验证一帧的周期数
+void benchFrameAuth(uint32_t samples);
+
+// 在接收回调中验证对端的帧。install/clear 在控制任务中调用。
+// 临界区内只复制密钥与序号状态、更新重放窗口；SipHash 在临界区外计算
+class FrameAuthenticator {
+public:
+    void install(const uint8_t mac[6], const uint8_t key[FRAME_KEY_SIZE]);
+    void clear();
+    bool active() const { return active_; }
+
+    // 帧来自已认证的对端、标签正确且不是重放时返回 true；len 包含末尾的标签
+    bool verify(const uint8_t mac[6], const uint8_t* data, size_t len);
+
+    uint32_t forged() const { return forged_; }
+    uint32_t replayed() const { return replayed_; }
+
+private:
+    portMUX_TYPE mux_ = portMUX_INITIALIZER_UNLOCKED;
+    volatile bool active_ = false;
+    uint32_t generation_ = 0;  // 每次 install/clear 加一，验证期间密钥被更换时拒绝该帧
+    uint8_t mac_[6] = {};
+    uint8_t key_[FRAME_KEY_SIZE] = {};
+    // 每个序号空间的重放窗口：0 = 运动/心跳，1 = 键盘
+    struct ReplayWindow {
+        uint32_t highest;    // 已接受的最大扩展序号
+        uint64_t bits;       // 位 i 表示 highest - i 已接受
+        bool started;
+    };
+    ReplayWindow windows_[2] = {};
+
+    static uint32_t extendSeq(const ReplayWindow& w, uint16_t seq);
+    static bool acceptSeq(ReplayWindow& w, uint32_t extSeq);
+    uint32_t forged_ = 0;
+    uint32_t replayed_ = 0;
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cumulative.h"
+#include "fec.h"
+#include "packed_motion.h"
+#include "protocol.h"
+
+// --- 接收帧解析 ---
+// 表驱动的校验解析器：首字节类型直接索引格式表（O(1)，不再逐个格式比较），表项给出该格式的
+// 长度范围、去向和解码函数。先校验长度与字段取值（FEC 冗余数与帧长是否一致、旧格式枚举的
+// 高位字节等），通过后才产生队列项；按键字段中未定义的位一律屏蔽（旧发送端可能置位）。
+// 多字节字段一律用 memcpy 读出，不把接收缓冲强制转换为结构体指针。
+// 帧本身不带版本号：格式由类型字节区分，协议版本在握手时协商（见 handshake.h）。
+// 旧格式 UniversalPacket 仍是最常见的帧，走内联的快速路径：长度与 4 字节类型各比较一次后直接
+// 读出字段，不查表、不经过间接调用。
+
+// 旧格式 UniversalPacket 的 type 是枚举，线上按 4 字节小端整数固定下来，不随编译器变化
+constexpr size_t UNIVERSAL_FRAME_SIZE = 42;
+static_assert(sizeof(UniversalPacket) == UNIVERSAL_FRAME_SIZE, "UniversalPacket 的线上格式变了");
+
+enum FrameRoute : uint8_t {
+    FRAME_DROPPED,   // 未知类型、本端不接收的类型或校验失败
+    FRAME_QUEUED,    // 已解码，产生了 0 个或多个队列项
+    FRAME_CONTROL,   // 握手/认证帧：只校验长度，由调用方转交控制任务
+    FRAME_KEYBOARD,  // 键盘状态帧：只校验长度，由调用方处理
+};
+
+typedef void (*FrameEmit)(const QueueItem_t& item);
+
+// 有状态的解码器（按发送端记住序号、累计值、按键状态）
+struct FrameDecoders {
+    FecReassembler fec;
+    CumulativeDecoder cumulative;
+    PackedMotionDecoder packed;
+};
+
+class FrameParser {
+public:
+    // 只在接收回调（或代替它的回放/仿真/负载测试）中调用；emit 对每个解码出的队列项调用一次
+    FrameRoute parse(const uint8_t mac[6], const uint8_t* data, size_t len, uint32_t arrivalUs, FrameEmit emit) {
+        if (len == UNIVERSAL_FRAME_SIZE) {
+            uint32_t type;
+            memcpy(&type, data, sizeof(type));
+            if (type == PACKET_TYPE_MOUSE_DATA || type == PACKET_TYPE_HEARTBEAT) {
+                decodeUniversal(mac, data, type, arrivalUs, emit);
+                return FRAME_QUEUED;
+            }
+        }
+        return parseTable(mac, data, len, arrivalUs, emit);
+    }
+
+    // 只判断是否为长度合法的控制帧，不解码（在验证帧认证标签之前调用）
+    static bool isControl(const uint8_t* data, size_t len);
+
+    void reset();  // 清空各解码器记住的对端状态
+
+    uint32_t rejected() const { return rejected_; }  // 已知类型但长度或字段非法的帧
+    uint32_t fecRecovered() const { return decoders_.fec.recovered(); }
+    uint32_t fecUnrecoverable() const { return decoders_.fec.unrecoverable(); }
+    uint32_t cumulativeResyncs() const { return decoders_.cumulative.resyncs(); }
+
+private:
+    // 旧格式：type 为 4 字节小端枚举，只接受运动数据与心跳。旧发送端的 buttons 字节可能带有
+    // 未定义的高位（旧接收端按映射表只取已定义的位），这里屏蔽掉而不是丢弃整帧
+    static void decodeUniversal(const uint8_t mac[6], const uint8_t* data, uint32_t type, uint32_t arrivalUs,
+                                FrameEmit emit) {
+        QueueItem_t item = {};
+        memcpy(item.mac_addr, mac, 6);
+        item.type = (PacketType)type;
+        memcpy(&item.deltaX, data + offsetof(UniversalPacket, deltaX), sizeof(item.deltaX));
+        memcpy(&item.deltaY, data + offsetof(UniversalPacket, deltaY), sizeof(item.deltaY));
+        item.wheel = (int8_t)data[offsetof(UniversalPacket, wheel)];
+        item.buttons = data[offsetof(UniversalPacket, buttons)] & ~MOTION_BUTTONS_RESERVED;
+        item.arrivalUs = arrivalUs;
+        emit(item);
+    }
+
+    // 其余格式：按类型查格式表
+    FrameRoute parseTable(const uint8_t mac[6], const uint8_t* data, size_t len, uint32_t arrivalUs, FrameEmit emit);
+
+    FrameDecoders decoders_;
+    uint32_t rejected_ = 0;
+};
+
+// 解析器产生的队列项是否合法：类型只有运动数据/心跳，标志位都已定义，按键没有未定义的位
+bool frameItemIsValid(const QueueItem_t& item);
+
+// 板上变异测试：以各格式的合法帧为种子，随机翻转位、改写字节、截断、延长或改类型后交给
+// 独立的解析器实例，检查产生的队列项都合法；相同种子得到相同的输入序列。
+// 主机上的覆盖率引导模糊测试见 test/fuzz（pio run -e fuzz_parser）
+void fuzzFrameParser(uint32_t iterations, uint32_t seed);
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "protocol.h"
+
+// --- 配对握手与能力协商 ---
+// 发送端收到接收端的发现广播后单播 HelloPacket 声明自身能力；接收端取双方能力的交集，
+// 选出最快的公共运动帧格式，回复 HelloAckPacket 并建立连接。
+// 不支持握手的旧发送端仍然按“首个鼠标数据包即配对”的方式工作。
+
+// 双方能力取交集；握手版本不兼容时返回 false
+bool negotiateLinkMode(const Capabilities& local, const Capabilities& remote, LinkMode& out);
+
+// 未经握手（旧发送端）时使用的链路模式
+LinkMode legacyLinkMode();
+
+const char* motionFormatName(MotionFormat format);
+void printLinkMode(const LinkMode& mode);
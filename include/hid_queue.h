@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Arduino.h>
+#include <USBHID.h>
+
+#include "protocol.h"
+
+// --- HID 接口的待发队列 ---
+// 复合设备的鼠标与键盘是同一个 HID 接口上的两个报告 ID，共用一个 IN 端点，报告都经这里提交：
+// 端点空闲且没有积压时直接交给 TinyUSB（只入队，不等主机取走），否则留在待发队列里，由 flush()
+// 在端点空闲后按提交顺序发出。每个接口一个实例，提交与 flush 都不阻塞，只在 mouseTask 中调用。
+//
+// 鼠标报告是相对量：积压期间，按键不变的新报告把位移并入队尾的纯位移报告；队列满时并入队尾并计为
+// 溢出（中间的按键变化会丢失，只保留最新状态）。键盘报告是全量状态：最多积压一个，新状态直接覆盖
+// 它（位置不变），没发出去的状态一直保留到发出为止，按键不会因为端点忙而卡在主机上。
+//
+// 主机挂起期间积压的鼠标报告丢弃，键盘状态保留到恢复后发出；总线复位或拔出后全部丢弃。
+
+constexpr uint8_t HIRES_BUTTON_ALL = 0x1F;
+constexpr size_t HID_PENDING_REPORTS = 8;
+
+// 鼠标输入报告（HID_REPORT_ID_MOUSE），报告旁路收到的也是这个布局
+#pragma pack(push, 1)
+struct HiResMouseReport {
+    uint8_t buttons;
+    int16_t x;
+    int16_t y;
+    int8_t wheel;
+    int8_t pan;
+};
+#pragma pack(pop)
+
+// 键盘输入报告（HID_REPORT_ID_KEYBOARD）：修饰键字节 + 按键位图
+struct KeyboardReport {
+    uint8_t modifiers;
+    uint8_t keys[KEYBOARD_BITMAP_SIZE];
+};
+
+class HidReportQueue {
+public:
+    explicit HidReportQueue(uint8_t instance) : instance_(instance) {}
+
+    void submitMouse(const HiResMouseReport& report);
+    void submitKeyboard(const KeyboardReport& report);
+
+    // 在端点空闲时发出积压的报告；返回仍积压的个数
+    size_t flush();
+    // 主机挂起：丢弃积压的鼠标报告
+    void dropMouseReports();
+
+    size_t pendingReports() const { return mouseCount_ + (keyboardPending_ ? 1 : 0); }
+    uint8_t sentButtons() const { return sentButtons_; } // 最后一个已交给 TinyUSB 的鼠标报告中的按键
+
+    uint32_t deferredReports() const { return deferred_; } // 端点忙而进入待发队列的报告
+    uint32_t mergedReports() const { return merged_; }     // 并入队尾报告的位移或覆盖的键盘状态
+    uint32_t overruns() const { return overruns_; }        // 队列满时强行合并的鼠标报告
+
+private:
+    bool transmit(uint8_t reportId, const void* report, size_t len) const;
+    void enqueueMouse(const HiResMouseReport& report);
+
+    const uint8_t instance_;
+    HiResMouseReport mouse_[HID_PENDING_REPORTS] = {};
+    size_t mouseHead_ = 0;
+    size_t mouseCount_ = 0;
+    uint8_t sentButtons_ = 0;
+    KeyboardReport keyboard_ = {};
+    bool keyboardPending_ = false;
+    size_t keyboardAfter_ = 0;      // 键盘状态之前还要先发出的鼠标报告个数
+    volatile uint32_t deferred_ = 0;
+    volatile uint32_t merged_ = 0;
+    volatile uint32_t overruns_ = 0;
+};
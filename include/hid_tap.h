@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --- HID 报告旁路 ---
+// 设置后，HiResMouse / NkroKeyboard 发送的每个输入报告先交给旁路函数；
+// 返回 true 时报告不再发往 USB（回放时用，避免移动真实光标）。
+typedef bool (*HidReportTap)(uint8_t reportId, const void* report, size_t len);
+
+inline volatile HidReportTap hidReportTap = NULL;
+
+inline bool hidTapIntercept(uint8_t reportId, const void* report, size_t len) {
+    const HidReportTap tap = hidReportTap;
+    return tap != NULL && tap(reportId, report, len);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Arduino.h>
+#include <USBHID.h>
+
+#include "hid_queue.h"
+#include "protocol.h"
+
+// --- 高分辨率鼠标 ---
+// 取代 USBHIDMouse：X/Y 为 16 位，带垂直滚轮与水平滚动（AC Pan），两者各有一个
+// Resolution Multiplier 特性报告。主机（Windows/Linux）启用倍率后，滚动以 1/120 格为单位上报；
+// 未启用时按整格上报，不足一格的部分保留到下次。
+// move() 的滚动参数总是 1/120 格（SCROLL_UNITS_PER_DETENT），换算在设备内部完成。
+//
+// 报告提交不阻塞：经所在 HID 接口的待发队列（HidReportQueue，与键盘共用）交给 TinyUSB，端点忙时
+// 留在队列中由 mouseTask 稍后发出（库自带的 SendReport 会等到主机取走报告，主机慢或挂起时最多阻塞 100ms）。
+//
+// 主机挂起期间不提交报告（积压的报告也丢弃）。新按下的按键，或 250ms 内累计超过唤醒阈值的移动，
+// 会请求 USB 远程唤醒（主机允许时才生效）；唤醒动作本身不会送到主机。
+
+class HiResMouse : public USBHIDDevice {
+public:
+    explicit HiResMouse(HidReportQueue& queue);
+    void begin();
+
+    void move(int16_t x, int16_t y, int16_t scroll = 0, int16_t pan = 0);
+    // 一次提交一个样本的全部状态（位移、滚动、按键），至多发送一个报告。没有可上报的位移/滚动
+    // 且按键与上次发给主机的报告相同时不发送并返回 false；force 时总是发送（保活）。
+    // 主机挂起、报告被丢弃时也返回 false，按键状态不记为已发送。
+    bool report(int16_t x, int16_t y, int16_t scroll, int16_t pan, uint8_t buttons, bool force = false);
+    void press(uint8_t buttons);
+    void release(uint8_t buttons);
+    bool isPressed(uint8_t buttons) const { return (buttons_ & buttons) != 0; }
+
+    // 挂起期间 250ms 内累计移动（|x|+|y|）达到该计数时请求远程唤醒，0 表示只由按键唤醒
+    void setRemoteWakeMotion(uint16_t counts) { wakeMotion_ = counts; }
+    uint32_t wakeRequests() const { return wakeRequests_; } // 已发出的远程唤醒请求
+
+    bool wheelHiRes() const { return wheelHiRes_; }
+    bool panHiRes() const { return panHiRes_; }
+
+    uint16_t _onGetDescriptor(uint8_t* buffer) override;
+    uint16_t _onGetFeature(uint8_t reportId, uint8_t* buffer, uint16_t len) override;
+    void _onSetFeature(uint8_t reportId, const uint8_t* buffer, uint16_t len) override;
+
+private:
+    bool send(uint8_t buttons, int16_t x, int16_t y, int8_t wheel, int8_t pan);
+    void requestWakeIfNeeded(const HiResMouseReport& report);
+    static int8_t takeScroll(int32_t& remainder, bool hiRes);
+
+    USBHID hid_;
+    HidReportQueue& queue_;
+    uint8_t buttons_ = 0;          // 上次送出（已入队）的报告中的按键状态
+    int32_t scrollRemainder_ = 0; // 1/120 格
+    int32_t panRemainder_ = 0;
+    volatile bool wheelHiRes_ = false;
+    volatile bool panHiRes_ = false;
+
+    uint16_t wakeMotion_ = 0;
+    uint32_t suspendMotion_ = 0;       // 当前窗口内累计的移动
+    uint32_t suspendMotionStartUs_ = 0;
+    uint32_t lastWakeRequestUs_ = 0;
+    volatile uint32_t wakeRequests_ = 0;
+};
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "protocol.h"
+
+// --- 自适应抖动缓冲与发送端时钟同步 ---
+// ClockSync 用带发送端时间戳的帧（心跳与定时运动帧）估计 接收时间 - 发送时间 的偏移与漂移：
+// 每个统计周期取单向时延的最小值作为锚点（排队时延为 0 的那一帧），相邻锚点的斜率即时钟漂移。
+// JitterBuffer 把每个样本映射到接收端时间轴，再加上一个自适应的播放延迟，按发送端原始节奏
+// 依次放出。播放延迟 = 抖动估计 * 倍数，限制在 [minDelayUs, maxDelayUs] 内。
+// 偏移估计被更快到达的帧下调、播放延迟缩小时，后到样本算出的播放时间可能早于先到的样本，
+// 因此缓冲按发送时间排序，播放时间不早于前一项：样本总是按发送顺序放出。
+
+constexpr size_t JITTER_BUFFER_CAPACITY = 16;
+constexpr uint32_t CLOCK_SYNC_EPOCH_US = 500000;  // 每 0.5 秒更新一次锚点与漂移
+constexpr int CLOCK_DRIFT_SHIFT = 24;             // 漂移 Q24（相对速率）
+
+struct JitterBufferParams {
+    bool enabled;
+    uint16_t minDelayUs;
+    uint16_t maxDelayUs;
+    uint8_t jitterMultiplier;  // 播放延迟 = 抖动估计 * 该倍数
+};
+
+class ClockSync {
+public:
+    void reset() {
+        synced_ = false;
+        epochValid_ = false;
+        driftQ24_ = 0;
+    }
+
+    // 记录一对（发送时间, 到达时间）
+    void observe(uint32_t senderUs, uint32_t arrivalUs) {
+        const int32_t delay = (int32_t)(arrivalUs - senderUs);
+        if (!synced_) {
+            synced_ = true;
+            anchorSenderUs_ = senderUs;
+            anchorOffset_ = delay;
+            startEpoch(senderUs, delay);
+            return;
+        }
+
+        // 比当前模型更快到达的帧说明偏移估计偏大，立即下调，保证“超出最小时延的部分”非负
+        const int32_t predicted = offsetAt(senderUs);
+        if (delay < predicted) {
+            anchorOffset_ += delay - predicted;
+        }
+
+        if (delay < epochMinDelay_) {
+            epochMinDelay_ = delay;
+            epochMinSenderUs_ = senderUs;
+        }
+        if (senderUs - epochStartUs_ >= CLOCK_SYNC_EPOCH_US) {
+            closeEpoch();
+            startEpoch(senderUs, delay);
+        }
+    }
+
+    bool synced() const { return synced_; }
+
+    // 发送端时间 -> 接收端时间（按最小时延对齐）
+    uint32_t toLocal(uint32_t senderUs) const { return senderUs + (uint32_t)offsetAt(senderUs); }
+
+    int32_t offsetUs() const { return anchorOffset_; }
+    int32_t driftPpm() const { return (int32_t)(((int64_t)driftQ24_ * 1000000) >> CLOCK_DRIFT_SHIFT); }
+
+private:
+    int32_t offsetAt(uint32_t senderUs) const {
+        const int32_t elapsed = (int32_t)(senderUs - anchorSenderUs_);
+        return anchorOffset_ + (int32_t)(((int64_t)elapsed * driftQ24_) >> CLOCK_DRIFT_SHIFT);
+    }
+
+    void startEpoch(uint32_t senderUs, int32_t delay) {
+        epochStartUs_ = senderUs;
+        epochMinDelay_ = delay;
+        epochMinSenderUs_ = senderUs;
+    }
+
+    void closeEpoch() {
+        if (epochValid_) {
+            const int32_t span = (int32_t)(epochMinSenderUs_ - lastMinSenderUs_);
+            if (span > 0) {
+                const int64_t slope = ((int64_t)(epochMinDelay_ - lastMinDelay_) << CLOCK_DRIFT_SHIFT) / span;
+                driftQ24_ += (int32_t)((slope - driftQ24_) / 4);  // 平滑，避免单个周期的噪声
+            }
+        }
+        epochValid_ = true;
+        lastMinDelay_ = epochMinDelay_;
+        lastMinSenderUs_ = epochMinSenderUs_;
+        anchorSenderUs_ = epochMinSenderUs_;
+        anchorOffset_ = epochMinDelay_;
+    }
+
+    bool synced_ = false;
+    bool epochValid_ = false;
+    uint32_t anchorSenderUs_ = 0;
+    int32_t anchorOffset_ = 0;
+    int32_t driftQ24_ = 0;
+    uint32_t epochStartUs_ = 0;
+    int32_t epochMinDelay_ = 0;
+    uint32_t epochMinSenderUs_ = 0;
+    int32_t lastMinDelay_ = 0;
+    uint32_t lastMinSenderUs_ = 0;
+};
+
+class JitterBuffer {
+public:
+    void setParams(const JitterBufferParams& params) {
+        params_ = params;
+        reset();
+    }
+
+    void reset() {
+        clock_.reset();
+        count_ = 0;
+        jitterQ4_ = 0;
+        playoutUs_ = params_.minDelayUs;
+    }
+
+    bool enabled() const { return params_.enabled; }
+
+    // 带时间戳的心跳只参与时钟同步
+    void observeClock(const QueueItem_t& item) {
+        if (item.flags & QUEUE_ITEM_HAS_TIMESTAMP) {
+            clock_.observe(item.senderTimeUs, item.arrivalUs);
+        }
+    }
+
+    // 放入一个带时间戳的样本。缓冲已满时提前放出发送时间最早的一项（可能就是新样本）写入
+    // evicted 并返回 true，调用方应立即处理它，样本之间的先后顺序不变
+    bool push(const QueueItem_t& item, QueueItem_t& evicted) {
+        clock_.observe(item.senderTimeUs, item.arrivalUs);
+
+        // 抖动估计：超出最小时延部分的平滑平均（RFC 3550 的 1/16 增益）
+        const uint32_t nominal = clock_.toLocal(item.senderTimeUs);
+        const int32_t excess = (int32_t)(item.arrivalUs - nominal);
+        jitterQ4_ += (excess < 0 ? -excess : excess) - (jitterQ4_ >> 4);
+        adaptPlayout();
+
+        const uint32_t playAt = nominal + playoutUs_;
+        bool overflow = false;
+        if (count_ >= JITTER_BUFFER_CAPACITY) {
+            overflows_++;
+            if (sentBefore(item, entries_[0].item)) {
+                evicted = item;
+                return true;
+            }
+            evicted = entries_[0].item;
+            removeFront();
+            overflow = true;
+        }
+
+        // 按发送时间插入（通常就是追加到末尾），再把其后各项的播放时间推到不早于前一项
+        size_t pos = count_;
+        while (pos > 0 && sentBefore(item, entries_[pos - 1].item)) {
+            entries_[pos] = entries_[pos - 1];
+            pos--;
+        }
+        entries_[pos].item = item;
+        entries_[pos].playAtUs = playAt;
+        count_++;
+        for (size_t i = pos > 0 ? pos : 1; i < count_; i++) {
+            if ((int32_t)(entries_[i].playAtUs - entries_[i - 1].playAtUs) < 0) {
+                entries_[i].playAtUs = entries_[i - 1].playAtUs;
+            }
+        }
+        return overflow;
+    }
+
+    // 取出一个已到播放时间的样本
+    bool popDue(uint32_t nowUs, QueueItem_t& item) {
+        if (count_ == 0 || (int32_t)(nowUs - entries_[0].playAtUs) < 0) {
+            return false;
+        }
+        // 到达时已经错过播放时间的样本计为迟到
+        if ((int32_t)(entries_[0].item.arrivalUs - entries_[0].playAtUs) > 0) {
+            late_++;
+        }
+        item = entries_[0].item;
+        removeFront();
+        return true;
+    }
+
+    // 下一个样本的播放时间；缓冲为空时返回 false
+    bool nextPlayAt(uint32_t& playAtUs) const {
+        if (count_ == 0) {
+            return false;
+        }
+        playAtUs = entries_[0].playAtUs;
+        return true;
+    }
+
+    uint32_t playoutDelayUs() const { return playoutUs_; }
+    uint32_t jitterUs() const { return (uint32_t)(jitterQ4_ >> 4); }
+    uint32_t lateCount() const { return late_; }
+    uint32_t overflowCount() const { return overflows_; }
+    const ClockSync& clock() const { return clock_; }
+
+private:
+    struct Entry {
+        QueueItem_t item;
+        uint32_t playAtUs;
+    };
+
+    static bool sentBefore(const QueueItem_t& a, const QueueItem_t& b) {
+        return (int32_t)(a.senderTimeUs - b.senderTimeUs) < 0;
+    }
+
+    void removeFront() {
+        count_--;
+        for (size_t i = 0; i < count_; i++) {
+            entries_[i] = entries_[i + 1];
+        }
+    }
+
+    // 目标延迟随抖动变化；增大立即生效，减小缓慢进行，避免节奏来回跳动
+    void adaptPlayout() {
+        uint32_t target = (uint32_t)((jitterQ4_ >> 4) * params_.jitterMultiplier);
+        if (target < params_.minDelayUs) target = params_.minDelayUs;
+        if (target > params_.maxDelayUs) target = params_.maxDelayUs;
+        if (target > playoutUs_) {
+            playoutUs_ = target;
+        } else {
+            playoutUs_ -= (playoutUs_ - target) / 16;
+        }
+    }
+
+    JitterBufferParams params_ = {};
+    ClockSync clock_;
+    Entry entries_[JITTER_BUFFER_CAPACITY] = {};
+    size_t count_ = 0;
+    int32_t jitterQ4_ = 0;
+    uint32_t playoutUs_ = 0;
+    uint32_t late_ = 0;
+    uint32_t overflows_ = 0;
+};
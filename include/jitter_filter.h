@@ -0,0 +1,117 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- 自适应抖动滤波（One Euro）---
+// 截止频率随速度升高：fc = minCutoff + beta * speed。静止时强力平滑 ±1 的传感器噪声，
+// 高速时系数达到 1.0，输出与输入完全一致，不引入任何延迟。
+// 平滑系数按速度预先算成 Q15 查找表，逐样本只有定点运算和一次查表。
+
+constexpr int JITTER_ALPHA_SHIFT = 15;
+constexpr int32_t JITTER_ALPHA_ONE = 1 << JITTER_ALPHA_SHIFT;
+constexpr int JITTER_POS_SHIFT = 8;          // 位置残差的定点精度（Q8）
+constexpr size_t JITTER_LUT_SIZE = 64;       // 速度单位：计数/样本
+constexpr float JITTER_ALPHA_SNAP = 0.97f;   // 系数超过该值时直接取 1.0，保证高速零滞后
+
+struct JitterFilterParams {
+    bool enabled;
+    float minCutoffHz;     // 静止时的截止频率，越低越平滑
+    float beta;            // 截止频率随速度增长的斜率
+    float derivCutoffHz;   // 速度估计的截止频率
+    float samplePeriodMs;  // 发送端的标称采样周期
+};
+
+struct JitterFilterTables {
+    uint16_t alpha[JITTER_LUT_SIZE];  // 位置平滑系数，Q15
+    uint16_t derivAlpha;              // 速度平滑系数，Q15
+};
+
+bool buildJitterFilterTables(const JitterFilterParams& params, JitterFilterTables& out);
+void printJitterFilterParams(const JitterFilterParams& params);
+
+// 板上基准测试：合成“静止噪声 + 匀速移动”轨迹，比较滤波前后的报告数与附加延迟
+void benchJitterFilter(const JitterFilterTables& tables, uint32_t samples);
+
+class JitterFilter {
+public:
+    void setTables(const JitterFilterTables& tables) {
+        tables_ = tables;
+        reset();
+    }
+
+    void reset() {
+        speedQ8_ = 0;
+        resX_ = resY_ = 0;
+        fracX_ = fracY_ = 0;
+    }
+
+    void apply(int16_t& dx, int16_t& dy) {
+        // 速度估计：对每样本位移长度做一阶低通
+        const int32_t ax = dx < 0 ? -dx : dx;
+        const int32_t ay = dy < 0 ? -dy : dy;
+        const int32_t rawSpeedQ8 = (ax > ay ? ax + (ay >> 1) : ay + (ax >> 1)) << JITTER_POS_SHIFT;
+        speedQ8_ += (int32_t)(((int64_t)(rawSpeedQ8 - speedQ8_) * tables_.derivAlpha) >> JITTER_ALPHA_SHIFT);
+
+        uint32_t idx = (uint32_t)speedQ8_ >> JITTER_POS_SHIFT;
+        if (idx >= JITTER_LUT_SIZE) {
+            idx = JITTER_LUT_SIZE - 1;
+        }
+        const int32_t alpha = tables_.alpha[idx];
+        dx = filterAxis(dx, alpha, resX_, fracX_);
+        dy = filterAxis(dy, alpha, resY_, fracY_);
+    }
+
+private:
+    // res 为 原始位置 - 滤波位置（Q8）；滤波位置每步前进 alpha * res，整数部分输出，小数部分留到下次
+    static int16_t filterAxis(int32_t d, int32_t alpha, int32_t& res, int32_t& frac) {
+        res += d << JITTER_POS_SHIFT;
+        const int32_t step = alpha >= JITTER_ALPHA_ONE ? res : (int32_t)(((int64_t)res * alpha) >> JITTER_ALPHA_SHIFT);
+        res -= step;
+        const int32_t acc = frac + step;
+        const int32_t out = acc >> JITTER_POS_SHIFT;
+        frac = acc - (out << JITTER_POS_SHIFT);
+        if (out > INT16_MAX) return INT16_MAX;
+        if (out < INT16_MIN) return INT16_MIN;
+        return (int16_t)out;
+    }
+
+    JitterFilterTables tables_ = {};
+    int32_t speedQ8_ = 0;
+    int32_t resX_ = 0, resY_ = 0;
+    int32_t fracX_ = 0, fracY_ = 0;
+};
+
+constexpr size_t JITTER_EVAL_HISTORY = 128;  // 查找附加延迟时回看的原始样本数
+
+// 离线评估：逐样本送入一段轨迹（位移与发送端时刻），统计滤波后的报告数与附加延迟。
+// 附加延迟只在移动的样本上计算：在最近 JITTER_EVAL_HISTORY 个原始位置中找离当前滤波位置最近的一个，
+// 取两者的时刻差。板上基准（合成轨迹）与主机基准（回放的捕获，test/bench）共用。
+class JitterFilterEvaluator {
+public:
+    explicit JitterFilterEvaluator(const JitterFilterTables& tables);
+
+    void add(int16_t dx, int16_t dy, uint32_t atUs);
+
+    uint32_t samples() const { return samples_; }
+    uint32_t rawReports() const { return rawReports_; }  // 原始位移非零的样本数
+    uint32_t reports() const { return reports_; }        // 滤波后位移非零的样本数
+    uint32_t movingSamples() const { return moving_; }
+    float meanLatencyUs() const { return moving_ ? (float)latencySumUs_ / moving_ : 0.0f; }
+    uint32_t maxLatencyUs() const { return maxLatencyUs_; }
+    float cyclesPerSample() const { return samples_ ? (float)cycles_ / samples_ : 0.0f; }
+
+private:
+    JitterFilter filter_;
+    int32_t rawX_[JITTER_EVAL_HISTORY] = {};
+    int32_t rawY_[JITTER_EVAL_HISTORY] = {};
+    uint32_t atUs_[JITTER_EVAL_HISTORY] = {};
+    int32_t outX_ = 0, outY_ = 0;
+    uint32_t samples_ = 0;
+    uint32_t rawReports_ = 0;
+    uint32_t reports_ = 0;
+    uint32_t moving_ = 0;
+    uint64_t latencySumUs_ = 0;
+    uint32_t maxLatencyUs_ = 0;
+    uint64_t cycles_ = 0;
+};
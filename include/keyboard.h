@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Arduino.h>
+#include <USBHID.h>
+
+#include "hid_queue.h"
+#include "protocol.h"
+
+// --- 全键无冲键盘 ---
+// 与 HiResMouse 共用同一个 HID 接口（复合设备），各自使用独立的报告 ID。
+// 输入报告为修饰键字节 + 用途 0x00~0x77 的位图，任意数量的按键可以同时按下。
+// 位图报告不兼容 BIOS 的启动协议，仅在操作系统下可用。
+// 报告经 HID 接口的待发队列（与鼠标共用）提交，不阻塞；端点忙时最新状态留在队列里重试。
+
+class NkroKeyboard : public USBHIDDevice {
+public:
+    explicit NkroKeyboard(HidReportQueue& queue);
+    void begin();
+
+    void sendReport(const KeyboardReport& report);
+    uint8_t leds() const { return leds_; } // 主机下发的指示灯状态（NumLock/CapsLock/...）
+
+    uint16_t _onGetDescriptor(uint8_t* buffer) override;
+    void _onOutput(uint8_t reportId, const uint8_t* buffer, uint16_t len) override;
+
+private:
+    USBHID hid_;
+    HidReportQueue& queue_;
+    volatile uint8_t leds_ = 0;
+};
+
+// 在 mouseTask 中运行：按序号丢弃过期帧，与当前状态比较，只在按键变化时发送报告
+class KeyboardRelay {
+public:
+    explicit KeyboardRelay(NkroKeyboard& keyboard) : keyboard_(keyboard) {}
+
+    // 新连接或连接断开时调用：松开所有按键，重新接受任意序号
+    void reset();
+    void apply(const KeyboardPacket& packet);
+    bool anyPressed() const;
+
+    uint32_t reports() const { return reports_; }
+    uint32_t keyChanges() const { return keyChanges_; }
+    uint32_t staleFrames() const { return staleFrames_; }
+
+private:
+    NkroKeyboard& keyboard_;
+    KeyboardReport state_ = {};
+    bool seqValid_ = false;
+    uint16_t lastSeq_ = 0;
+    uint32_t reports_ = 0;
+    uint32_t keyChanges_ = 0;
+    uint32_t staleFrames_ = 0;
+};
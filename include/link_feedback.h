@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "protocol.h"
+
+// --- 反向控制通道：链路质量反馈 ---
+// 接收端周期性地向已配对的发送端单播 LinkFeedbackPacket，报告丢包率、RSSI、队列深度和
+// 主机侧 HID 发送情况，并给出建议的报告周期。发送端据此调整报告速率、批量与发射功率：
+// 链路干净时提速，接收端拥塞时退避。只发给握手中声明了 CAP_FEEDBACK 的发送端。
+
+// 丢包率与 RSSI 统计。observe* 在 Wi-Fi 任务中调用，takeSnapshot 在控制任务中调用。
+class LinkQualityMonitor {
+public:
+    struct Snapshot {
+        uint32_t expected;   // 按序号应收到的帧数
+        uint32_t received;   // 实际收到的帧数
+        int8_t rssi;         // 平滑后的 RSSI（dBm），无数据时为 0
+        uint8_t queuePeak;   // 周期内鼠标队列的峰值深度
+    };
+
+    // 跟踪新的发送端，清空统计
+    void setPeer(const uint8_t mac[6]);
+    void clearPeer();
+
+    void observeSequence(const uint8_t mac[6], uint16_t seq);
+    void observeRssi(const uint8_t mac[6], int8_t rssi);
+    void observeQueueDepth(uint8_t depth);
+
+    // 取出本周期的统计并开始新周期
+    Snapshot takeSnapshot();
+
+private:
+    bool matches(const uint8_t mac[6]) const { return active_ && memcmp(mac, mac_, 6) == 0; }
+
+    portMUX_TYPE mux_ = portMUX_INITIALIZER_UNLOCKED;
+    bool active_ = false;
+    uint8_t mac_[6] = {};
+    bool seqValid_ = false;
+    uint16_t lastSeq_ = 0;
+    uint32_t expected_ = 0;
+    uint32_t received_ = 0;
+    int32_t rssiQ4_ = 0;       // RSSI * 16，1/8 增益平滑
+    bool rssiValid_ = false;
+    uint8_t queuePeak_ = 0;
+};
+
+struct FeedbackInputs {
+    LinkQualityMonitor::Snapshot link;
+    uint8_t queueCapacity;
+    uint32_t queueDrops;      // 周期内队列满丢弃的帧数
+    uint32_t hidReports;      // 周期内发给主机的 HID 报告数
+    uint32_t hidBusyUs;       // 周期内 HID 发送累计耗时
+    uint32_t periodMs;
+    uint16_t currentIntervalUs;
+    uint16_t minIntervalUs;   // 协商出的最短周期
+    bool hostSuspended;       // USB 主机已挂起
+    uint16_t suspendedIntervalUs; // 挂起期间建议的周期
+};
+
+// 由统计生成反馈帧（含拥塞判定与建议周期）
+void buildLinkFeedback(const FeedbackInputs& in, uint16_t seq, LinkFeedbackPacket& out);
+
+// 开启混杂模式接收回调以获取 ESP-NOW 帧的 RSSI（接收回调本身不带 RSSI）
+bool startRssiMonitor(LinkQualityMonitor* monitor);
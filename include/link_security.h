@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "protocol.h"
+
+// --- 链路安全 ---
+// 配对密钥（32 字节，双方预先共享）存放在 NVS。由它派生：
+//   PMK = HMAC-SHA256(配对密钥, "CYP1")[0..15]，开机时交给 esp_now_set_pmk
+//   认证码 = HMAC-SHA256(配对密钥, "CYA1" | 发送端MAC | 接收端MAC | 接收端随机数 | 发送端随机数)[0..15]
+//   LMK    = HMAC-SHA256(配对密钥, "CYK1" | 发送端MAC | 接收端MAC | 接收端随机数 | 发送端随机数)[0..15]
+// 每次配对的随机数都不同，因此每条连接使用不同的 LMK，旧的认证应答无法重放。
+// 对端以加密方式注册后，ESP-NOW 会丢弃该 MAC 发来的明文帧，伪造源地址的注入帧无法通过。
+
+constexpr size_t PAIRING_KEY_SIZE = 32;
+constexpr size_t LINK_KEY_SIZE = 16;            // 与 ESP_NOW_KEY_LEN 一致
+constexpr uint32_t AUTH_TIMEOUT_MS = 1000;      // 挑战发出后等待应答的时限
+
+struct PairingKey {
+    bool valid;
+    uint8_t key[PAIRING_KEY_SIZE];
+};
+
+// 解析 64 个十六进制字符
+bool pairingKeyFromHex(const char* hex, PairingKey& out);
+bool pairingKeyLoad(PairingKey& key);
+bool pairingKeySave(const PairingKey& key);
+bool pairingKeyErase();
+
+void derivePrimaryMasterKey(const PairingKey& key, uint8_t pmk[LINK_KEY_SIZE]);
+void computeAuthTag(const PairingKey& key, const uint8_t senderMac[6], const uint8_t receiverMac[6],
+                    const uint8_t receiverNonce[AUTH_NONCE_SIZE], const uint8_t senderNonce[AUTH_NONCE_SIZE],
+                    uint8_t tag[AUTH_TAG_SIZE]);
+void deriveLinkKey(const PairingKey& key, const uint8_t senderMac[6], const uint8_t receiverMac[6],
+                   const uint8_t receiverNonce[AUTH_NONCE_SIZE], const uint8_t senderNonce[AUTH_NONCE_SIZE],
+                   uint8_t lmk[LINK_KEY_SIZE]);
+
+// 快速模式下明文帧认证标签使用的密钥：标签 "CYT1"，输入同 LMK
+void deriveFrameKey(const PairingKey& key, const uint8_t senderMac[6], const uint8_t receiverMac[6],
+                    const uint8_t receiverNonce[AUTH_NONCE_SIZE], const uint8_t senderNonce[AUTH_NONCE_SIZE],
+                    uint8_t frameKey[LINK_KEY_SIZE]);
+
+// 与数据无关的恒定时间比较
+bool authTagEqual(const uint8_t a[AUTH_TAG_SIZE], const uint8_t b[AUTH_TAG_SIZE]);
+
+// 对已注册的对端交替以明文和加密方式发送测速帧，比较发送完成延迟与吞吐。
+// lmk 为 NULL 时使用临时随机密钥（对端无法解密，但空口应答照常，延迟仍然可比）。
+// 测试结束后恢复对端原来的注册信息；测试期间该对端的正常数据帧可能被丢弃。
+void benchLinkCrypto(const uint8_t mac[6], const uint8_t* lmk, uint32_t frames, size_t bytes);
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "packed_motion.h"
+#include "protocol.h"
+
+// --- 有损链路仿真 ---
+// 用可复现的随机序列模拟无线链路：Gilbert–Elliott 两状态突发丢包、固定延迟 + 均匀抖动、
+// 按概率重复和额外延迟（制造乱序）。配合合成发送端产生的运动帧，在板上驱动真实的接收路径，
+// 比较不同算法/参数在同一丢包序列下的表现。相同的场景、种子和格式总是得到相同的信道决策。
+
+struct LinkSimParams {
+    float pGoodToBad;        // 每帧从好状态进入坏状态的概率
+    float pBadToGood;        // 每帧从坏状态回到好状态的概率（平均突发长度 = 1/pBadToGood）
+    float lossGood;          // 好状态下的丢包率
+    float lossBad;           // 坏状态下的丢包率
+    uint32_t latencyUs;      // 固定单程延迟
+    uint32_t jitterUs;       // 附加均匀抖动的上限
+    float duplicate;         // 重复送达的概率
+    float reorder;           // 额外延迟的概率，延迟后的帧会晚于后续帧送达
+    uint32_t reorderDelayUs; // 额外延迟
+};
+
+struct LinkSimScenario {
+    const char* name;
+    const char* description;
+    LinkSimParams params;
+};
+
+extern const LinkSimScenario kLinkSimScenarios[];
+extern const size_t kLinkSimScenarioCount;
+
+const LinkSimScenario* linkSimFindScenario(const char* name);
+// 解析 "键=值" 形式的参数覆盖（pgb/pbg/lossg/lossb/latency/jitter/dup/reorder/delay）
+bool linkSimParseOverride(LinkSimParams& params, const char* token);
+void linkSimPrintParams(const LinkSimParams& params);
+
+// xorshift32：种子相同则序列相同
+class SimRandom {
+public:
+    void seed(uint32_t value) { state_ = value ? value : 0x9E3779B9u; }
+    uint32_t next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 17;
+        state_ ^= state_ << 5;
+        return state_;
+    }
+    // [0, 1)
+    float uniform() { return (next() >> 8) * (1.0f / 16777216.0f); }
+    bool chance(float p) { return p > 0.0f && uniform() < p; }
+
+private:
+    uint32_t state_ = 0x9E3779B9u;
+};
+
+class LinkSimChannel {
+public:
+    void reset(const LinkSimParams& params, uint32_t seed);
+
+    // 发送一帧：返回送达份数（0 = 丢失，2 = 重复），各份的送达时间写入 deliverUs
+    uint8_t transmit(uint32_t sendUs, uint32_t deliverUs[2]);
+
+    uint32_t sent() const { return sent_; }
+    uint32_t lost() const { return lost_; }
+    uint32_t duplicated() const { return duplicated_; }
+    uint32_t longestBurst() const { return longestBurst_; }
+
+private:
+    uint32_t deliveryTime(uint32_t sendUs);
+
+    LinkSimParams params_ = {};
+    SimRandom random_;
+    bool bad_ = false;
+    uint32_t sent_ = 0;
+    uint32_t lost_ = 0;
+    uint32_t duplicated_ = 0;
+    uint32_t burst_ = 0;
+    uint32_t longestBurst_ = 0;
+};
+
+// --- 合成发送端 ---
+// 按固定节奏重复“运动段 + 停顿段”：运动段内每 SIM_INTERVAL_US 一个样本，沿每段不同的方向
+// 平滑加速再减速；停顿段内只发心跳。每个停顿段结束时产生一个检查点事件，此时在途的帧都已
+// 送达，记录下的光标位置可以在两次仿真之间逐点比较。轨迹与种子无关。
+
+enum SimFormat : uint8_t {
+    SIM_FORMAT_MOTION,     // MotionPacket
+    SIM_FORMAT_FEC,        // MotionFecPacket，冗余 SIM_FEC_REDUNDANCY 个样本
+    SIM_FORMAT_CUMULATIVE, // CumulativeMotionPacket
+    SIM_FORMAT_PACKED,     // 压缩帧，每帧 SIM_PACKED_BATCH 个样本
+};
+
+bool simFormatFromName(const char* name, SimFormat& format);
+const char* simFormatName(SimFormat format);
+
+constexpr uint16_t SIM_INTERVAL_US = 1000;
+constexpr uint32_t SIM_MOTION_US = 300000;
+constexpr uint32_t SIM_PAUSE_US = 200000;
+constexpr uint32_t SIM_HEARTBEAT_US = 100000;
+constexpr uint8_t SIM_FEC_REDUNDANCY = 2;
+constexpr uint8_t SIM_PACKED_BATCH = 4;
+constexpr size_t SIM_MAX_FRAME = 96;
+
+enum : uint8_t {
+    SIM_EVENT_FRAME,
+    SIM_EVENT_CHECKPOINT,
+};
+
+struct SimEvent {
+    uint32_t atUs; // 相对仿真开始的时间
+    uint8_t kind;
+    uint8_t len;
+    uint8_t data[SIM_MAX_FRAME];
+};
+
+class SimTrafficSource {
+public:
+    // 时长向上取整到完整的运动 + 停顿段
+    void reset(SimFormat format, uint32_t durationUs);
+    bool done() const { return !hasPending_; }
+    uint32_t nextAtUs() const { return pending_.atUs; }
+    void take(SimEvent& event);
+
+    int32_t truthX() const { return truthX_; }
+    int32_t truthY() const { return truthY_; }
+
+private:
+    void prepare();
+    void sample(int16_t& dx, int16_t& dy);
+    void encodeSample(uint32_t atUs, int16_t dx, int16_t dy, bool lastInSegment);
+
+    SimFormat format_ = SIM_FORMAT_MOTION;
+    uint32_t segments_ = 0;
+    uint32_t segment_ = 0;
+    uint32_t step_ = 0;
+    uint16_t seq_ = 0;
+    int32_t segX_ = 0, segY_ = 0;      // 本段内已发出的位移
+    int32_t truthX_ = 0, truthY_ = 0;  // 全部已发出的位移
+    RedundantSample history_[FEC_MAX_REDUNDANCY] = {};
+    uint8_t historyCount_ = 0;
+    uint32_t totalX_ = 0, totalY_ = 0;
+    PackedSample batch_[SIM_PACKED_BATCH] = {};
+    uint8_t batchCount_ = 0;
+    uint8_t lastButtons_ = 0;
+    SimEvent pending_ = {};
+    bool hasPending_ = false;
+};
+
+// --- 在途帧 ---
+// 按送达时间排序的小顶堆；满时新帧按丢失处理
+
+constexpr size_t SIM_IN_FLIGHT_CAPACITY = 64;
+
+struct SimDelivery {
+    uint32_t deliverUs;
+    uint32_t sendUs;
+    uint8_t len;
+    uint8_t data[SIM_MAX_FRAME];
+};
+
+class SimDeliveryQueue {
+public:
+    void clear() { size_ = 0; overflows_ = 0; }
+    void push(uint32_t deliverUs, uint32_t sendUs, const uint8_t* data, uint8_t len);
+    size_t size() const { return size_; }
+    const SimDelivery& top() const { return heap_[0]; }
+    void pop();
+    uint32_t overflows() const { return overflows_; }
+
+private:
+    static bool earlier(const SimDelivery& a, const SimDelivery& b) {
+        return (int32_t)(a.deliverUs - b.deliverUs) < 0;
+    }
+
+    SimDelivery heap_[SIM_IN_FLIGHT_CAPACITY];
+    size_t size_ = 0;
+    uint32_t overflows_ = 0;
+};
+
+// --- 延迟分布 ---
+// 100us 一档的直方图，超出范围的计入最后一档
+
+constexpr uint32_t LATENCY_BUCKET_US = 100;
+constexpr size_t LATENCY_BUCKETS = 256;
+
+class LatencyHistogram {
+public:
+    void reset();
+    void add(uint32_t us);
+    uint32_t count() const { return count_; }
+    uint32_t maxUs() const { return max_; }
+    // 返回第 percent% 个样本所在档的上界，不超过记录到的最大值
+    uint32_t percentileUs(uint8_t percent) const;
+
+private:
+    uint32_t buckets_[LATENCY_BUCKETS] = {};
+    uint32_t count_ = 0;
+    uint32_t max_ = 0;
+};
+
+// --- 仿真结果 ---
+// 先以无损信道跑一遍作为参照，再以所选场景跑一遍，在每个检查点比较两遍的光标位置。
+// 固件的 sim 命令（真实时间）与主机仿真（sim_runner.h，虚拟时间）输出同样的统计。
+
+constexpr uint8_t SIM_PEER_MAC[6] = {0x02, 'C', 'Y', 'S', 'I', 'M'}; // 本地管理地址，不会与真实发送端重复
+constexpr uint32_t SIM_MAX_SECONDS = 60;
+constexpr size_t SIM_MAX_CHECKPOINTS = SIM_MAX_SECONDS * 1000000 / (SIM_MOTION_US + SIM_PAUSE_US) + 1;
+constexpr uint32_t SIM_SETTLE_MS = 50; // 最后一帧送达后留给管线收尾（外推等）的时间
+
+struct SimPassResult {
+    uint32_t sent, lost, longestBurst, duplicated, reordered, overflows;
+    uint32_t queueDrops, fecRecovered, fecUnrecoverable, resyncs, disconnects;
+    uint32_t reports, latencyP50, latencyP99, latencyMax;
+    int32_t finalX, finalY;
+    uint32_t checkpoints;
+    int32_t checkX[SIM_MAX_CHECKPOINTS];
+    int32_t checkY[SIM_MAX_CHECKPOINTS];
+};
+
+// 各检查点上相对参照的光标误差（欧氏距离）
+void simCursorError(const SimPassResult& ref, const SimPassResult& run, float& mean, float& worst);
+void simPrintComparison(const char* scenario, SimFormat format, uint32_t seed, int32_t truthX, int32_t truthY,
+                        const SimPassResult& ref, const SimPassResult& run);
+
+// --- 场景文件 ---
+// 主机仿真从文本文件读取场景，每行一个“键=值”，# 之后为注释：
+//   scenario=<内置场景>  基础参数，必须写在信道参数之前
+//   format=motion|fec|cumulative|packed  seconds=1~SIM_MAX_SECONDS  seed=<种子>
+//   以及 linkSimParseOverride 的信道参数（pgb/pbg/lossg/lossb/latency/jitter/dup/reorder/delay）
+
+struct SimSettings {
+    const LinkSimScenario* scenario;
+    LinkSimParams params;
+    SimFormat format;
+    uint32_t seconds;
+    uint32_t seed;
+    bool overridden; // 已有信道参数覆盖，之后不能再换基础场景
+};
+
+// 与固件 sim 命令的默认值相同：clean、motion、5 秒、种子 1
+void simDefaultSettings(SimSettings& settings);
+// 空行和注释行返回 true；键或值不合法时返回 false，settings 不变
+bool simParseSettingLine(SimSettings& settings, const char* line);
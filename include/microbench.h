@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+class HiResMouse;
+
+// --- 微基准 ---
+// 分阶段测量接收路径上的热点：帧校验/解码、队列交接、管线变换与按键差分、HID 报告组装。
+// 每个用例先预热一次，再连续执行 iterations 次，用 CPU 周期计数器计时（输入预先生成，
+// 循环开销可用 harness/empty 用例扣除）。结果每行一个 JSON 对象，便于从串口日志中筛出存档，
+// 比较不同固件版本：
+//   {"bench":"parse/motion","iters":20000,"cycles_per_op":41.2,"ns_per_op":171.7,"cpu_mhz":240,"build":"..."}
+//
+// 与硬件无关的用例（harness、parse、auth、pipeline、transform）在 microbench.cpp 中，主机基准（test/bench）
+// 运行同一份代码，主机上的“周期”即纳秒；queue/* 与 hid/* 依赖 FreeRTOS 和 USB，只在固件中运行
+// （microbench_device.cpp）。hid/* 用例会临时设置报告旁路，调用方需保证期间没有真实的鼠标报告
+// （未连接发送端）。
+
+constexpr size_t BENCH_INPUTS = 256; // 预先生成的输入个数（2 的幂，按 i & (BENCH_INPUTS-1) 轮流使用）
+
+extern const uint8_t benchMac[6];
+extern const char* benchFilter;       // 非 NULL 时只运行名称包含该子串的用例
+extern volatile int32_t benchSink;    // 防止被测代码被优化掉
+
+template <typename Op>
+void runBenchCase(const char* name, uint32_t iterations, Op&& op) {
+    if (benchFilter != NULL && strstr(name, benchFilter) == NULL) {
+        return;
+    }
+    op(0); // 预热：指令/数据进入缓存
+    const uint32_t start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < iterations; i++) {
+        op(i);
+    }
+    const uint32_t cycles = ESP.getCycleCount() - start;
+    const uint32_t mhz = ESP.getCpuFreqMHz();
+    const float cyclesPerOp = (float)cycles / iterations;
+    Serial.printf("{\"bench\":\"%s\",\"iters\":%u,\"cycles_per_op\":%.1f,\"ns_per_op\":%.1f,\"cpu_mhz\":%u,"
+                  "\"build\":\"%s %s\"}\n",
+                  name, iterations, cyclesPerOp, cyclesPerOp * 1000.0f / mhz, mhz, __DATE__, __TIME__);
+}
+
+// 固定种子生成的位移输入，每次运行相同
+struct BenchInputs {
+    int16_t dx[BENCH_INPUTS];
+    int16_t dy[BENCH_INPUTS];
+};
+void fillBenchInputs(BenchInputs& inputs);
+
+// 与硬件无关的用例；filter 非 NULL 时只运行名称包含该子串的用例
+void runPortableMicrobenches(uint32_t iterations, const char* filter);
+// 固件的全部用例：上面的用例加上 queue/* 与 hid/*
+void runMicrobenchSuite(HiResMouse& mouse, uint32_t iterations, const char* filter);
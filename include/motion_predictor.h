@@ -0,0 +1,150 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- 丢包时的运动外推（航位推算）---
+// 发送端按固定周期发送带序号的运动帧。若预期的帧在 周期 * (1 + 宽限) 内没有到达，
+// 就按上一帧的速度乘以衰减系数外推一个位移，最多连续外推 maxPredictions 次。
+// 外推值按序号槽位记录：之后若该槽位的真实数据到达（迟到或由冗余恢复），只输出
+// 真实值与外推值之差；若该槽位被序号跳过（确实丢失），外推值就作为它的估计保留。
+// 累计计数编码的帧已包含被跳过槽位的真实运动，此时这些槽位的外推值也一并扣除。
+
+constexpr size_t PREDICTOR_MAX_SLOTS = 8;
+constexpr int PREDICTOR_DAMPING_SHIFT = 8;   // 衰减系数 Q8（256 = 1.0）
+constexpr int16_t PREDICTOR_STALE_WINDOW = 64; // 序号回退超过该值视为发送端重启，重新同步
+
+struct PredictorParams {
+    bool enabled;
+    uint8_t maxPredictions;  // 连续外推的最大帧数
+    uint16_t dampingQ8;      // 每外推一帧速度乘以该系数
+    uint8_t gracePercent;    // 判定超时前额外等待的周期百分比
+};
+
+class MotionPredictor {
+public:
+    void setParams(const PredictorParams& params) {
+        params_ = params;
+        if (params_.maxPredictions > PREDICTOR_MAX_SLOTS) {
+            params_.maxPredictions = PREDICTOR_MAX_SLOTS;
+        }
+        reset();
+    }
+
+    void reset() {
+        synced_ = false;
+        pending_ = 0;
+        velX_ = velY_ = 0;
+    }
+
+    // 处理一个真实样本。返回 false 表示重复或过期的帧，应丢弃；
+    // 否则 dx/dy 被改写为扣除已外推部分后应输出的位移。
+    // coversGap 为 true 表示 dx/dy 已包含被跳过槽位的运动。
+    bool onSample(uint16_t seq, uint16_t intervalUs, uint32_t nowUs, bool coversGap, int16_t& dx, int16_t& dy) {
+        const int16_t trueX = dx, trueY = dy;
+        const int16_t ahead = (int16_t)(uint16_t)(seq - lastSeq_);
+        if (synced_ && ahead <= 0 && ahead > -PREDICTOR_STALE_WINDOW) {
+            return false;
+        }
+        if (synced_ && ahead > 0) {
+            // 被跳过的槽位视为丢失，外推值保留（或在 coversGap 时扣除）；当前槽位若外推过则只补差
+            dropPredictionsBefore(seq, coversGap, dx, dy);
+            takePrediction(seq, dx, dy);
+        } else {
+            pending_ = 0;
+        }
+        synced_ = true;
+        lastSeq_ = seq;
+        velX_ = trueX;
+        velY_ = trueY;
+        intervalUs_ = intervalUs;
+        lastEventUs_ = nowUs;
+        return true;
+    }
+
+    // 距下一次外推的微秒数；不需要外推时返回 UINT32_MAX
+    uint32_t usUntilPrediction(uint32_t nowUs) const {
+        if (!canPredict()) {
+            return UINT32_MAX;
+        }
+        const uint32_t elapsed = nowUs - lastEventUs_;
+        const uint32_t due = deadlineUs();
+        return elapsed >= due ? 0 : due - elapsed;
+    }
+
+    // 到期时生成一个外推位移，返回 false 表示当前不需要外推
+    bool predict(uint32_t nowUs, int16_t& dx, int16_t& dy) {
+        if (!canPredict() || nowUs - lastEventUs_ < deadlineUs()) {
+            return false;
+        }
+        velX_ = damp(velX_);
+        velY_ = damp(velY_);
+        // 外推的是尚未收到、也尚未外推过的下一个槽位（未决槽位的序号都大于 lastSeq_）
+        Slot& slot = slots_[pending_];
+        slot.seq = (uint16_t)(lastSeq_ + pending_ + 1);
+        slot.dx = velX_;
+        slot.dy = velY_;
+        pending_++;
+        lastEventUs_ += intervalUs_;
+        dx = velX_;
+        dy = velY_;
+        return true;
+    }
+
+    uint8_t pendingPredictions() const { return pending_; }
+
+private:
+    struct Slot {
+        uint16_t seq;
+        int16_t dx;
+        int16_t dy;
+    };
+
+    bool canPredict() const {
+        return params_.enabled && synced_ && intervalUs_ != 0 && pending_ < params_.maxPredictions &&
+               (velX_ != 0 || velY_ != 0);
+    }
+
+    uint32_t deadlineUs() const {
+        return (uint32_t)intervalUs_ + (uint32_t)intervalUs_ * params_.gracePercent / 100;
+    }
+
+    int16_t damp(int16_t v) const {
+        return (int16_t)(((int32_t)v * params_.dampingQ8) / (1 << PREDICTOR_DAMPING_SHIFT));
+    }
+
+    // 若该槽位外推过，把输出改为 真实值 - 外推值，并移除记录
+    void takePrediction(uint16_t seq, int16_t& dx, int16_t& dy) {
+        for (uint8_t i = 0; i < pending_; i++) {
+            if (slots_[i].seq == seq) {
+                dx = (int16_t)(dx - slots_[i].dx);
+                dy = (int16_t)(dy - slots_[i].dy);
+                slots_[i] = slots_[--pending_];
+                return;
+            }
+        }
+    }
+
+    void dropPredictionsBefore(uint16_t seq, bool subtract, int16_t& dx, int16_t& dy) {
+        for (uint8_t i = 0; i < pending_;) {
+            if ((int16_t)(uint16_t)(slots_[i].seq - seq) < 0) {
+                if (subtract) {
+                    dx = (int16_t)(dx - slots_[i].dx);
+                    dy = (int16_t)(dy - slots_[i].dy);
+                }
+                slots_[i] = slots_[--pending_];
+            } else {
+                i++;
+            }
+        }
+    }
+
+    PredictorParams params_ = {};
+    Slot slots_[PREDICTOR_MAX_SLOTS] = {};
+    uint8_t pending_ = 0;
+    bool synced_ = false;
+    uint16_t lastSeq_ = 0;
+    uint16_t intervalUs_ = 0;
+    uint32_t lastEventUs_ = 0;
+    int16_t velX_ = 0, velY_ = 0;
+};
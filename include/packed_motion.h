@@ -0,0 +1,154 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "protocol.h"
+
+// --- 变长压缩运动帧 ---
+// 帧格式（PACKET_TYPE_MOTION_PACKED）：
+//   type(1) | seq(2, 小端，首个样本的序号) | count(1, 1~PACKED_MAX_SAMPLES) | intervalUs(varint)
+//   | 字段掩码（每样本 4 位，两个样本共用一个字节，低半字节在前）
+//   | 各样本依次：[dx zigzag varint] [dy zigzag varint] [wheel zigzag varint] [buttons(1)]
+// 掩码位为 0 的字段不出现在帧中：位移为 0 的轴不占字节，按键只在变化时携带。
+// 由于按键可能随变化帧一起丢失，发送端应在按键变化后的若干帧内重复携带按键字段。
+
+constexpr uint8_t PACKED_MAX_SAMPLES = 8;
+constexpr size_t PACKED_HEADER_SIZE = 4;
+constexpr size_t PACKED_MAX_FRAME_SIZE = PACKED_HEADER_SIZE + 3 + (PACKED_MAX_SAMPLES + 1) / 2 +
+                                         PACKED_MAX_SAMPLES * (3 + 3 + 2 + 1);
+
+enum : uint8_t {
+    PACKED_FIELD_DX      = 0x01,
+    PACKED_FIELD_DY      = 0x02,
+    PACKED_FIELD_WHEEL   = 0x04,
+    PACKED_FIELD_BUTTONS = 0x08,
+};
+
+struct PackedSample {
+    int16_t deltaX;
+    int16_t deltaY;
+    int8_t wheel;
+    uint8_t buttons;
+};
+
+inline uint32_t zigzagEncode(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+inline int32_t zigzagDecode(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+// 读取一个最多 3 字节（21 位）的 varint；越界或过长时返回 NULL
+inline const uint8_t* readVarint(const uint8_t* p, const uint8_t* end, uint32_t& out) {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 21; shift += 7) {
+        if (p >= end) {
+            return NULL;
+        }
+        const uint8_t b = *p++;
+        value |= (uint32_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            out = value;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+// 编码一帧；lastButtons 为上一帧已发送的按键状态，函数返回后更新。返回帧长，失败返回 0
+size_t encodePackedMotion(const PackedSample* samples, uint8_t count, uint16_t seq, uint16_t intervalUs,
+                          uint8_t& lastButtons, bool forceButtons, uint8_t* out, size_t outSize);
+
+// 接收端解码器：记住每个发送端的按键状态，把一帧展开为若干队列项
+class PackedMotionDecoder {
+public:
+    void reset() { synced_ = false; }
+
+    // emit(const QueueItem_t&) 对每个样本调用一次；帧格式非法时返回 false 且不调用 emit
+    template <typename Emit>
+    bool decode(const uint8_t mac[6], uint32_t arrivalUs, const uint8_t* data, size_t len, Emit&& emit) {
+        if (len < PACKED_HEADER_SIZE + 1) {
+            return reject();
+        }
+        const uint16_t seq = (uint16_t)(data[1] | (data[2] << 8));
+        const uint8_t count = data[3];
+        if (count == 0 || count > PACKED_MAX_SAMPLES) {
+            return reject();
+        }
+        const uint8_t* p = data + PACKED_HEADER_SIZE;
+        const uint8_t* end = data + len;
+        uint32_t intervalUs;
+        p = readVarint(p, end, intervalUs);
+        const uint8_t* masks = p;
+        if (p == NULL || (size_t)(end - p) < (size_t)(count + 1) / 2) {
+            return reject();
+        }
+        p += (count + 1) / 2;
+
+        // 先完整解码到临时数组，整帧校验通过后再入队，避免半帧生效
+        PackedSample decoded[PACKED_MAX_SAMPLES];
+        uint8_t buttons = (synced_ && memcmp(mac, mac_, 6) == 0) ? buttons_ : 0;
+        for (uint8_t i = 0; i < count; i++) {
+            const uint8_t mask = (masks[i >> 1] >> ((i & 1) * 4)) & 0x0F;
+            int32_t fields[3] = {0, 0, 0};
+            for (int f = 0; f < 3; f++) {
+                if (mask & (1 << f)) {
+                    uint32_t raw;
+                    p = readVarint(p, end, raw);
+                    if (p == NULL) {
+                        return reject();
+                    }
+                    fields[f] = zigzagDecode(raw);
+                }
+            }
+            if (mask & PACKED_FIELD_BUTTONS) {
+                if (p >= end) {
+                    return reject();
+                }
+                buttons = *p++ & ~MOTION_BUTTONS_RESERVED;
+            }
+            if (fields[0] < INT16_MIN || fields[0] > INT16_MAX || fields[1] < INT16_MIN || fields[1] > INT16_MAX ||
+                fields[2] < INT8_MIN || fields[2] > INT8_MAX) {
+                return reject();
+            }
+            decoded[i].deltaX = (int16_t)fields[0];
+            decoded[i].deltaY = (int16_t)fields[1];
+            decoded[i].wheel = (int8_t)fields[2];
+            decoded[i].buttons = buttons;
+        }
+        if (p != end || intervalUs > UINT16_MAX) {
+            return reject();
+        }
+
+        QueueItem_t item = {};
+        memcpy(item.mac_addr, mac, 6);
+        item.type = PACKET_TYPE_MOUSE_DATA;
+        item.flags = QUEUE_ITEM_HAS_SEQ;
+        item.intervalUs = (uint16_t)intervalUs;
+        item.arrivalUs = arrivalUs;
+        for (uint8_t i = 0; i < count; i++) {
+            item.seq = (uint16_t)(seq + i);
+            item.deltaX = decoded[i].deltaX;
+            item.deltaY = decoded[i].deltaY;
+            item.wheel = decoded[i].wheel;
+            item.buttons = decoded[i].buttons;
+            emit(item);
+        }
+
+        synced_ = true;
+        memcpy(mac_, mac, 6);
+        buttons_ = buttons;
+        return true;
+    }
+
+    uint32_t rejected() const { return rejected_; }
+
+private:
+    bool reject() {
+        rejected_++;
+        return false;
+    }
+
+    bool synced_ = false;
+    uint32_t rejected_ = 0;
+    uint8_t mac_[6] = {};
+    uint8_t buttons_ = 0;
+};
@@ -0,0 +1,403 @@
+#pragma once
+
+#include <Arduino.h>
+#include <type_traits>
+
+#include "accel.h"
+#include "clock.h"
+#include "config.h"
+#include "dpi_scale.h"
+#include "jitter_filter.h"
+#include "motion_predictor.h"
+#include "protocol.h"
+
+// 管线统计计数（仅在 features.stats 打开时存在）
+struct PipelineStats {
+    uint32_t packets;
+    uint32_t heartbeats;
+    uint32_t motionReports;
+    uint32_t buttonEvents;
+    uint32_t jitterSuppressed;  // 被抖动滤波整体抑制的运动样本
+    uint32_t predictions;       // 丢包外推输出的样本
+    uint32_t staleFrames;       // 重复或过期而被丢弃的带序号帧
+    uint32_t reports;           // 实际发给主机的鼠标报告
+    uint32_t suppressedReports; // 与上次报告相比没有变化而省掉的报告
+    uint32_t mergedReports;     // 同一样本的位移与多个按键变化合并进一个报告而省掉的报告
+    uint32_t keepAlives;        // 按键按住期间的保活报告
+};
+
+struct NoPipelineStats {};
+
+// 被关闭的阶段的替身：空类型，不占存储、没有初始化代码；对它的调用都在 if constexpr 的
+// 未选分支中，不会被实例化
+struct DisabledStage {};
+
+// 空成员不占地址（GCC 9 起支持；旧编译器上每个空成员占 1 字节，仍没有初始化代码）
+#if defined(__has_cpp_attribute)
+#if __has_cpp_attribute(no_unique_address)
+#define PIPELINE_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
+#endif
+#ifndef PIPELINE_NO_UNIQUE_ADDRESS
+#define PIPELINE_NO_UNIQUE_ADDRESS
+#endif
+
+// 单次鼠标运动样本，在各变换阶段之间传递；滚动以 1/120 格为单位
+struct MotionSample {
+    int16_t dx;
+    int16_t dy;
+    int16_t scroll;
+    int16_t pan;
+};
+
+// 模板化的鼠标处理管线
+// Cfg  : 编译期配置，决定启用哪些阶段以及按键映射
+// Sink : HID 输出端，需提供 report(dx, dy, scroll, pan, buttons, force)（如 HiResMouse）：
+//        滚动参数单位为 1/120 格，buttons 为 HID 按键位；没有发出报告时返回 false
+// 外推、保活与 HID 计时的时间取自构造时传入的时钟
+//
+// 输出端的报告节流：每个样本（包括外推样本）的位移、滚动和按键状态合并成至多一个报告；
+// 与上次发给主机的报告相比没有变化时不发送。按键按住期间若超过 hidKeepAliveMs 没有报告，
+// 重发一次当前状态（0 = 关闭）。
+template <const ReceiverConfig& Cfg, typename Sink>
+class MousePipeline {
+public:
+    using Stats = std::conditional_t<Cfg.features.stats, PipelineStats, NoPipelineStats>;
+
+    // 各阶段是否编译进管线（变换阶段受 filters 总开关控制）
+    static constexpr bool kDpiScale = Cfg.features.filters && Cfg.features.dpiScale;
+    static constexpr bool kJitter = Cfg.features.filters && Cfg.features.jitter;
+    static constexpr bool kAccel = Cfg.features.filters && Cfg.features.accel;
+    static constexpr bool kPredictor = Cfg.features.predictor;
+
+    MousePipeline(Sink& sink, const Clock& clock) : sink_(sink), clock_(clock) {
+        if constexpr (kAccel) {
+            AccelCurve curve;
+            if (buildAccelCurve(Cfg.accel, curve)) {
+                accel_.setCurve(curve);
+            }
+        }
+        if constexpr (kJitter) {
+            JitterFilterTables tables;
+            if (buildJitterFilterTables(Cfg.jitter, tables)) {
+                jitter_.setTables(tables);
+            }
+        }
+        if constexpr (kPredictor) {
+            predictor_.setParams(Cfg.predictor);
+        }
+    }
+
+    // 新连接建立时清空各阶段的残留状态
+    void resetMotionState() {
+        if constexpr (kPredictor) {
+            predictor_.reset();
+        }
+        if constexpr (kDpiScale) {
+            dpi_.reset();
+        }
+        if constexpr (kJitter) {
+            jitter_.reset();
+        }
+        if constexpr (kAccel) {
+            accel_.reset();
+        }
+    }
+
+    // 以下 set* 由其他任务调用：参数先暂存，在下一个样本处理前生效；对应阶段被关闭时忽略
+    void setAccelCurve(const AccelCurve& curve) {
+        if constexpr (kAccel) {
+            portENTER_CRITICAL(&pendingMux_);
+            pending_.curve = curve;
+            pending_.flags |= PENDING_ACCEL;
+            portEXIT_CRITICAL(&pendingMux_);
+        }
+    }
+
+    void setJitterFilter(const JitterFilterTables& tables) {
+        if constexpr (kJitter) {
+            portENTER_CRITICAL(&pendingMux_);
+            pending_.jitter = tables;
+            pending_.flags |= PENDING_JITTER;
+            portEXIT_CRITICAL(&pendingMux_);
+        }
+    }
+
+    void setPredictor(const PredictorParams& params) {
+        if constexpr (kPredictor) {
+            portENTER_CRITICAL(&pendingMux_);
+            pending_.predictor = params;
+            pending_.flags |= PENDING_PREDICTOR;
+            portEXIT_CRITICAL(&pendingMux_);
+        }
+    }
+
+    void setDpiScale(int32_t scaleX, int32_t scaleY) {
+        if constexpr (kDpiScale) {
+            portENTER_CRITICAL(&pendingMux_);
+            pending_.dpi.x = scaleX;
+            pending_.dpi.y = scaleY;
+            pending_.flags |= PENDING_DPI;
+            portEXIT_CRITICAL(&pendingMux_);
+        }
+    }
+
+    // 处理一个已出队的数据项（心跳或鼠标数据）
+    void process(const QueueItem_t& item) {
+        if (pending_.flags != 0) {
+            applyPendingSettings();
+        }
+        if constexpr (Cfg.features.stats) {
+            stats_.packets++;
+        }
+        if constexpr (Cfg.features.tracing) {
+            Serial.printf("[trace] type=%d dx=%d dy=%d wheel=%d scroll=%d pan=%d buttons=0x%02X\n",
+                          (int)item.type, item.deltaX, item.deltaY, item.wheel, item.scroll, item.pan,
+                          item.buttons);
+        }
+
+        if (item.type != PACKET_TYPE_MOUSE_DATA) {
+            if constexpr (Cfg.features.stats) {
+                stats_.heartbeats++;
+            }
+            keepAlive();
+            return;
+        }
+
+        MotionSample motion = {item.deltaX, item.deltaY, (int16_t)(item.wheel * SCROLL_UNITS_PER_DETENT), 0};
+        if (item.flags & QUEUE_ITEM_FINE_SCROLL) {
+            motion.scroll = item.scroll;
+            motion.pan = item.pan;
+        }
+        if constexpr (kPredictor) {
+            if ((item.flags & QUEUE_ITEM_HAS_SEQ) &&
+                !predictor_.onSample(item.seq, item.intervalUs, clock_.nowUs(),
+                                     (item.flags & QUEUE_ITEM_COVERS_GAP) != 0, motion.dx, motion.dy)) {
+                if constexpr (Cfg.features.stats) {
+                    stats_.staleFrames++;
+                }
+                return;
+            }
+        }
+        if constexpr (kAccel) {
+            // 加速曲线的速度按发送端的报告周期归一化
+            if (item.flags & QUEUE_ITEM_HAS_SEQ) {
+                accel_.setSampleInterval(item.intervalUs);
+            }
+        }
+        submit(motion, mapButtons(item.buttons));
+    }
+
+    // 队列等待的超时时间：外推开启且有预期的帧时等到其截止时间，按键按住时最多等到下一次保活
+    TickType_t ticksUntilDue() const {
+        uint32_t us = UINT32_MAX;
+        const uint32_t now = clock_.nowUs();
+        if constexpr (kPredictor) {
+            us = predictor_.usUntilPrediction(now);
+        }
+        if constexpr (Cfg.hidKeepAliveMs != 0) {
+            if (hidButtons_ != 0) {
+                const uint32_t sinceUs = now - lastReportUs_;
+                const uint32_t keepAliveUs = sinceUs >= KEEP_ALIVE_US ? 0 : KEEP_ALIVE_US - sinceUs;
+                us = keepAliveUs < us ? keepAliveUs : us;
+            }
+        }
+        return us == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS((us + 999) / 1000);
+    }
+
+    // 每次唤醒时调用：预期的运动帧没有按时到达时，输出一个外推位移
+    void poll() {
+        if (pending_.flags != 0) {
+            applyPendingSettings();
+        }
+        if constexpr (kPredictor) {
+            MotionSample motion = {0, 0, 0, 0};
+            if (predictor_.predict(clock_.nowUs(), motion.dx, motion.dy)) {
+                if constexpr (Cfg.features.stats) {
+                    stats_.predictions++;
+                }
+                submit(motion, hidButtons_);
+            }
+        }
+        keepAlive();
+    }
+
+    const Stats& stats() const { return stats_; }
+
+    // 累计的 HID 报告数与发送耗时（单调递增，由调用方求差）
+    uint32_t hidReports() const { return hidReports_; }
+    uint32_t hidBusyUs() const { return hidBusyUs_; }
+
+    void printStats() const {
+        if constexpr (Cfg.features.stats) {
+            Serial.printf("[统计] 包:%u 心跳:%u 移动报告:%u 按键事件:%u 抖动抑制:%u 外推:%u 过期帧:%u\n",
+                          stats_.packets, stats_.heartbeats, stats_.motionReports, stats_.buttonEvents,
+                          stats_.jitterSuppressed, stats_.predictions, stats_.staleFrames);
+            Serial.printf("[统计] HID报告:%u 省去(无变化):%u 省去(合并):%u 保活:%u\n", stats_.reports,
+                          stats_.suppressedReports, stats_.mergedReports, stats_.keepAlives);
+        }
+    }
+
+private:
+    // 经过变换阶段后，把位移、滚动和按键状态合并成至多一个报告
+    void submit(MotionSample& motion, uint8_t buttons) {
+        if constexpr (Cfg.features.filters) {
+            filterMotion(motion);
+        }
+
+        const bool moved = motion.dx != 0 || motion.dy != 0 || motion.scroll != 0 || motion.pan != 0;
+        const uint8_t changed = buttons ^ hidButtons_;
+        bool sent = false;
+        if (moved || changed != 0) {
+            const uint32_t start = hidTimingStart();
+            sent = sink_.report(motion.dx, motion.dy, motion.scroll, motion.pan, buttons, false);
+            if (sent) {
+                hidTimingEnd(start);
+                if constexpr (Cfg.hidKeepAliveMs != 0) {
+                    lastReportUs_ = clock_.nowUs();
+                }
+            }
+            hidButtons_ = buttons;
+        }
+        if constexpr (Cfg.features.stats) {
+            if (!sent) {
+                stats_.suppressedReports++;
+                return;
+            }
+            const uint8_t buttonEvents = (uint8_t)__builtin_popcount(changed);
+            stats_.reports++;
+            stats_.motionReports += moved;
+            stats_.buttonEvents += buttonEvents;
+            // 逐项输出时位移一个报告、每个按键变化各一个报告
+            stats_.mergedReports += moved + buttonEvents - 1;
+        }
+    }
+
+    // 按键按住期间定期重发当前状态
+    void keepAlive() {
+        if constexpr (Cfg.hidKeepAliveMs != 0) {
+            if (hidButtons_ == 0 || clock_.nowUs() - lastReportUs_ < KEEP_ALIVE_US) {
+                return;
+            }
+            const uint32_t start = hidTimingStart();
+            sink_.report(0, 0, 0, 0, hidButtons_, true);
+            hidTimingEnd(start);
+            lastReportUs_ = clock_.nowUs();
+            if constexpr (Cfg.features.stats) {
+                stats_.keepAlives++;
+            }
+        }
+    }
+
+    // HID 发送计时（供链路反馈估计主机侧的接收能力）
+    uint32_t hidTimingStart() const {
+        if constexpr (Cfg.features.feedback) {
+            return clock_.nowUs();
+        }
+        return 0;
+    }
+
+    void hidTimingEnd(uint32_t start) {
+        if constexpr (Cfg.features.feedback) {
+            hidReports_++;
+            hidBusyUs_ += clock_.nowUs() - start;
+        }
+    }
+
+    // 运动变换阶段（加速、缩放、滤波等在此串联）
+    void filterMotion(MotionSample& motion) {
+        // 先把不同 DPI 的发送端归一化，再按归一化后的速度查加速曲线
+        if constexpr (kDpiScale) {
+            dpi_.apply(motion.dx, motion.dy);
+        }
+        // 抖动滤波放在加速之前，避免噪声被加速曲线放大
+        if constexpr (kJitter) {
+            const bool hadMotion = motion.dx != 0 || motion.dy != 0;
+            jitter_.apply(motion.dx, motion.dy);
+            if constexpr (Cfg.features.stats) {
+                if (hadMotion && motion.dx == 0 && motion.dy == 0) {
+                    stats_.jitterSuppressed++;
+                }
+            }
+        }
+        if constexpr (kAccel) {
+            accel_.apply(motion.dx, motion.dy);
+        }
+    }
+
+    void applyPendingSettings() {
+        portENTER_CRITICAL(&pendingMux_);
+        if constexpr (kAccel) {
+            if (pending_.flags & PENDING_ACCEL) {
+                accel_.setCurve(pending_.curve);
+            }
+        }
+        if constexpr (kJitter) {
+            if (pending_.flags & PENDING_JITTER) {
+                jitter_.setTables(pending_.jitter);
+            }
+        }
+        if constexpr (kPredictor) {
+            if (pending_.flags & PENDING_PREDICTOR) {
+                predictor_.setParams(pending_.predictor);
+            }
+        }
+        if constexpr (kDpiScale) {
+            if (pending_.flags & PENDING_DPI) {
+                dpi_.setScale(pending_.dpi.x, pending_.dpi.y);
+            }
+        }
+        pending_.flags = 0;
+        portEXIT_CRITICAL(&pendingMux_);
+    }
+
+    // 表驱动的按键映射：表长度是编译期常量，循环会被完全展开
+    static uint8_t mapButtons(uint8_t packetButtons) {
+        uint8_t hid = 0;
+        for (size_t i = 0; i < Cfg.buttonCount; i++) {
+            if (packetButtons & Cfg.buttonMap[i].packetMask) {
+                hid |= Cfg.buttonMap[i].hidButton;
+            }
+        }
+        return hid;
+    }
+
+    static constexpr uint32_t KEEP_ALIVE_US = Cfg.hidKeepAliveMs * 1000;
+
+    Sink& sink_;
+    const Clock& clock_;
+    uint8_t hidButtons_ = 0;     // 上次提交的 HID 按键状态
+    uint32_t lastReportUs_ = 0;  // 上次发出报告的时刻（保活计时）
+    volatile uint32_t hidReports_ = 0;
+    volatile uint32_t hidBusyUs_ = 0;
+
+    // 被关闭的阶段换成不占存储的空类型
+    template <bool Enabled, typename Stage>
+    using StageIf = std::conditional_t<Enabled, Stage, DisabledStage>;
+
+    PIPELINE_NO_UNIQUE_ADDRESS StageIf<kPredictor, MotionPredictor> predictor_;
+    PIPELINE_NO_UNIQUE_ADDRESS StageIf<kDpiScale, DpiScaler> dpi_;
+    PIPELINE_NO_UNIQUE_ADDRESS StageIf<kJitter, JitterFilter> jitter_;
+    PIPELINE_NO_UNIQUE_ADDRESS StageIf<kAccel, AccelEngine> accel_;
+
+    enum : uint8_t {
+        PENDING_ACCEL = 0x01,
+        PENDING_DPI   = 0x02,
+        PENDING_JITTER = 0x04,
+        PENDING_PREDICTOR = 0x08,
+    };
+    struct PendingDpi {
+        int32_t x;
+        int32_t y;
+    };
+    struct PendingSettings {
+        volatile uint8_t flags;
+        PIPELINE_NO_UNIQUE_ADDRESS StageIf<kAccel, AccelCurve> curve;
+        PIPELINE_NO_UNIQUE_ADDRESS StageIf<kJitter, JitterFilterTables> jitter;
+        PIPELINE_NO_UNIQUE_ADDRESS StageIf<kPredictor, PredictorParams> predictor;
+        PIPELINE_NO_UNIQUE_ADDRESS StageIf<kDpiScale, PendingDpi> dpi;
+    };
+    PendingSettings pending_ = {};
+    portMUX_TYPE pendingMux_ = portMUX_INITIALIZER_UNLOCKED;
+    Stats stats_ = {};
+};
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- 数据结构定义 ---
+typedef enum {
+    PACKET_TYPE_DISCOVERY = 0,
+    PACKET_TYPE_MOUSE_DATA,
+    PACKET_TYPE_HEARTBEAT, // 新增心跳包类型
+    PACKET_TYPE_MOTION,    // 带序号的紧凑运动帧（MotionPacket）
+    PACKET_TYPE_MOTION_FEC, // 附带最近 K 个样本冗余的运动帧（MotionFecPacket）
+    PACKET_TYPE_MOTION_CUMULATIVE, // 累计计数运动帧（CumulativeMotionPacket）
+    PACKET_TYPE_MOTION_TIMED,      // 带发送端时间戳的运动帧（TimedMotionPacket）
+    PACKET_TYPE_CLOCK_SYNC,        // 带发送端时间戳的心跳（ClockSyncPacket）
+    PACKET_TYPE_HELLO,             // 发送端 -> 接收端：能力声明，请求配对（HelloPacket）
+    PACKET_TYPE_HELLO_ACK,         // 接收端 -> 发送端：协商结果（HelloAckPacket）
+    PACKET_TYPE_LINK_FEEDBACK,     // 接收端 -> 发送端：链路质量反馈（LinkFeedbackPacket）
+    PACKET_TYPE_MOTION_PACKED,     // 变长压缩运动帧，可批量携带多个样本（见 packed_motion.h）
+    PACKET_TYPE_AUTH_CHALLENGE,    // 接收端 -> 发送端：配对认证挑战（AuthChallengePacket）
+    PACKET_TYPE_AUTH_RESPONSE,     // 发送端 -> 接收端：认证应答（AuthResponsePacket）
+    PACKET_TYPE_LINK_PROBE,        // 链路测速帧，收到的一方直接忽略
+    PACKET_TYPE_KEYBOARD,          // 键盘全量按键状态（KeyboardPacket）
+    PACKET_TYPE_MOTION_HIRES       // 带精细垂直/水平滚动的运动帧（MotionHiResPacket）
+} PacketType;
+
+constexpr uint8_t FEC_MAX_REDUNDANCY = 4;
+constexpr uint8_t SCROLL_UNITS_PER_DETENT = 120; // 精细滚动单位：1/120 格（与 Windows 的 WHEEL_DELTA 一致）
+constexpr uint8_t MOTION_BUTTONS_RESERVED = 0xE0;   // 运动帧按键字段中未定义的位（只有 5 个按键），接收端解码时屏蔽
+
+#pragma pack(push, 1)
+typedef struct {
+    PacketType type;
+    char deviceName[32];
+    int16_t deltaX;
+    int16_t deltaY;
+    int8_t wheel;
+    uint8_t buttons;
+} UniversalPacket;
+
+// 紧凑运动帧：首字节为类型，带序号与发送端报告周期，用于丢包检测与外推
+typedef struct {
+    uint8_t type;         // PACKET_TYPE_MOTION
+    uint16_t seq;         // 每帧递增，回绕
+    uint16_t intervalUs;  // 发送端的报告周期
+    int16_t deltaX;
+    int16_t deltaY;
+    int8_t wheel;
+    uint8_t buttons;
+} MotionPacket;
+
+// 冗余样本：与运动帧的负载字段相同，序号由其在 history 中的位置隐含
+typedef struct {
+    int16_t deltaX;
+    int16_t deltaY;
+    int8_t wheel;
+    uint8_t buttons;
+} RedundantSample;
+
+// 前向纠错运动帧：当前样本 + 之前 redundancy 个样本，history[i] 对应序号 seq-1-i。
+// 任意连续 redundancy 帧的丢失都能由下一帧完整恢复，因此发送端可以关闭链路层重传以降低延迟。
+// 帧长随 redundancy 变化：sizeof(MotionFecPacket) - (FEC_MAX_REDUNDANCY - redundancy) * sizeof(RedundantSample)
+typedef struct {
+    uint8_t type;         // PACKET_TYPE_MOTION_FEC
+    uint16_t seq;
+    uint16_t intervalUs;
+    int16_t deltaX;
+    int16_t deltaY;
+    int8_t wheel;
+    uint8_t buttons;
+    uint8_t redundancy;   // 0 ~ FEC_MAX_REDUNDANCY
+    RedundantSample history[FEC_MAX_REDUNDANCY];
+} MotionFecPacket;
+
+// 累计计数运动帧：发送端上报自启动以来回绕的 32 位累计位移，接收端与上次的值相减得到增量。
+// 丢帧只会让下一帧的增量变大，光标位置不会永久偏移。
+typedef struct {
+    uint8_t type;         // PACKET_TYPE_MOTION_CUMULATIVE
+    uint16_t seq;
+    uint16_t intervalUs;
+    uint32_t totalX;
+    uint32_t totalY;
+    uint32_t totalWheel;
+    uint8_t buttons;
+} CumulativeMotionPacket;
+
+// 带时间戳的运动帧：senderTimeUs 为发送端采样时刻（micros），用于抖动缓冲按原始节奏回放
+typedef struct {
+    uint8_t type;         // PACKET_TYPE_MOTION_TIMED
+    uint16_t seq;
+    uint16_t intervalUs;
+    uint32_t senderTimeUs;
+    int16_t deltaX;
+    int16_t deltaY;
+    int8_t wheel;
+    uint8_t buttons;
+} TimedMotionPacket;
+
+// 高分辨率滚动：与 MotionPacket 共用序号空间，发送端可在有滚动的样本上改用此格式
+typedef struct {
+    uint8_t type;         // PACKET_TYPE_MOTION_HIRES
+    uint16_t seq;
+    uint16_t intervalUs;
+    int16_t deltaX;
+    int16_t deltaY;
+    int16_t scroll;       // 垂直滚动，1/120 格
+    int16_t pan;          // 水平滚动（AC Pan），1/120 格，正值向右
+    uint8_t buttons;
+} MotionHiResPacket;
+
+// 带时间戳的心跳：兼作时钟同步，接收端据此估计两端时钟的偏移与漂移
+typedef struct {
+    uint8_t type;         // PACKET_TYPE_CLOCK_SYNC
+    uint16_t seq;
+    uint32_t senderTimeUs;
+} ClockSyncPacket;
+
+// 键盘帧：每帧携带完整的按键状态而非按下/松开事件，丢帧只会推迟、不会丢失按键变化；
+// 发送端在状态变化时立即发送，之后再重复发送几帧以防丢失。
+// keys 为 HID 键盘用途 0x00~0x77 的位图（位 n = 用途 n），修饰键单独放在 modifiers。
+constexpr size_t KEYBOARD_BITMAP_SIZE = 15;
+
+typedef struct {
+    uint8_t type;         // PACKET_TYPE_KEYBOARD
+    uint16_t seq;
+    uint8_t modifiers;    // 位 0~7 = 左Ctrl/Shift/Alt/GUI、右Ctrl/Shift/Alt/GUI
+    uint8_t keys[KEYBOARD_BITMAP_SIZE];
+} KeyboardPacket;
+
+// --- 能力协商 ---
+// 线上格式版本：1 = UniversalPacket，2 = MotionPacket（序号），3 = FEC/累计计数/时间戳等扩展帧，
+// 4 = 变长压缩帧
+constexpr uint8_t HANDSHAKE_VERSION = 1;
+constexpr uint8_t WIRE_FORMAT_VERSION = 4;
+
+// Capabilities.features
+enum : uint16_t {
+    CAP_SEQUENCE   = 0x0001, // MotionPacket
+    CAP_FEC        = 0x0002, // MotionFecPacket
+    CAP_CUMULATIVE = 0x0004, // CumulativeMotionPacket
+    CAP_TIMESTAMPS = 0x0008, // TimedMotionPacket
+    CAP_CLOCK_SYNC = 0x0010, // ClockSyncPacket
+    CAP_BATCHING   = 0x0020, // 单帧携带多个样本
+    CAP_FEEDBACK   = 0x0040, // 接收端的链路质量反馈
+    CAP_PACKED     = 0x0080, // 变长压缩运动帧
+    CAP_ENCRYPTION = 0x0100, // 共享密钥认证配对 + ESP-NOW 硬件加密
+    CAP_AUTH_TAG   = 0x0200, // 认证配对后以明文帧 + 认证标签代替硬件加密（见 frame_auth.h）
+    CAP_KEYBOARD   = 0x0400, // KeyboardPacket，接收端枚举为鼠标 + 全键无冲键盘的复合设备
+    CAP_HIRES_SCROLL = 0x0800, // MotionHiResPacket：精细滚动与水平滚动
+};
+
+// 协商后发送端应使用的运动帧格式
+typedef enum : uint8_t {
+    MOTION_FORMAT_LEGACY = 0,
+    MOTION_FORMAT_SEQUENCE,
+    MOTION_FORMAT_TIMED,
+    MOTION_FORMAT_CUMULATIVE,
+    MOTION_FORMAT_FEC,
+    MOTION_FORMAT_PACKED,
+} MotionFormat;
+
+typedef struct {
+    uint8_t wireVersion;     // 能理解的最高线上格式版本
+    uint16_t features;       // CAP_*
+    uint16_t minIntervalUs;  // 能支持的最短报告周期
+    uint8_t channel;         // 首选频道
+    uint8_t maxRedundancy;   // FEC 冗余样本数上限
+    uint16_t resolution;     // 发送端：传感器 CPI；接收端：期望的 HID 分辨率（CPI）
+} Capabilities;
+
+typedef struct {
+    uint8_t type;            // PACKET_TYPE_HELLO
+    uint8_t handshakeVersion;
+    Capabilities caps;
+    char deviceName[16];
+} HelloPacket;
+
+// 双方能力取交集后得到的链路模式
+typedef struct {
+    uint8_t wireVersion;
+    uint16_t features;
+    MotionFormat format;
+    uint16_t intervalUs;
+    uint8_t channel;
+    uint8_t redundancy;
+    uint16_t senderResolution;
+    uint16_t hostResolution;
+} LinkMode;
+
+typedef enum : uint8_t {
+    HELLO_STATUS_OK = 0,
+    HELLO_STATUS_BUSY,         // 已与其他发送端连接
+    HELLO_STATUS_UNSUPPORTED,  // 握手版本不兼容
+    HELLO_STATUS_AUTH_REQUIRED, // 接收端要求认证配对，而发送端不支持
+    HELLO_STATUS_AUTH_FAILED,  // 认证应答校验失败或超时
+} HelloStatus;
+
+typedef struct {
+    uint8_t type;            // PACKET_TYPE_HELLO_ACK
+    uint8_t handshakeVersion;
+    HelloStatus status;
+    LinkMode mode;
+    Capabilities caps;       // 接收端自身的能力
+} HelloAckPacket;
+
+// --- 认证配对 ---
+// 双方预先共享同一个配对密钥。接收端对支持 CAP_ENCRYPTION 的 Hello 回复随机挑战，
+// 发送端用配对密钥对双方 MAC 与两个随机数计算认证码作答；校验通过后双方各自由同样的
+// 输入派生 LMK，接收端以加密方式注册对端，并用加密链路回复 HelloAck，
+// 发送端能解密这条回复即说明接收端同样持有配对密钥。
+constexpr size_t AUTH_NONCE_SIZE = 16;
+constexpr size_t AUTH_TAG_SIZE = 16;
+
+typedef struct {
+    uint8_t type;                    // PACKET_TYPE_AUTH_CHALLENGE
+    uint8_t nonce[AUTH_NONCE_SIZE];  // 接收端随机数
+} AuthChallengePacket;
+
+typedef struct {
+    uint8_t type;                    // PACKET_TYPE_AUTH_RESPONSE
+    uint8_t nonce[AUTH_NONCE_SIZE];  // 发送端随机数
+    uint8_t tag[AUTH_TAG_SIZE];      // 认证码，见 link_security.h
+} AuthResponsePacket;
+
+// LinkFeedbackPacket.flags
+enum : uint8_t {
+    FEEDBACK_CONGESTED  = 0x01, // 接收端队列拥塞或溢出，发送端应降速/加大批量
+    FEEDBACK_LINK_CLEAN = 0x02, // 丢包低且信号好，发送端可提速、降低发射功率
+    FEEDBACK_WEAK_SIGNAL = 0x04, // 信号弱，发送端可提高发射功率
+    FEEDBACK_HOST_SUSPENDED = 0x08, // USB 主机已挂起：报告不会送达主机，发送端应降到建议的低速周期
+                                    // （仍要按时发送以维持连接，按键/移动用于远程唤醒）
+};
+
+typedef struct {
+    uint8_t type;                 // PACKET_TYPE_LINK_FEEDBACK
+    uint16_t seq;
+    uint16_t lossPermille;        // 周期内丢包率（千分比）
+    int8_t rssi;                  // dBm，0 表示未知
+    uint8_t queuePeak;            // 周期内接收队列峰值深度
+    uint8_t queueCapacity;
+    uint16_t hidReportRate;       // 每秒发给主机的 HID 报告数
+    uint16_t hidSendUs;           // 单个 HID 报告的平均发送耗时（反映主机轮询）
+    uint16_t suggestedIntervalUs; // 建议的报告周期
+    uint8_t flags;                // FEEDBACK_*
+} LinkFeedbackPacket;
+#pragma pack(pop)
+
+constexpr size_t FEC_HEADER_SIZE = sizeof(MotionFecPacket) - sizeof(RedundantSample) * FEC_MAX_REDUNDANCY;
+
+// QueueItem_t.flags
+enum : uint8_t {
+    QUEUE_ITEM_HAS_SEQ   = 0x01, // seq/intervalUs 字段有效
+    QUEUE_ITEM_RECOVERED = 0x02, // 由冗余数据恢复的样本
+    QUEUE_ITEM_COVERS_GAP = 0x04, // 位移已包含此前被跳过序号的运动（累计计数编码）
+    QUEUE_ITEM_HAS_TIMESTAMP = 0x08, // senderTimeUs 字段有效
+    QUEUE_ITEM_FINE_SCROLL = 0x10, // scroll/pan 字段有效（否则滚动取 wheel 整格）
+};
+
+typedef struct {
+    uint8_t mac_addr[6];
+    PacketType type; // 新增type字段，用于区分包类型
+    int16_t deltaX;
+    int16_t deltaY;
+    int8_t wheel;
+    uint8_t buttons;
+    uint8_t flags;
+    int16_t scroll;       // 1/120 格，QUEUE_ITEM_FINE_SCROLL 时有效
+    int16_t pan;
+    uint16_t seq;
+    uint16_t intervalUs;
+    uint32_t senderTimeUs;
+    uint32_t arrivalUs;   // 接收回调中记录的本地到达时间
+} QueueItem_t;
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "clock.h"
+#include "config.h"
+#include "jitter_buffer.h"
+#include "pipeline.h"
+#include "protocol.h"
+
+// --- 出队之后的接收路径 ---
+// 带时间戳的样本先进入抖动缓冲，到播放时间再交给管线；其余样本直接交给管线。每次唤醒时放出
+// 到期的样本，并让管线外推/保活。固件的 mouseTask 与主机上的回放（replay.h）共用这一份实现，
+// 时间来自构造时传入的时钟。除 setJitterBufferParams 外只在一个任务中调用。
+template <const ReceiverConfig& Cfg, typename Sink>
+class ReceivePath {
+public:
+    using Pipeline = MousePipeline<Cfg, Sink>;
+
+    ReceivePath(Sink& sink, const Clock& clock) : pipeline_(sink, clock), clock_(clock) {}
+
+    // 新连接建立时清空管线各阶段与抖动缓冲中残留的状态
+    void reset() {
+        pipeline_.resetMotionState();
+        jitterBuffer_.reset();
+    }
+
+    // 由其他任务调用：参数先暂存，在下一个样本处理前生效
+    void setJitterBufferParams(const JitterBufferParams& params) {
+        if constexpr (Cfg.features.jitterBuffer) {
+            portENTER_CRITICAL(&jitterBufferMux_);
+            pendingJitterBuffer_ = params;
+            jitterBufferPending_ = true;
+            portEXIT_CRITICAL(&jitterBufferMux_);
+        }
+    }
+
+    // 处理一个出队的数据项。缓冲溢出时被挤出的最早一项先交给管线，保证样本按发送顺序输出
+    void dispatch(const QueueItem_t& item) {
+        if constexpr (Cfg.features.jitterBuffer) {
+            if (jitterBufferPending_) {
+                portENTER_CRITICAL(&jitterBufferMux_);
+                jitterBuffer_.setParams(pendingJitterBuffer_);
+                jitterBufferPending_ = false;
+                portEXIT_CRITICAL(&jitterBufferMux_);
+            }
+            if (jitterBuffer_.enabled() && (item.flags & QUEUE_ITEM_HAS_TIMESTAMP)) {
+                if (item.type != PACKET_TYPE_MOUSE_DATA) {
+                    jitterBuffer_.observeClock(item);
+                } else {
+                    QueueItem_t evicted;
+                    if (jitterBuffer_.push(item, evicted)) {
+                        pipeline_.process(evicted);
+                    }
+                    return;
+                }
+            }
+        }
+        // 鼠标动作与按键由管线处理，心跳包只用于保活
+        pipeline_.process(item);
+    }
+
+    // 每次唤醒时调用：放出抖动缓冲中已到播放时间的样本，并在需要时外推
+    void poll() {
+        if constexpr (Cfg.features.jitterBuffer) {
+            QueueItem_t dueItem;
+            while (jitterBuffer_.popDue(clock_.nowUs(), dueItem)) {
+                pipeline_.process(dueItem);
+            }
+        }
+        pipeline_.poll();
+    }
+
+    // 抖动缓冲中下一个样本的播放时间；缓冲为空时返回 false
+    bool nextPlayAt(uint32_t& playAtUs) const { return jitterBuffer_.nextPlayAt(playAtUs); }
+
+    Pipeline& pipeline() { return pipeline_; }
+    const Pipeline& pipeline() const { return pipeline_; }
+    const JitterBuffer& jitterBuffer() const { return jitterBuffer_; }
+
+private:
+    Pipeline pipeline_;
+    const Clock& clock_;
+    JitterBuffer jitterBuffer_;  // features.jitterBuffer 关闭时参数保持默认（关闭），缓冲始终为空
+    JitterBufferParams pendingJitterBuffer_ = {};
+    volatile bool jitterBufferPending_ = false;
+    portMUX_TYPE jitterBufferMux_ = portMUX_INITIALIZER_UNLOCKED;
+};
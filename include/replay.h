@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "capture.h"
+#include "clock.h"
+#include "config.h"
+#include "frame_parser.h"
+#include "receive_path.h"
+
+// --- 回放 ---
+// 固件的 replay 命令把捕获送回真实的接收任务。主机上的 FrameReplayer 读取 capture dump 导出的文本，
+// 按记录的到达时间推进虚拟时钟，经同一个解析器和 ReceivePath（抖动缓冲 + 管线）生成报告，
+// 不需要设备（test/replay，pio run -e replay）。
+
+// 解析一行 capture dump 的输出：C <到达时间us> <MAC> <帧十六进制>。
+// 不是记录的行（其他日志）或格式不对的行返回 false
+bool replayParseRecord(const char* line, CaptureRecordHeader& header, uint8_t data[CAPTURE_MAX_FRAME]);
+
+// 报告摘要（FNV-1a），便于比较两个版本的输出
+class ReplayDigest {
+public:
+    void reset() {
+        hash_ = 2166136261u;
+        reports_ = 0;
+    }
+    void add(uint8_t reportId, const void* report, size_t len);
+
+    uint32_t value() const { return hash_; }
+    uint32_t reports() const { return reports_; }
+
+private:
+    uint32_t hash_ = 2166136261u;
+    uint32_t reports_ = 0;
+};
+
+// 主机回放。Sink 同管线的输出端；emit 没有上下文参数，同一时刻只能有一个实例在 feed() 中
+template <const ReceiverConfig& Cfg, typename Sink>
+class FrameReplayer {
+public:
+    explicit FrameReplayer(Sink& sink) : path_(sink, clock_) { path_.setJitterBufferParams(Cfg.jitterBuffer); }
+
+    // 送入一条记录：先把虚拟时钟推进到它的到达时间（途中像 mouseTask 一样放出到期样本、外推），
+    // 再解析并处理
+    void feed(const CaptureRecordHeader& header, const uint8_t* data) {
+        if (frames_ == 0) {
+            clock_.advanceUs(header.arrivalUs - clock_.nowUs());
+        } else {
+            runUntil(header.arrivalUs);
+        }
+        active_ = this;
+        parser_.parse(header.mac, data, header.len, header.arrivalUs, &FrameReplayer::emit);
+        active_ = nullptr;
+        frames_++;
+        path_.poll();
+    }
+
+    // 不送入新记录，按节拍把虚拟时钟推进到 us；抖动缓冲中的样本在其播放时刻放出（固件由播放定时器唤醒）
+    void runUntil(uint32_t us) {
+        while ((int32_t)(us - clock_.nowUs()) > 0) {
+            const uint32_t now = clock_.nowUs();
+            uint32_t step = us - now < POLL_STEP_US ? us - now : POLL_STEP_US;
+            uint32_t playAt;
+            if (path_.nextPlayAt(playAt) && (int32_t)(playAt - now) > 0 && playAt - now < step) {
+                step = playAt - now;
+            }
+            clock_.advanceUs(step);
+            path_.poll();
+        }
+    }
+
+    // 记录送完后再走 tailUs 的虚拟时间，放出抖动缓冲中剩余的样本
+    void finish(uint32_t tailUs) { runUntil(clock_.nowUs() + tailUs); }
+
+    const Clock& clock() const { return clock_; }
+    uint32_t frames() const { return frames_; }
+    uint32_t items() const { return items_; }
+    const FrameParser& parser() const { return parser_; }
+    ReceivePath<Cfg, Sink>& path() { return path_; }
+
+private:
+    static constexpr uint32_t POLL_STEP_US = 1000;  // mouseTask 的等待以系统节拍（1ms）为单位
+
+    static void emit(const QueueItem_t& item) {
+        active_->items_++;
+        active_->path_.dispatch(item);
+    }
+
+    VirtualClock clock_;
+    ReceivePath<Cfg, Sink> path_;
+    FrameParser parser_;
+    uint32_t frames_ = 0;
+    uint32_t items_ = 0;
+    static inline FrameReplayer* active_ = nullptr;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+// --- 单写者顺序锁 ---
+// 把一个小结构体从一个任务发布给其他任务（包括 Wi-Fi 接收回调）。写者先把序号加到奇数，写入数据，
+// 再加到偶数；读者在复制数据前后各读一次序号，两次相同且为偶数才是完整的一份，否则重读。
+// 读者不加锁，也不会让写者等待。数据按 32 位字存放在原子变量里，并发读写不构成数据竞争。
+//
+// 同一时刻只能有一个写者。写入在临界区内完成：同一个核上优先级更高的读者（接收回调与控制任务
+// 同在核 0）不会在写到一半时抢占写者，然后一直重读下去。
+
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "只能发布可按字节复制的类型");
+
+public:
+    // 写者调用
+    void store(const T& value) {
+        uint32_t words[WORDS] = {};
+        memcpy(words, &value, sizeof(T));
+        portENTER_CRITICAL(&writeMux_);
+        const uint32_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);  // 奇数序号先于数据可见
+        for (size_t i = 0; i < WORDS; i++) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+        }
+        seq_.store(seq + 2, std::memory_order_release);
+        portEXIT_CRITICAL(&writeMux_);
+    }
+
+    // 任意任务调用
+    T load() const {
+        uint32_t words[WORDS];
+        uint32_t before, after;
+        do {
+            before = seq_.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORDS; i++) {
+                words[i] = words_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);  // 数据先于第二次读序号
+            after = seq_.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+        T value;
+        memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + 3) / 4;
+
+    std::atomic<uint32_t> seq_{0};
+    std::atomic<uint32_t> words_[WORDS] = {};
+    portMUX_TYPE writeMux_ = portMUX_INITIALIZER_UNLOCKED;
+};
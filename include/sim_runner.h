@@ -0,0 +1,186 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "clock.h"
+#include "config.h"
+#include "connection.h"
+#include "link_sim.h"
+#include "replay.h"
+
+// --- 主机链路仿真 ---
+// 固件的 sim 命令按真实时间运行，一遍最长几十秒，心跳超时等也只能实测。这里用虚拟时钟驱动同一套
+// 接收代码：合成发送端 → 信道模型 → 解析器 → ReceivePath（经 FrameReplayer），连接状态机按控制任务
+// 的节拍（loopIntervalMs）用转交的数据包时刻刷新心跳、检查超时，旧发送端的下一个数据包重新建立连接，
+// 新连接清空管线残留状态，与 mouseTask 和控制任务相同。一遍只需几毫秒，相同的场景、格式和种子总是得到相同的结果（test/sim）。
+// 主机上没有通道，queueDrops 恒为 0。
+template <const ReceiverConfig& Cfg>
+class HostLinkSim {
+public:
+    void runPass(const LinkSimParams& params, SimFormat format, uint32_t durationUs, uint32_t seed,
+                 SimPassResult& result) {
+        Pass pass;
+        traffic_.reset(format, durationUs);
+        channel_.reset(params, seed);
+        inFlight_.clear();
+        result.checkpoints = 0;
+        result.reordered = 0;
+
+        const uint32_t startUs = pass.replayer.clock().nowUs();
+        uint32_t nextServiceUs = startUs;
+        for (;;) {
+            const uint32_t now = pass.replayer.clock().nowUs();
+            // 发出到时的帧，经信道决定丢弃、送达时间或重复
+            while (!traffic_.done() && (int32_t)(startUs + traffic_.nextAtUs() - now) <= 0) {
+                SimEvent event;
+                traffic_.take(event);
+                if (event.kind == SIM_EVENT_CHECKPOINT) {
+                    if (result.checkpoints < SIM_MAX_CHECKPOINTS) {
+                        result.checkX[result.checkpoints] = pass.sink.posX;
+                        result.checkY[result.checkpoints] = pass.sink.posY;
+                        result.checkpoints++;
+                    }
+                    continue;
+                }
+                const uint32_t sendUs = startUs + event.atUs;
+                uint32_t deliverUs[2];
+                const uint8_t copies = channel_.transmit(sendUs, deliverUs);
+                for (uint8_t i = 0; i < copies; i++) {
+                    inFlight_.push(deliverUs[i], sendUs, event.data, event.len);
+                }
+            }
+
+            // 送达到时的帧
+            while (inFlight_.size() > 0 && (int32_t)(inFlight_.top().deliverUs - now) <= 0) {
+                deliver(pass, inFlight_.top(), result);
+                inFlight_.pop();
+            }
+
+            // 控制任务的一拍
+            if ((int32_t)(nextServiceUs - now) <= 0) {
+                if (pass.peerPacketMs != 0) {
+                    pass.connection.heartbeat(pass.peerPacketMs);
+                    pass.peerPacketMs = 0;
+                }
+                pass.connection.service();
+                nextServiceUs += Cfg.loopIntervalMs * 1000;
+            }
+
+            if (traffic_.done() && inFlight_.size() == 0) {
+                break;
+            }
+            uint32_t nextUs = nextServiceUs;
+            if (inFlight_.size() > 0 && (int32_t)(inFlight_.top().deliverUs - nextUs) < 0) {
+                nextUs = inFlight_.top().deliverUs;
+            }
+            if (!traffic_.done() && (int32_t)(startUs + traffic_.nextAtUs() - nextUs) < 0) {
+                nextUs = startUs + traffic_.nextAtUs();
+            }
+            pass.replayer.runUntil(nextUs);
+        }
+        pass.replayer.finish(SIM_SETTLE_MS * 1000);
+
+        const FrameParser& parser = pass.replayer.parser();
+        result.sent = channel_.sent();
+        result.lost = channel_.lost();
+        result.longestBurst = channel_.longestBurst();
+        result.duplicated = channel_.duplicated();
+        result.overflows = inFlight_.overflows();
+        result.queueDrops = 0;
+        result.fecRecovered = parser.fecRecovered();
+        result.fecUnrecoverable = parser.fecUnrecoverable();
+        result.resyncs = parser.cumulativeResyncs();
+        result.disconnects = pass.connection.disconnects();
+        result.reports = pass.sink.reports;
+        result.latencyP50 = pass.sink.latency.percentileUs(50);
+        result.latencyP99 = pass.sink.latency.percentileUs(99);
+        result.latencyMax = pass.sink.latency.maxUs();
+        result.finalX = pass.sink.posX;
+        result.finalY = pass.sink.posY;
+    }
+
+    // 参照（无损）与所选场景各跑一遍
+    void run(const SimSettings& settings) {
+        runPass(kLinkSimScenarios[0].params, settings.format, settings.seconds * 1000000, settings.seed, pass_[0]);
+        runPass(settings.params, settings.format, settings.seconds * 1000000, settings.seed, pass_[1]);
+    }
+
+    const SimPassResult& reference() const { return pass_[0]; }
+    const SimPassResult& scenario() const { return pass_[1]; }
+    int32_t truthX() const { return traffic_.truthX(); }
+    int32_t truthY() const { return traffic_.truthY(); }
+
+private:
+    // 报告延迟 = 报告时刻 - 最新已送达帧的发送时刻，与固件的 sim 命令相同
+    struct Sink {
+        bool report(int16_t x, int16_t y, int16_t scroll, int16_t pan, uint8_t buttons, bool force) {
+            posX += x;
+            posY += y;
+            reports++;
+            if (delivered) {
+                latency.add(clock->nowUs() - newestSendUs);
+            }
+            return true;
+        }
+
+        const Clock* clock = nullptr;
+        LatencyHistogram latency;
+        int32_t posX = 0, posY = 0;
+        uint32_t reports = 0;
+        uint32_t newestSendUs = 0;
+        bool delivered = false;
+    };
+
+    // 仿真中不广播，也没有对等设备可增删
+    struct SilentEvents final : ConnectionEvents {
+        void onConnected(const uint8_t mac[6], const LinkMode& mode) override {}
+        void onDisconnected(const uint8_t mac[6], DisconnectReason reason) override {}
+        void onBeacon() override {}
+    };
+
+    struct Pass {
+        Pass() : replayer(sink), connection({Cfg.connectionTimeoutMs, Cfg.beaconIntervalMs}, replayer.clock(), events) {
+            sink.clock = &replayer.clock();
+        }
+
+        Sink sink;
+        FrameReplayer<Cfg, Sink> replayer;
+        SilentEvents events;
+        ConnectionManager connection;
+        uint32_t seenGeneration = 0;
+        uint32_t peerPacketMs = 0;  // 待转交给连接状态机的心跳时刻（0 = 没有新的）
+    };
+
+    void deliver(Pass& pass, const SimDelivery& frame, SimPassResult& result) {
+        if (pass.sink.delivered && (int32_t)(frame.sendUs - pass.sink.newestSendUs) < 0) {
+            result.reordered++;
+        } else {
+            pass.sink.newestSendUs = frame.sendUs;
+            pass.sink.delivered = true;
+        }
+        // 与 mouseTask 相同：对端的数据包记下心跳时刻，下一拍转交；未连接时由控制任务（收到消息立即处理）
+        // 以旧发送端的数据包重新建立连接
+        const ConnectionSnapshot link = pass.connection.snapshot();
+        if (link.isPeer(SIM_PEER_MAC)) {
+            pass.peerPacketMs = pass.replayer.clock().nowMs();
+        } else if (!link.connected) {
+            pass.connection.packetSeen(SIM_PEER_MAC);
+        }
+        if (pass.seenGeneration != pass.connection.generation()) {
+            pass.seenGeneration = pass.connection.generation();
+            pass.replayer.path().reset();
+        }
+        CaptureRecordHeader header;
+        header.arrivalUs = frame.deliverUs;
+        memcpy(header.mac, SIM_PEER_MAC, 6);
+        header.len = frame.len;
+        header.flags = 0;
+        pass.replayer.feed(header, frame.data);
+    }
+
+    SimTrafficSource traffic_;
+    LinkSimChannel channel_;
+    SimDeliveryQueue inFlight_;
+    SimPassResult pass_[2];
+};
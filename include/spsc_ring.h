@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// --- 单生产者/单消费者无锁环形队列 ---
+// 接收路径（Wi-Fi 任务，核 0）与 HID 输出任务（核 1）之间的数据通道。两端各自只写自己的下标，
+// 用 acquire/release 配对保证槽位内容先于下标可见，入队/出队都不进临界区、不调用内核。
+// 消费者没有数据时阻塞在任务通知上，由生产者入队后唤醒（见 main.cpp）。
+//
+// 同一时刻只能有一个生产者和一个消费者；切换生产者（如回放接管解析路径）时由调用方保证
+// 前一个生产者已经退出。size() 可在任意任务中调用，结果只是近似值。
+
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "容量必须是 2 的幂");
+
+public:
+    static constexpr size_t capacity() { return N; }
+
+    // 生产者调用；满时返回 false
+    bool push(const T& item) {
+        const uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == N) {
+            return false;
+        }
+        slots_[tail & (N - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者调用；空时返回 false
+    bool pop(T& out) {
+        const uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        out = slots_[head & (N - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        const uint32_t head = head_.load(std::memory_order_acquire);
+        return tail_.load(std::memory_order_acquire) - head;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    // 两个下标分属不同的核，放在不同的缓存行（32 字节）避免互相失效
+    alignas(32) std::atomic<uint32_t> head_{0};
+    alignas(32) std::atomic<uint32_t> tail_{0};
+    T slots_[N];
+};
@@ -0,0 +1,132 @@
+#include <Arduino.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "accel.h"
+
+static uint16_t gainToQ12(float gain) {
+    if (gain < 0.0f) gain = 0.0f;
+    if (gain > ACCEL_MAX_GAIN) gain = ACCEL_MAX_GAIN;
+    return (uint16_t)lroundf(gain * ACCEL_GAIN_ONE);
+}
+
+static float piecewiseGain(const AccelCurveParams& params, float speed) {
+    const AccelPoint* p = params.points;
+    if (speed <= p[0].speed) {
+        return p[0].gain;
+    }
+    for (uint8_t i = 1; i < params.pointCount; i++) {
+        if (speed <= p[i].speed) {
+            float t = (speed - p[i - 1].speed) / (float)(p[i].speed - p[i - 1].speed);
+            return p[i - 1].gain + t * (p[i].gain - p[i - 1].gain);
+        }
+    }
+    return p[params.pointCount - 1].gain;
+}
+
+bool buildAccelCurve(const AccelCurveParams& params, AccelCurve& out) {
+    if (params.sensitivity < 0.0f) {
+        return false;
+    }
+    if (params.type == ACCEL_CURVE_POWER && params.refSpeed <= 0.0f) {
+        return false;
+    }
+    if (params.type == ACCEL_CURVE_PIECEWISE) {
+        if (params.pointCount == 0 || params.pointCount > ACCEL_MAX_POINTS) {
+            return false;
+        }
+        // 控制点必须按速度严格递增
+        for (uint8_t i = 1; i < params.pointCount; i++) {
+            if (params.points[i].speed <= params.points[i - 1].speed) {
+                return false;
+            }
+        }
+    }
+
+    AccelCurve curve;
+    for (size_t i = 0; i < ACCEL_LUT_SIZE; i++) {
+        const float speed = (float)i;
+        float gain;
+        switch (params.type) {
+            case ACCEL_CURVE_LINEAR:
+                gain = params.sensitivity + params.slope * speed;
+                break;
+            case ACCEL_CURVE_POWER:
+                gain = params.sensitivity * powf(fmaxf(speed, 1.0f) / params.refSpeed, params.exponent - 1.0f);
+                break;
+            case ACCEL_CURVE_PIECEWISE:
+                gain = piecewiseGain(params, speed);
+                break;
+            default:
+                return false;
+        }
+        curve.gain[i] = gainToQ12(gain);
+    }
+    out = curve;
+    return true;
+}
+
+bool accelParsePoint(const char* token, AccelPoint& out) {
+    const char* sep = strchr(token, ':');
+    if (sep == NULL || sep == token || sep[1] == '\0') {
+        return false;
+    }
+    char* end;
+    const long speed = strtol(token, &end, 10);
+    if (end != sep || speed < 0 || speed > UINT8_MAX) {
+        return false;
+    }
+    const float gain = strtof(sep + 1, &end);
+    if (*end != '\0' || !(gain >= 0.0f && gain <= ACCEL_MAX_GAIN)) {
+        return false;
+    }
+    out.speed = (uint8_t)speed;
+    out.gain = gain;
+    return true;
+}
+
+void printAccelCurveParams(const AccelCurveParams& params) {
+    switch (params.type) {
+        case ACCEL_CURVE_LINEAR:
+            Serial.printf("加速曲线: linear 灵敏度=%.3f 斜率=%.4f\n", params.sensitivity, params.slope);
+            break;
+        case ACCEL_CURVE_POWER:
+            Serial.printf("加速曲线: power 灵敏度=%.3f 指数=%.3f 参考速度=%.1f\n",
+                          params.sensitivity, params.exponent, params.refSpeed);
+            break;
+        case ACCEL_CURVE_PIECEWISE:
+            Serial.print("加速曲线: piecewise");
+            for (uint8_t i = 0; i < params.pointCount; i++) {
+                Serial.printf(" %u:%.3f", params.points[i].speed, params.points[i].gain);
+            }
+            Serial.println();
+            break;
+    }
+}
+
+float benchAccel(const AccelCurve& curve, uint32_t samples) {
+    AccelEngine engine;
+    engine.setCurve(curve);
+
+    // 固定种子的 LCG，保证每次运行输入一致；速度分布覆盖整张查找表
+    uint32_t seed = 12345;
+    volatile int32_t sink = 0;
+    int32_t sum = 0;
+
+    const uint32_t start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < samples; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        int16_t dx = (int16_t)((int8_t)(seed >> 24) >> 1);
+        int16_t dy = (int16_t)((int8_t)(seed >> 16) >> 1);
+        engine.apply(dx, dy);
+        sum += dx + dy;
+    }
+    const uint32_t cycles = ESP.getCycleCount() - start;
+    sink = sum;
+    (void)sink;
+
+    const float perSample = (float)cycles / samples;
+    Serial.printf("[基准] 加速: %u 样本, %u 周期, %.1f 周期/样本 (含输入生成)\n", samples, cycles, perSample);
+    return perSample;
+}
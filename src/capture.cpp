@@ -0,0 +1,295 @@
+#include <Arduino.h>
+#include <esp_partition.h>
+
+#include "capture.h"
+
+alignas(4) static uint8_t ring[CAPTURE_RAM_SIZE];
+static size_t ringHead = 0;    // 下一条记录的写入位置
+static size_t ringTail = 0;    // 最旧记录的位置
+static size_t ringUsed = 0;    // 从 tail 到 head 的字节数（含回绕浪费的部分）
+static uint32_t ringRecords = 0;
+static portMUX_TYPE ringMux = portMUX_INITIALIZER_UNLOCKED;
+
+static volatile CaptureMode captureMode = CAPTURE_OFF;
+static CaptureMode lastMode = CAPTURE_OFF;  // 最近一次捕获的存放位置，供回放/导出
+static volatile uint32_t captured = 0;
+static volatile uint32_t dropped = 0;
+static volatile uint32_t evicted = 0;
+
+static const esp_partition_t* flashPartition = NULL;
+static uint32_t flashLimit = 0;        // 本次捕获可用的字节数（含第 0 扇区）
+static uint32_t flashOffset = 0;       // 下一个写入位置
+static uint32_t flashRecords = 0;
+static uint8_t staging[1024];
+static size_t stagingLen = 0;
+static bool flashOpen = false;         // 已开始写入、尚未写文件头
+
+static size_t recordSize(const CaptureRecordHeader& h) {
+    return sizeof(CaptureRecordHeader) + h.len;
+}
+
+// RAM 环形缓冲中的记录按 4 字节对齐，记录头可以直接原地访问
+static size_t ringRecordSize(const CaptureRecordHeader& h) {
+    return (recordSize(h) + 3) & ~(size_t)3;
+}
+
+// 指向 pos 处的记录头；需要回绕时先跳到缓冲起点
+static size_t ringNormalize(size_t pos) {
+    if (CAPTURE_RAM_SIZE - pos < sizeof(CaptureRecordHeader)) {
+        return 0;
+    }
+    const CaptureRecordHeader* h = (const CaptureRecordHeader*)&ring[pos];
+    return (h->flags & CAPTURE_RECORD_WRAP) ? 0 : pos;
+}
+
+// 丢弃最旧的一条记录（调用方持有 ringMux）
+static void ringEvict() {
+    const size_t pos = ringNormalize(ringTail);
+    if (pos != ringTail) {
+        ringUsed -= CAPTURE_RAM_SIZE - ringTail;
+        ringTail = 0;
+    }
+    const CaptureRecordHeader* h = (const CaptureRecordHeader*)&ring[ringTail];
+    const size_t n = ringRecordSize(*h);
+    ringTail += n;
+    ringUsed -= n;
+    ringRecords--;
+}
+
+// 取出最旧的一条记录（调用方持有 ringMux）
+static bool ringPop(CaptureRecordHeader& header, uint8_t* data) {
+    if (ringRecords == 0) {
+        return false;
+    }
+    const size_t pos = ringNormalize(ringTail);
+    if (pos != ringTail) {
+        ringUsed -= CAPTURE_RAM_SIZE - ringTail;
+        ringTail = 0;
+    }
+    memcpy(&header, &ring[ringTail], sizeof(header));
+    memcpy(data, &ring[ringTail + sizeof(header)], header.len);
+    ringEvict();
+    return true;
+}
+
+void captureFrame(const uint8_t mac[6], const uint8_t* data, int len, uint32_t arrivalUs) {
+    const CaptureMode mode = captureMode;
+    if (mode == CAPTURE_OFF || len <= 0 || len > (int)CAPTURE_MAX_FRAME) {
+        return;
+    }
+    CaptureRecordHeader h;
+    h.arrivalUs = arrivalUs;
+    memcpy(h.mac, mac, 6);
+    h.len = (uint8_t)len;
+    h.flags = 0;
+    const size_t n = ringRecordSize(h);
+
+    portENTER_CRITICAL_ISR(&ringMux);
+    if (ringRecords == 0) {
+        ringHead = ringTail = ringUsed = 0;
+    }
+    const size_t waste = (CAPTURE_RAM_SIZE - ringHead < n) ? CAPTURE_RAM_SIZE - ringHead : 0;
+    while (ringRecords > 0 && ringUsed + waste + n > CAPTURE_RAM_SIZE && mode == CAPTURE_RAM) {
+        ringEvict();
+        evicted++;
+    }
+    if (ringUsed + waste + n > CAPTURE_RAM_SIZE) {
+        dropped++;
+        portEXIT_CRITICAL_ISR(&ringMux);
+        return;
+    }
+    if (waste > 0) {
+        if (waste >= sizeof(CaptureRecordHeader)) {
+            ((CaptureRecordHeader*)&ring[ringHead])->flags = CAPTURE_RECORD_WRAP;
+        }
+        ringUsed += waste;
+        ringHead = 0;
+    }
+    memcpy(&ring[ringHead], &h, sizeof(h));
+    memcpy(&ring[ringHead + sizeof(h)], data, len);
+    ringHead += n;
+    ringUsed += n;
+    ringRecords++;
+    captured++;
+    portEXIT_CRITICAL_ISR(&ringMux);
+}
+
+static void flushStaging() {
+    if (stagingLen == 0) {
+        return;
+    }
+    esp_partition_write(flashPartition, flashOffset, staging, stagingLen);
+    flashOffset += stagingLen;
+    stagingLen = 0;
+}
+
+// 把 RAM 中的记录搬到暂存区并写入闪存；写满时返回 false
+static bool drainToFlash() {
+    CaptureRecordHeader h;
+    uint8_t data[CAPTURE_MAX_FRAME];
+    for (;;) {
+        portENTER_CRITICAL(&ringMux);
+        const bool ok = ringPop(h, data);
+        portEXIT_CRITICAL(&ringMux);
+        if (!ok) {
+            return true;
+        }
+        const size_t n = recordSize(h);
+        if (flashOffset + stagingLen + n > flashLimit) {
+            dropped++;
+            return false;
+        }
+        if (stagingLen + n > sizeof(staging)) {
+            flushStaging();
+        }
+        memcpy(staging + stagingLen, &h, sizeof(h));
+        memcpy(staging + stagingLen + sizeof(h), data, h.len);
+        stagingLen += n;
+        flashRecords++;
+    }
+}
+
+static void finalizeFlash() {
+    drainToFlash();
+    flushStaging();
+    const CaptureFileHeader header = {CAPTURE_MAGIC, CAPTURE_VERSION, flashRecords,
+                                      flashOffset - CAPTURE_FLASH_DATA_OFFSET};
+    esp_partition_write(flashPartition, 0, &header, sizeof(header));
+    flashOpen = false;
+}
+
+void captureService() {
+    if (!flashOpen) {
+        return;
+    }
+    if (!drainToFlash()) {
+        captureMode = CAPTURE_OFF;
+        finalizeFlash();
+        Serial.println("捕获：闪存已写满，自动停止。");
+    }
+}
+
+bool captureStart(CaptureMode mode, uint32_t flashBytes) {
+    if (captureMode != CAPTURE_OFF || mode == CAPTURE_OFF) {
+        return false;
+    }
+    portENTER_CRITICAL(&ringMux);
+    ringHead = ringTail = ringUsed = 0;
+    ringRecords = 0;
+    portEXIT_CRITICAL(&ringMux);
+    captured = dropped = evicted = 0;
+
+    if (mode == CAPTURE_FLASH) {
+        flashPartition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, NULL);
+        if (flashPartition == NULL) {
+            Serial.println("错误：未找到 spiffs 分区。");
+            return false;
+        }
+        // 只擦除本次需要的范围，按 64KB 对齐
+        uint32_t limit = CAPTURE_FLASH_DATA_OFFSET + flashBytes;
+        limit = (limit + 0xFFFF) & ~0xFFFFu;
+        if (limit > flashPartition->size) {
+            limit = flashPartition->size;
+        }
+        Serial.printf("捕获：正在擦除 %uKB 闪存...\n", limit / 1024);
+        if (esp_partition_erase_range(flashPartition, 0, limit) != ESP_OK) {
+            Serial.println("错误：擦除闪存失败。");
+            return false;
+        }
+        flashLimit = limit;
+        flashOffset = CAPTURE_FLASH_DATA_OFFSET;
+        flashRecords = 0;
+        stagingLen = 0;
+        flashOpen = true;
+    }
+    lastMode = mode;
+    captureMode = mode;
+    return true;
+}
+
+void captureStop() {
+    captureMode = CAPTURE_OFF;
+    if (flashOpen) {
+        finalizeFlash();
+    }
+}
+
+bool captureActive() {
+    return captureMode != CAPTURE_OFF;
+}
+
+void capturePrintStatus() {
+    static const char* names[] = {"关", "RAM", "闪存"};
+    Serial.printf("捕获: %s 已记录 %u 帧 覆盖 %u 丢弃 %u", names[captureMode], captured, evicted, dropped);
+    if (lastMode == CAPTURE_FLASH) {
+        Serial.printf(" 闪存 %u 条 %u/%u 字节", flashRecords, flashOffset, flashLimit);
+    } else {
+        Serial.printf(" 缓冲 %u 条 %u 字节", ringRecords, (unsigned)ringUsed);
+    }
+    Serial.println();
+}
+
+bool CaptureReader::open(CaptureMode source) {
+    if (captureMode != CAPTURE_OFF) {
+        return false;
+    }
+    source_ = source;
+    if (source == CAPTURE_RAM) {
+        pos_ = ringTail;
+        remaining_ = ringRecords;
+        return true;
+    }
+    if (source == CAPTURE_FLASH) {
+        flashPartition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, NULL);
+        CaptureFileHeader header;
+        if (flashPartition == NULL || esp_partition_read(flashPartition, 0, &header, sizeof(header)) != ESP_OK ||
+            header.magic != CAPTURE_MAGIC || header.version != CAPTURE_VERSION) {
+            return false;
+        }
+        pos_ = CAPTURE_FLASH_DATA_OFFSET;
+        remaining_ = header.records;
+        return true;
+    }
+    return false;
+}
+
+bool CaptureReader::next(CaptureRecordHeader& header, uint8_t data[CAPTURE_MAX_FRAME]) {
+    if (remaining_ == 0) {
+        return false;
+    }
+    if (source_ == CAPTURE_RAM) {
+        pos_ = ringNormalize(pos_);
+        memcpy(&header, &ring[pos_], sizeof(header));
+        memcpy(data, &ring[pos_ + sizeof(header)], header.len);
+    } else {
+        if (esp_partition_read(flashPartition, pos_, &header, sizeof(header)) != ESP_OK ||
+            esp_partition_read(flashPartition, pos_ + sizeof(header), data, header.len) != ESP_OK) {
+            return false;
+        }
+    }
+    pos_ += (source_ == CAPTURE_RAM) ? ringRecordSize(header) : recordSize(header);
+    remaining_--;
+    return true;
+}
+
+void captureDump(CaptureMode source) {
+    CaptureReader reader;
+    if (!reader.open(source)) {
+        Serial.println("错误：没有可导出的捕获（捕获进行中或闪存中无数据）。");
+        return;
+    }
+    // 每行：C <到达时间us> <MAC> <帧十六进制>
+    CaptureRecordHeader h;
+    uint8_t data[CAPTURE_MAX_FRAME];
+    uint32_t count = 0;
+    while (reader.next(h, data)) {
+        Serial.printf("C %u %02X%02X%02X%02X%02X%02X ", h.arrivalUs, h.mac[0], h.mac[1], h.mac[2], h.mac[3],
+                      h.mac[4], h.mac[5]);
+        for (uint8_t i = 0; i < h.len; i++) {
+            Serial.printf("%02X", data[i]);
+        }
+        Serial.println();
+        count++;
+    }
+    Serial.printf("导出完成，共 %u 帧。\n", count);
+}
@@ -0,0 +1,67 @@
+#include <Arduino.h>
+
+#include "connection.h"
+
+bool ConnectionManager::packetSeen(const uint8_t mac[6]) {
+    if (connected_) {
+        if (isPeer(mac)) {
+            lastPacketMs_ = clock_.nowMs();
+        }
+        return false;
+    }
+    connect(mac, legacyLinkMode());
+    return true;
+}
+
+void ConnectionManager::heartbeat(uint32_t atMs) {
+    if (connected_ && (int32_t)(atMs - lastPacketMs_) > 0) {
+        lastPacketMs_ = atMs;
+    }
+}
+
+void ConnectionManager::connect(const uint8_t mac[6], const LinkMode& mode) {
+    memcpy(peer_, mac, 6);
+    mode_ = mode;
+    lastPacketMs_ = clock_.nowMs();
+    events_.onConnected(peer_, mode_);
+    generation_++;
+    connected_ = true;
+    publish();
+}
+
+void ConnectionManager::disconnect(DisconnectReason reason) {
+    events_.onDisconnected(peer_, reason);
+    connected_ = false;
+    disconnects_++;
+    mode_ = legacyLinkMode();
+    memset(peer_, 0, 6);
+    publish();
+}
+
+void ConnectionManager::pause() {
+    connected_ = false;
+    publish();
+}
+
+void ConnectionManager::service() {
+    const uint32_t now = clock_.nowMs();
+    if (!connected_) {
+        if (now - lastBeaconMs_ >= params_.beaconIntervalMs) {
+            lastBeaconMs_ = now;
+            beacons_++;
+            events_.onBeacon();
+        }
+    } else if ((int32_t)(now - lastPacketMs_) > (int32_t)params_.timeoutMs) {
+        // 有符号比较：心跳时间可能晚于 now（数据包在取 now 之后刚到达）
+        disconnect(DISCONNECT_TIMEOUT);
+    }
+}
+
+void ConnectionManager::publish() {
+    ConnectionSnapshot snapshot = {};
+    snapshot.generation = generation_;
+    snapshot.disconnects = disconnects_;
+    memcpy(snapshot.peer, peer_, 6);
+    snapshot.connected = connected_;
+    published_.store(snapshot);
+}
@@ -0,0 +1,66 @@
+#include <Arduino.h>
+#include <string.h>
+
+#include "console.h"
+
+static void printHelp(const ConsoleCommand* commands, size_t count) {
+    Serial.println("可用命令：");
+    for (size_t i = 0; i < count; i++) {
+        Serial.printf("  %s %s\n", commands[i].name, commands[i].usage);
+    }
+}
+
+static void dispatch(char* line, const ConsoleCommand* commands, size_t count) {
+    char* argv[CONSOLE_MAX_ARGS];
+    int argc = 0;
+    for (char* tok = strtok(line, " \t"); tok != NULL && argc < (int)CONSOLE_MAX_ARGS; tok = strtok(NULL, " \t")) {
+        argv[argc++] = tok;
+    }
+    if (argc == 0) {
+        return;
+    }
+    if (strcmp(argv[0], "help") == 0) {
+        printHelp(commands, count);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(argv[0], commands[i].name) == 0) {
+            commands[i].handler(argc, argv);
+            return;
+        }
+    }
+    Serial.printf("未知命令: %s（输入 help 查看可用命令）\n", argv[0]);
+}
+
+bool parseMacAddress(const char* text, uint8_t mac[6]) {
+    unsigned int b[6];
+    char tail;
+    if (sscanf(text, "%x:%x:%x:%x:%x:%x%c", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5], &tail) != 6) {
+        return false;
+    }
+    for (int i = 0; i < 6; i++) {
+        if (b[i] > 0xFF) {
+            return false;
+        }
+        mac[i] = (uint8_t)b[i];
+    }
+    return true;
+}
+
+void consolePoll(const ConsoleCommand* commands, size_t count) {
+    static char line[128];
+    static size_t len = 0;
+
+    while (Serial.available() > 0) {
+        int c = Serial.read();
+        if (c == '\r' || c == '\n') {
+            if (len > 0) {
+                line[len] = '\0';
+                dispatch(line, commands, count);
+                len = 0;
+            }
+        } else if (len < sizeof(line) - 1) {
+            line[len++] = (char)c;
+        }
+    }
+}
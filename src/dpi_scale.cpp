@@ -0,0 +1,148 @@
+#include <Arduino.h>
+#include <nvs.h>
+#include <math.h>
+
+#include "dpi_scale.h"
+
+static const char* NVS_NAMESPACE = "cymouse";
+static const char* NVS_KEY_DPI = "dpi";
+
+bool dpiScaleFromFloat(float scale, int32_t& out) {
+    if (!(scale >= 0.0f && scale <= DPI_SCALE_MAX)) {
+        return false;
+    }
+    out = (int32_t)lroundf(scale * DPI_SCALE_ONE);
+    return true;
+}
+
+static int findEntry(const DpiScaleTable& table, const uint8_t mac[6]) {
+    for (uint8_t i = 0; i < table.count; i++) {
+        if (memcmp(table.entries[i].mac, mac, 6) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void dpiTableLookup(const DpiScaleTable& table, const uint8_t mac[6], int32_t& scaleX, int32_t& scaleY) {
+    int idx = findEntry(table, mac);
+    if (idx >= 0) {
+        scaleX = table.entries[idx].scaleX;
+        scaleY = table.entries[idx].scaleY;
+    } else {
+        scaleX = table.defaultX;
+        scaleY = table.defaultY;
+    }
+}
+
+bool dpiTableSet(DpiScaleTable& table, const uint8_t* mac, int32_t scaleX, int32_t scaleY) {
+    if (mac == NULL) {
+        table.defaultX = scaleX;
+        table.defaultY = scaleY;
+        return true;
+    }
+    int idx = findEntry(table, mac);
+    if (idx < 0) {
+        if (table.count >= DPI_MAX_PEERS) {
+            return false;
+        }
+        idx = table.count++;
+        memcpy(table.entries[idx].mac, mac, 6);
+    }
+    table.entries[idx].scaleX = scaleX;
+    table.entries[idx].scaleY = scaleY;
+    return true;
+}
+
+bool dpiTableRemove(DpiScaleTable& table, const uint8_t* mac) {
+    if (mac == NULL) {
+        table.defaultX = DPI_SCALE_ONE;
+        table.defaultY = DPI_SCALE_ONE;
+        return true;
+    }
+    int idx = findEntry(table, mac);
+    if (idx < 0) {
+        return false;
+    }
+    table.entries[idx] = table.entries[--table.count];
+    return true;
+}
+
+void dpiTableReset(DpiScaleTable& table) {
+    memset(&table, 0, sizeof(table));
+    table.version = DPI_TABLE_VERSION;
+    table.defaultX = DPI_SCALE_ONE;
+    table.defaultY = DPI_SCALE_ONE;
+}
+
+uint8_t dpiTableSanitize(DpiScaleTable& table) {
+    uint8_t fixed = 0;
+    if (!dpiScaleIsValid(table.defaultX) || !dpiScaleIsValid(table.defaultY)) {
+        table.defaultX = DPI_SCALE_ONE;
+        table.defaultY = DPI_SCALE_ONE;
+        fixed++;
+    }
+    for (uint8_t i = 0; i < table.count; i++) {
+        DpiScaleEntry& e = table.entries[i];
+        if (!dpiScaleIsValid(e.scaleX) || !dpiScaleIsValid(e.scaleY)) {
+            e.scaleX = DPI_SCALE_ONE;
+            e.scaleY = DPI_SCALE_ONE;
+            fixed++;
+        }
+    }
+    return fixed;
+}
+
+void dpiTablePrint(const DpiScaleTable& table) {
+    Serial.printf("DPI 缩放 默认: X=%.4f Y=%.4f\n",
+                  (float)table.defaultX / DPI_SCALE_ONE, (float)table.defaultY / DPI_SCALE_ONE);
+    for (uint8_t i = 0; i < table.count; i++) {
+        const DpiScaleEntry& e = table.entries[i];
+        Serial.printf("  %02X:%02X:%02X:%02X:%02X:%02X X=%.4f Y=%.4f\n",
+                      e.mac[0], e.mac[1], e.mac[2], e.mac[3], e.mac[4], e.mac[5],
+                      (float)e.scaleX / DPI_SCALE_ONE, (float)e.scaleY / DPI_SCALE_ONE);
+    }
+}
+
+bool dpiTableLoad(DpiScaleTable& table) {
+    dpiTableReset(table);
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        return false; // 首次启动时命名空间尚不存在
+    }
+    DpiScaleTable stored;
+    size_t len = sizeof(stored);
+    err = nvs_get_blob(handle, NVS_KEY_DPI, &stored, &len);
+    nvs_close(handle);
+
+    if (err != ESP_OK || len != sizeof(stored) || stored.version != DPI_TABLE_VERSION || stored.count > DPI_MAX_PEERS) {
+        return false;
+    }
+    table = stored;
+    const uint8_t fixed = dpiTableSanitize(table);
+    if (fixed != 0) {
+        Serial.printf("警告：DPI缩放表中 %u 项系数损坏，已恢复为 1.0\n", fixed);
+    }
+    return true;
+}
+
+bool dpiTableSave(const DpiScaleTable& table) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        Serial.printf("错误：打开NVS失败 (%s)\n", esp_err_to_name(err));
+        return false;
+    }
+    err = nvs_set_blob(handle, NVS_KEY_DPI, &table, sizeof(table));
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        Serial.printf("错误：保存DPI缩放表失败 (%s)\n", esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,186 @@
+#include <esp_now.h>
+
+#include "frame_auth.h"
+
+#define ROTL64(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+static inline uint64_t load64le(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v)); // ESP32-S3 为小端
+    return v;
+}
+
+static inline void sipRound(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3) {
+    v0 += v1; v1 = ROTL64(v1, 13); v1 ^= v0; v0 = ROTL64(v0, 32);
+    v2 += v3; v3 = ROTL64(v3, 16); v3 ^= v2;
+    v0 += v3; v3 = ROTL64(v3, 21); v3 ^= v0;
+    v2 += v1; v1 = ROTL64(v1, 17); v1 ^= v2; v2 = ROTL64(v2, 32);
+}
+
+uint64_t siphash24(const uint8_t key[FRAME_KEY_SIZE], const uint8_t* data, size_t len) {
+    const uint64_t k0 = load64le(key);
+    const uint64_t k1 = load64le(key + 8);
+    uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+    uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+    uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+    uint64_t v3 = 0x7465646279746573ULL ^ k1;
+
+    const uint8_t* end = data + (len & ~(size_t)7);
+    for (const uint8_t* p = data; p != end; p += 8) {
+        const uint64_t m = load64le(p);
+        v3 ^= m;
+        sipRound(v0, v1, v2, v3);
+        sipRound(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+
+    uint8_t tail[8] = {};
+    memcpy(tail, end, len & 7);
+    const uint64_t b = ((uint64_t)len << 56) | load64le(tail);
+    v3 ^= b;
+    sipRound(v0, v1, v2, v3);
+    sipRound(v0, v1, v2, v3);
+    v0 ^= b;
+
+    v2 ^= 0xff;
+    for (int i = 0; i < 4; i++) {
+        sipRound(v0, v1, v2, v3);
+    }
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+void frameAuthSign(const uint8_t key[FRAME_KEY_SIZE], uint32_t extSeq, const uint8_t* data, size_t len,
+                   uint8_t tag[FRAME_TAG_SIZE]) {
+    uint8_t message[4 + ESP_NOW_MAX_DATA_LEN];
+    if (len > ESP_NOW_MAX_DATA_LEN) {
+        len = ESP_NOW_MAX_DATA_LEN;
+    }
+    memcpy(message, &extSeq, 4);
+    memcpy(message + 4, data, len);
+    const uint64_t hash = siphash24(key, message, 4 + len);
+    memcpy(tag, &hash, FRAME_TAG_SIZE);
+}
+
+void FrameAuthenticator::install(const uint8_t mac[6], const uint8_t key[FRAME_KEY_SIZE]) {
+    portENTER_CRITICAL(&mux_);
+    memcpy(mac_, mac, 6);
+    memcpy(key_, key, FRAME_KEY_SIZE);
+    memset(windows_, 0, sizeof(windows_));
+    generation_++;
+    active_ = true;
+    portEXIT_CRITICAL(&mux_);
+}
+
+void FrameAuthenticator::clear() {
+    portENTER_CRITICAL(&mux_);
+    active_ = false;
+    generation_++;
+    memset(key_, 0, sizeof(key_));
+    portEXIT_CRITICAL(&mux_);
+}
+
+// 取与已接受最大序号最接近的扩展序号
+uint32_t FrameAuthenticator::extendSeq(const ReplayWindow& w, uint16_t seq) {
+    uint32_t extSeq = (w.highest & 0xFFFF0000u) | seq;
+    const int32_t delta = (int32_t)(extSeq - w.highest);
+    if (w.started && delta > 0x8000 && extSeq >= 0x10000u) {
+        extSeq -= 0x10000u;
+    } else if (w.started && delta < -0x8000) {
+        extSeq += 0x10000u;
+    }
+    return extSeq;
+}
+
+// 滑动窗口：新序号前移窗口，窗口内未出现过的旧序号补记，其余为重放
+bool FrameAuthenticator::acceptSeq(ReplayWindow& w, uint32_t extSeq) {
+    if (!w.started || extSeq > w.highest) {
+        const uint32_t shift = w.started ? extSeq - w.highest : FRAME_REPLAY_WINDOW;
+        w.bits = shift >= FRAME_REPLAY_WINDOW ? 1 : (w.bits << shift) | 1;
+        w.highest = extSeq;
+        w.started = true;
+        return true;
+    }
+    const uint32_t age = w.highest - extSeq;
+    if (age >= FRAME_REPLAY_WINDOW || (w.bits & (1ULL << age))) {
+        return false;
+    }
+    w.bits |= 1ULL << age;
+    return true;
+}
+
+bool FrameAuthenticator::verify(const uint8_t mac[6], const uint8_t* data, size_t len) {
+    if (len < 3 + FRAME_TAG_SIZE || len - FRAME_TAG_SIZE > ESP_NOW_MAX_DATA_LEN) {
+        return false;
+    }
+    const size_t bodyLen = len - FRAME_TAG_SIZE;
+    const uint16_t seq = (uint16_t)(data[1] | (data[2] << 8));
+    const size_t space = data[0] == PACKET_TYPE_KEYBOARD ? 1 : 0;
+
+    // 快照：对端、密钥和推算扩展序号所需的窗口状态
+    uint8_t key[FRAME_KEY_SIZE];
+    portENTER_CRITICAL_ISR(&mux_);
+    if (!active_ || memcmp(mac, mac_, 6) != 0) {
+        portEXIT_CRITICAL_ISR(&mux_);
+        return false;
+    }
+    const uint32_t generation = generation_;
+    const uint32_t extSeq = extendSeq(windows_[space], seq);
+    memcpy(key, key_, FRAME_KEY_SIZE);
+    portEXIT_CRITICAL_ISR(&mux_);
+
+    uint8_t expected[FRAME_TAG_SIZE];
+    frameAuthSign(key, extSeq, data, bodyLen, expected);
+    memset(key, 0, sizeof(key));
+    uint8_t diff = 0;
+    for (size_t i = 0; i < FRAME_TAG_SIZE; i++) {
+        diff |= expected[i] ^ data[bodyLen + i];
+    }
+
+    portENTER_CRITICAL_ISR(&mux_);
+    if (generation != generation_) {
+        // 计算期间密钥被更换或清除：按旧密钥验证的结果作废
+        portEXIT_CRITICAL_ISR(&mux_);
+        return false;
+    }
+    if (diff != 0) {
+        forged_++;
+        portEXIT_CRITICAL_ISR(&mux_);
+        return false;
+    }
+    const bool accept = acceptSeq(windows_[space], extSeq);
+    if (!accept) {
+        replayed_++;
+    }
+    portEXIT_CRITICAL_ISR(&mux_);
+    return accept;
+}
+
+void benchFrameAuth(uint32_t samples) {
+    static const uint8_t mac[6] = {0x02, 0, 0, 0, 0, 0x01};
+    static const size_t sizes[] = {sizeof(MotionPacket), sizeof(MotionFecPacket), 64};
+    uint8_t key[FRAME_KEY_SIZE];
+    for (size_t i = 0; i < sizeof(key); i++) {
+        key[i] = (uint8_t)(i * 17 + 3);
+    }
+
+    for (size_t size : sizes) {
+        FrameAuthenticator auth;
+        auth.install(mac, key);
+        uint8_t frame[64 + FRAME_TAG_SIZE] = {};
+        frame[0] = PACKET_TYPE_MOTION;
+        uint32_t cycles = 0, rejected = 0;
+        for (uint32_t i = 0; i < samples; i++) {
+            frame[1] = (uint8_t)i;
+            frame[2] = (uint8_t)(i >> 8);
+            frameAuthSign(key, i, frame, size, frame + size);
+            const uint32_t start = ESP.getCycleCount();
+            const bool ok = auth.verify(mac, frame, size + FRAME_TAG_SIZE);
+            cycles += ESP.getCycleCount() - start;
+            if (!ok) {
+                rejected++;
+            }
+        }
+        Serial.printf("[基准] 帧认证 %u+%u 字节: %u 帧, 验证 %.1f 周期/帧, 拒绝 %u\n", (unsigned)size,
+                      (unsigned)FRAME_TAG_SIZE, samples, (float)cycles / samples, rejected);
+    }
+}
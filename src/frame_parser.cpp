@@ -0,0 +1,363 @@
+#include <Arduino.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "frame_parser.h"
+#include "link_sim.h"
+
+// 解码成功返回 true（重复/过期帧也算成功，只是不产生队列项）；字段非法返回 false。
+// item 已填好来源 MAC 与到达时间。
+typedef bool (*FrameDecodeFn)(FrameDecoders& decoders, const uint8_t* data, size_t len, QueueItem_t& item,
+                              FrameEmit emit);
+
+struct FrameFormat {
+    uint8_t type;
+    uint8_t minLen;
+    uint8_t maxLen;
+    FrameRoute route;
+    FrameDecodeFn decode; // 控制帧/键盘帧为 NULL
+};
+
+// 快速路径没有接收的旧格式帧：类型的高位字节不为 0
+static bool rejectUniversal(FrameDecoders&, const uint8_t*, size_t, QueueItem_t&, FrameEmit) {
+    return false;
+}
+
+// 紧凑运动帧
+static bool decodeMotion(FrameDecoders&, const uint8_t* data, size_t, QueueItem_t& item, FrameEmit emit) {
+    MotionPacket packet;
+    memcpy(&packet, data, sizeof(packet));
+    packet.buttons &= ~MOTION_BUTTONS_RESERVED;
+    item.type = PACKET_TYPE_MOUSE_DATA;
+    item.deltaX = packet.deltaX;
+    item.deltaY = packet.deltaY;
+    item.wheel = packet.wheel;
+    item.buttons = packet.buttons;
+    item.flags = QUEUE_ITEM_HAS_SEQ;
+    item.seq = packet.seq;
+    item.intervalUs = packet.intervalUs;
+    emit(item);
+    return true;
+}
+
+// 前向纠错运动帧：变长，先恢复缺失样本再送出当前样本
+static bool decodeFec(FrameDecoders& decoders, const uint8_t* data, size_t len, QueueItem_t& item,
+                      FrameEmit emit) {
+    const uint8_t redundancy = data[FEC_HEADER_SIZE - 1];
+    if (redundancy > FEC_MAX_REDUNDANCY || len != FEC_HEADER_SIZE + redundancy * sizeof(RedundantSample)) {
+        return false;
+    }
+    MotionFecPacket packet;
+    memcpy(&packet, data, len);
+    packet.buttons &= ~MOTION_BUTTONS_RESERVED;
+    for (uint8_t i = 0; i < redundancy; i++) {
+        packet.history[i].buttons &= ~MOTION_BUTTONS_RESERVED;
+    }
+    decoders.fec.accept(item.mac_addr, packet, emit);
+    return true;
+}
+
+// 累计计数运动帧：与上次的累计值相减得到增量
+static bool decodeCumulative(FrameDecoders& decoders, const uint8_t* data, size_t, QueueItem_t& item, FrameEmit emit) {
+    CumulativeMotionPacket packet;
+    memcpy(&packet, data, sizeof(packet));
+    packet.buttons &= ~MOTION_BUTTONS_RESERVED;
+    if (decoders.cumulative.decode(item.mac_addr, packet, item)) {
+        emit(item);
+    }
+    return true;
+}
+
+// 带时间戳的运动帧
+static bool decodeTimed(FrameDecoders&, const uint8_t* data, size_t, QueueItem_t& item, FrameEmit emit) {
+    TimedMotionPacket packet;
+    memcpy(&packet, data, sizeof(packet));
+    packet.buttons &= ~MOTION_BUTTONS_RESERVED;
+    item.type = PACKET_TYPE_MOUSE_DATA;
+    item.deltaX = packet.deltaX;
+    item.deltaY = packet.deltaY;
+    item.wheel = packet.wheel;
+    item.buttons = packet.buttons;
+    item.flags = QUEUE_ITEM_HAS_SEQ | QUEUE_ITEM_HAS_TIMESTAMP;
+    item.seq = packet.seq;
+    item.intervalUs = packet.intervalUs;
+    item.senderTimeUs = packet.senderTimeUs;
+    emit(item);
+    return true;
+}
+
+// 时钟同步心跳
+static bool decodeClockSync(FrameDecoders&, const uint8_t* data, size_t, QueueItem_t& item, FrameEmit emit) {
+    ClockSyncPacket packet;
+    memcpy(&packet, data, sizeof(packet));
+    item.type = PACKET_TYPE_HEARTBEAT;
+    item.flags = QUEUE_ITEM_HAS_TIMESTAMP;
+    item.seq = packet.seq;
+    item.senderTimeUs = packet.senderTimeUs;
+    emit(item);
+    return true;
+}
+
+// 变长压缩运动帧：可能一次展开为多个样本，由解码器完整校验
+static bool decodePacked(FrameDecoders& decoders, const uint8_t* data, size_t len, QueueItem_t& item,
+                         FrameEmit emit) {
+    return decoders.packed.decode(item.mac_addr, item.arrivalUs, data, len, emit);
+}
+
+// 高分辨率滚动运动帧
+static bool decodeHiRes(FrameDecoders&, const uint8_t* data, size_t, QueueItem_t& item, FrameEmit emit) {
+    MotionHiResPacket packet;
+    memcpy(&packet, data, sizeof(packet));
+    packet.buttons &= ~MOTION_BUTTONS_RESERVED;
+    item.type = PACKET_TYPE_MOUSE_DATA;
+    item.deltaX = packet.deltaX;
+    item.deltaY = packet.deltaY;
+    item.scroll = packet.scroll;
+    item.pan = packet.pan;
+    item.buttons = packet.buttons;
+    item.flags = QUEUE_ITEM_HAS_SEQ | QUEUE_ITEM_FINE_SCROLL;
+    item.seq = packet.seq;
+    item.intervalUs = packet.intervalUs;
+    emit(item);
+    return true;
+}
+
+// 按类型值顺序排列，下标即类型。本端不接收的类型（接收端自己发出的帧、测速帧）去向为丢弃。
+static constexpr FrameFormat kFrameFormats[] = {
+    {PACKET_TYPE_DISCOVERY, 0, 0, FRAME_DROPPED, NULL},
+    {PACKET_TYPE_MOUSE_DATA, UNIVERSAL_FRAME_SIZE, UNIVERSAL_FRAME_SIZE, FRAME_QUEUED, rejectUniversal},
+    {PACKET_TYPE_HEARTBEAT, UNIVERSAL_FRAME_SIZE, UNIVERSAL_FRAME_SIZE, FRAME_QUEUED, rejectUniversal},
+    {PACKET_TYPE_MOTION, sizeof(MotionPacket), sizeof(MotionPacket), FRAME_QUEUED, decodeMotion},
+    {PACKET_TYPE_MOTION_FEC, FEC_HEADER_SIZE, sizeof(MotionFecPacket), FRAME_QUEUED, decodeFec},
+    {PACKET_TYPE_MOTION_CUMULATIVE, sizeof(CumulativeMotionPacket), sizeof(CumulativeMotionPacket), FRAME_QUEUED,
+     decodeCumulative},
+    {PACKET_TYPE_MOTION_TIMED, sizeof(TimedMotionPacket), sizeof(TimedMotionPacket), FRAME_QUEUED, decodeTimed},
+    {PACKET_TYPE_CLOCK_SYNC, sizeof(ClockSyncPacket), sizeof(ClockSyncPacket), FRAME_QUEUED, decodeClockSync},
+    {PACKET_TYPE_HELLO, sizeof(HelloPacket), sizeof(HelloPacket), FRAME_CONTROL, NULL},
+    {PACKET_TYPE_HELLO_ACK, 0, 0, FRAME_DROPPED, NULL},
+    {PACKET_TYPE_LINK_FEEDBACK, 0, 0, FRAME_DROPPED, NULL},
+    {PACKET_TYPE_MOTION_PACKED, PACKED_HEADER_SIZE + 1, PACKED_MAX_FRAME_SIZE, FRAME_QUEUED, decodePacked},
+    {PACKET_TYPE_AUTH_CHALLENGE, 0, 0, FRAME_DROPPED, NULL},
+    {PACKET_TYPE_AUTH_RESPONSE, sizeof(AuthResponsePacket), sizeof(AuthResponsePacket), FRAME_CONTROL, NULL},
+    {PACKET_TYPE_LINK_PROBE, 0, 0, FRAME_DROPPED, NULL},
+    {PACKET_TYPE_KEYBOARD, sizeof(KeyboardPacket), sizeof(KeyboardPacket), FRAME_KEYBOARD, NULL},
+    {PACKET_TYPE_MOTION_HIRES, sizeof(MotionHiResPacket), sizeof(MotionHiResPacket), FRAME_QUEUED, decodeHiRes},
+};
+constexpr size_t kFrameFormatCount = sizeof(kFrameFormats) / sizeof(kFrameFormats[0]);
+
+static constexpr bool formatsIndexedByType() {
+    for (size_t i = 0; i < kFrameFormatCount; i++) {
+        if (kFrameFormats[i].type != i) {
+            return false;
+        }
+    }
+    return kFrameFormatCount == PACKET_TYPE_MOTION_HIRES + 1;
+}
+static_assert(formatsIndexedByType(), "kFrameFormats 必须按类型值顺序覆盖全部 PacketType");
+static_assert(sizeof(MotionFecPacket) <= UINT8_MAX && PACKED_MAX_FRAME_SIZE <= UINT8_MAX &&
+                  sizeof(AuthResponsePacket) <= UINT8_MAX,
+              "帧长超出格式表的范围");
+
+FrameRoute FrameParser::parseTable(const uint8_t mac[6], const uint8_t* data, size_t len, uint32_t arrivalUs,
+                                   FrameEmit emit) {
+    if (len == 0 || data[0] >= kFrameFormatCount) {
+        return FRAME_DROPPED;
+    }
+    const FrameFormat& format = kFrameFormats[data[0]];
+    if (format.route == FRAME_DROPPED) {
+        return FRAME_DROPPED;
+    }
+    if (len < format.minLen || len > format.maxLen) {
+        rejected_++;
+        return FRAME_DROPPED;
+    }
+    if (format.decode == NULL) {
+        return format.route;
+    }
+
+    QueueItem_t item = {};
+    memcpy(item.mac_addr, mac, 6);
+    item.arrivalUs = arrivalUs;
+    if (!format.decode(decoders_, data, len, item, emit)) {
+        rejected_++;
+        return FRAME_DROPPED;
+    }
+    return FRAME_QUEUED;
+}
+
+bool FrameParser::isControl(const uint8_t* data, size_t len) {
+    if (len == 0 || data[0] >= kFrameFormatCount) {
+        return false;
+    }
+    const FrameFormat& format = kFrameFormats[data[0]];
+    return format.route == FRAME_CONTROL && len >= format.minLen && len <= format.maxLen;
+}
+
+void FrameParser::reset() {
+    decoders_.fec.reset();
+    decoders_.cumulative.reset();
+    decoders_.packed.reset();
+}
+
+// --- 变异测试 ---
+
+constexpr size_t FUZZ_MAX_FRAME = 250; // ESP-NOW 单帧上限
+constexpr size_t FUZZ_SEED_FRAME = 64;
+
+struct FuzzSeed {
+    uint8_t len;
+    uint8_t data[FUZZ_SEED_FRAME];
+};
+
+static volatile uint32_t fuzzItems = 0;
+static volatile uint32_t fuzzViolations = 0;
+
+bool frameItemIsValid(const QueueItem_t& item) {
+    const uint8_t knownFlags = QUEUE_ITEM_HAS_SEQ | QUEUE_ITEM_RECOVERED | QUEUE_ITEM_COVERS_GAP |
+                               QUEUE_ITEM_HAS_TIMESTAMP | QUEUE_ITEM_FINE_SCROLL;
+    return (item.type == PACKET_TYPE_MOUSE_DATA || item.type == PACKET_TYPE_HEARTBEAT) &&
+           (item.flags & ~knownFlags) == 0 && (item.buttons & MOTION_BUTTONS_RESERVED) == 0;
+}
+
+static void fuzzEmit(const QueueItem_t& item) {
+    fuzzItems++;
+    if (!frameItemIsValid(item)) {
+        fuzzViolations++;
+    }
+}
+
+template <typename Packet>
+static void addSeed(FuzzSeed* seeds, size_t& count, const Packet& packet, size_t len = sizeof(Packet)) {
+    seeds[count].len = (uint8_t)len;
+    memcpy(seeds[count].data, &packet, len);
+    count++;
+}
+
+// 每种接收的格式各一个合法帧
+static size_t buildFuzzSeeds(FuzzSeed* seeds) {
+    size_t count = 0;
+    UniversalPacket universal = {};
+    universal.type = PACKET_TYPE_MOUSE_DATA;
+    universal.deltaX = -12;
+    universal.deltaY = 7;
+    universal.buttons = 0x01;
+    addSeed(seeds, count, universal);
+    universal.type = PACKET_TYPE_HEARTBEAT;
+    addSeed(seeds, count, universal);
+
+    const MotionPacket motion = {PACKET_TYPE_MOTION, 100, 1000, 5, -3, 1, 0x02};
+    addSeed(seeds, count, motion);
+
+    MotionFecPacket fec = {};
+    fec.type = PACKET_TYPE_MOTION_FEC;
+    fec.seq = 200;
+    fec.intervalUs = 1000;
+    fec.deltaX = 4;
+    fec.redundancy = 2;
+    fec.history[0] = {3, 0, 0, 0};
+    fec.history[1] = {2, 0, 0, 0};
+    addSeed(seeds, count, fec, FEC_HEADER_SIZE + 2 * sizeof(RedundantSample));
+
+    const CumulativeMotionPacket cumulative = {PACKET_TYPE_MOTION_CUMULATIVE, 300, 1000, 1000, 2000, 3, 0};
+    addSeed(seeds, count, cumulative);
+
+    const TimedMotionPacket timed = {PACKET_TYPE_MOTION_TIMED, 400, 1000, 123456, -1, 1, 0, 0x04};
+    addSeed(seeds, count, timed);
+
+    const ClockSyncPacket clockSync = {PACKET_TYPE_CLOCK_SYNC, 500, 654321};
+    addSeed(seeds, count, clockSync);
+
+    const MotionHiResPacket hires = {PACKET_TYPE_MOTION_HIRES, 600, 1000, 9, 9, 40, -40, 0x10};
+    addSeed(seeds, count, hires);
+
+    const PackedSample batch[4] = {{1, 2, 0, 0}, {300, -300, 0, 1}, {0, 0, 1, 1}, {-5, 0, 0, 0}};
+    uint8_t lastButtons = 0;
+    seeds[count].len =
+        (uint8_t)encodePackedMotion(batch, 4, 700, 1000, lastButtons, false, seeds[count].data, FUZZ_SEED_FRAME);
+    count++;
+
+    KeyboardPacket keyboard = {};
+    keyboard.type = PACKET_TYPE_KEYBOARD;
+    keyboard.keys[0] = 0x10;
+    addSeed(seeds, count, keyboard);
+
+    HelloPacket hello = {};
+    hello.type = PACKET_TYPE_HELLO;
+    hello.handshakeVersion = HANDSHAKE_VERSION;
+    addSeed(seeds, count, hello);
+    return count;
+}
+
+// 对一帧做一次随机变异；返回新长度
+static size_t mutateFrame(SimRandom& random, uint8_t* buf, size_t len) {
+    const uint32_t r = random.next();
+    switch (r % 5) {
+    case 0: // 翻转一位
+        if (len > 0) {
+            buf[(r >> 8) % len] ^= (uint8_t)(1 << ((r >> 3) & 7));
+        }
+        return len;
+    case 1: // 改写一个字节
+        if (len > 0) {
+            buf[(r >> 8) % len] = (uint8_t)(random.next() >> 24);
+        }
+        return len;
+    case 2: // 截断
+        return (r >> 8) % (len + 1);
+    case 3: { // 追加随机字节
+        size_t extra = 1 + ((r >> 8) & 7);
+        if (len + extra > FUZZ_MAX_FRAME) {
+            extra = FUZZ_MAX_FRAME - len;
+        }
+        for (size_t i = 0; i < extra; i++) {
+            buf[len + i] = (uint8_t)(random.next() >> 24);
+        }
+        return len + extra;
+    }
+    default: // 改类型（包括超出已知范围的值）
+        if (len > 0) {
+            buf[0] = (uint8_t)((r >> 8) % (kFrameFormatCount + 2));
+        }
+        return len;
+    }
+}
+
+void fuzzFrameParser(uint32_t iterations, uint32_t seed) {
+    static FuzzSeed seeds[12];
+    static uint8_t buf[FUZZ_MAX_FRAME];
+    static FrameParser parser;
+    static const uint8_t mac[6] = {0x02, 'F', 'U', 'Z', 'Z', 0};
+    const size_t seedCount = buildFuzzSeeds(seeds);
+
+    parser = FrameParser();
+    fuzzItems = 0;
+    fuzzViolations = 0;
+    SimRandom random;
+    random.seed(seed);
+    uint32_t routes[FRAME_KEYBOARD + 1] = {};
+    uint32_t parseCycles = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        const FuzzSeed& s = seeds[random.next() % seedCount];
+        size_t len = s.len;
+        memcpy(buf, s.data, len);
+        const uint32_t mutations = 1 + random.next() % 4;
+        for (uint32_t m = 0; m < mutations; m++) {
+            len = mutateFrame(random, buf, len);
+        }
+        const uint32_t start = ESP.getCycleCount();
+        const FrameRoute route = parser.parse(mac, buf, len, i, fuzzEmit);
+        parseCycles += ESP.getCycleCount() - start;
+        routes[route]++;
+    }
+
+    Serial.printf("[模糊] %u 帧（种子 %u）：入队 %u 控制 %u 键盘 %u 丢弃 %u（其中非法 %u），产生队列项 %u，"
+                  "解析平均 %.1f 周期/帧\n",
+                  iterations, seed, routes[FRAME_QUEUED], routes[FRAME_CONTROL], routes[FRAME_KEYBOARD],
+                  routes[FRAME_DROPPED], parser.rejected(), fuzzItems,
+                  iterations ? (float)parseCycles / iterations : 0.0f);
+    if (fuzzViolations == 0) {
+        Serial.println("[模糊] 通过：所有队列项都合法。");
+    } else {
+        Serial.printf("[模糊] 失败：%u 个队列项不合法。\n", fuzzViolations);
+    }
+}
@@ -0,0 +1,71 @@
+#include <Arduino.h>
+
+#include "handshake.h"
+
+// 公共格式的优先顺序：FEC 允许发送端关闭链路层重传，延迟最低；压缩帧空口时间最短，
+// 并可批量发送；累计计数丢帧不丢位置；
+// 时间戳帧可以走抖动缓冲；再往后是仅带序号的帧和旧格式。
+static const struct {
+    MotionFormat format;
+    uint8_t wireVersion;
+    uint16_t requires;
+} kFormatPreference[] = {
+    {MOTION_FORMAT_FEC,        3, CAP_FEC},
+    {MOTION_FORMAT_PACKED,     4, CAP_PACKED},
+    {MOTION_FORMAT_CUMULATIVE, 3, CAP_CUMULATIVE},
+    {MOTION_FORMAT_TIMED,      3, CAP_TIMESTAMPS},
+    {MOTION_FORMAT_SEQUENCE,   2, CAP_SEQUENCE},
+};
+
+bool negotiateLinkMode(const Capabilities& local, const Capabilities& remote, LinkMode& out) {
+    if (remote.wireVersion == 0) {
+        return false;
+    }
+
+    LinkMode mode = {};
+    mode.wireVersion = local.wireVersion < remote.wireVersion ? local.wireVersion : remote.wireVersion;
+    mode.features = local.features & remote.features;
+    mode.format = MOTION_FORMAT_LEGACY;
+    for (const auto& pref : kFormatPreference) {
+        if (mode.wireVersion >= pref.wireVersion && (mode.features & pref.requires) == pref.requires) {
+            mode.format = pref.format;
+            break;
+        }
+    }
+    // 报告周期取双方都能承受的较长者
+    mode.intervalUs = local.minIntervalUs > remote.minIntervalUs ? local.minIntervalUs : remote.minIntervalUs;
+    // 接收端固定工作在自己的频道上，发送端的首选频道仅供参考
+    mode.channel = local.channel;
+    mode.redundancy = (mode.features & CAP_FEC)
+                          ? (local.maxRedundancy < remote.maxRedundancy ? local.maxRedundancy : remote.maxRedundancy)
+                          : 0;
+    mode.senderResolution = remote.resolution;
+    mode.hostResolution = local.resolution;
+    out = mode;
+    return true;
+}
+
+LinkMode legacyLinkMode() {
+    LinkMode mode = {};
+    mode.wireVersion = 1;
+    mode.format = MOTION_FORMAT_LEGACY;
+    return mode;
+}
+
+const char* motionFormatName(MotionFormat format) {
+    switch (format) {
+        case MOTION_FORMAT_LEGACY:     return "legacy";
+        case MOTION_FORMAT_SEQUENCE:   return "sequence";
+        case MOTION_FORMAT_TIMED:      return "timed";
+        case MOTION_FORMAT_CUMULATIVE: return "cumulative";
+        case MOTION_FORMAT_FEC:        return "fec";
+        case MOTION_FORMAT_PACKED:     return "packed";
+    }
+    return "unknown";
+}
+
+void printLinkMode(const LinkMode& mode) {
+    Serial.printf("链路模式: 格式=%s 线上版本=%u 能力=0x%04X 周期=%uus 频道=%u 冗余=%u 分辨率=%u/%u\n",
+                  motionFormatName(mode.format), mode.wireVersion, mode.features, mode.intervalUs,
+                  mode.channel, mode.redundancy, mode.senderResolution, mode.hostResolution);
+}
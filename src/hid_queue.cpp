@@ -0,0 +1,113 @@
+#include "hid_queue.h"
+
+// 端点空闲时直接交给 TinyUSB（只入队，不等主机取走）
+bool HidReportQueue::transmit(uint8_t reportId, const void* report, size_t len) const {
+    return tud_hid_n_ready(instance_) && tud_hid_n_report(instance_, reportId, report, len);
+}
+
+// 两个相对量饱和相加到 ±limit；发生饱和时 exact 置为 false
+static int32_t addRelative(int32_t a, int32_t b, int32_t limit, bool& exact) {
+    const int32_t sum = a + b;
+    if (sum > limit || sum < -limit) {
+        exact = false;
+        return sum > limit ? limit : -limit;
+    }
+    return sum;
+}
+
+void HidReportQueue::submitMouse(const HiResMouseReport& report) {
+    // 先发积压的报告，保持顺序
+    if (flush() == 0 && transmit(HID_REPORT_ID_MOUSE, &report, sizeof(report))) {
+        sentButtons_ = report.buttons;
+        return;
+    }
+    enqueueMouse(report);
+}
+
+void HidReportQueue::enqueueMouse(const HiResMouseReport& report) {
+    if (mouseCount_ > 0) {
+        HiResMouseReport& tail = mouse_[(mouseHead_ + mouseCount_ - 1) % HID_PENDING_REPORTS];
+        const uint8_t beforeTail = mouseCount_ > 1
+                                       ? mouse_[(mouseHead_ + mouseCount_ - 2) % HID_PENDING_REPORTS].buttons
+                                       : sentButtons_;
+        bool exact = true;
+        const int32_t x = addRelative(tail.x, report.x, INT16_MAX, exact);
+        const int32_t y = addRelative(tail.y, report.y, INT16_MAX, exact);
+        const int32_t wheel = addRelative(tail.wheel, report.wheel, INT8_MAX, exact);
+        const int32_t pan = addRelative(tail.pan, report.pan, INT8_MAX, exact);
+        // 只并入纯位移报告：并入按键变化的报告会把按下/松开的位置挪到位移之后；
+        // 也不越过排在队尾之后的键盘状态
+        const bool behindKeyboard = keyboardPending_ && keyboardAfter_ == mouseCount_;
+        const bool mergeable =
+            exact && !behindKeyboard && tail.buttons == report.buttons && beforeTail == tail.buttons;
+        const bool overrun = mouseCount_ == HID_PENDING_REPORTS;
+        if (mergeable || overrun) {
+            tail.x = (int16_t)x;
+            tail.y = (int16_t)y;
+            tail.wheel = (int8_t)wheel;
+            tail.pan = (int8_t)pan;
+            tail.buttons = report.buttons;
+            if (mergeable) {
+                merged_++;
+            } else {
+                overruns_++;
+            }
+            return;
+        }
+    }
+    mouse_[(mouseHead_ + mouseCount_) % HID_PENDING_REPORTS] = report;
+    mouseCount_++;
+    deferred_++;
+}
+
+void HidReportQueue::submitKeyboard(const KeyboardReport& report) {
+    keyboard_ = report;
+    if (keyboardPending_) {
+        merged_++;  // 还没发出的旧状态直接作废
+        flush();
+        return;
+    }
+    keyboardPending_ = true;
+    keyboardAfter_ = mouseCount_;
+    flush();
+    if (keyboardPending_) {
+        deferred_++;
+    }
+}
+
+void HidReportQueue::dropMouseReports() {
+    mouseCount_ = 0;
+    keyboardAfter_ = 0;
+}
+
+size_t HidReportQueue::flush() {
+    // 总线复位或拔出后积压的报告已无意义；挂起期间鼠标报告作废，键盘状态等到恢复后再发
+    if (!tud_mounted()) {
+        dropMouseReports();
+        keyboardPending_ = false;
+        return 0;
+    }
+    if (tud_suspended()) {
+        dropMouseReports();
+        return pendingReports();
+    }
+    for (;;) {
+        if (keyboardPending_ && keyboardAfter_ == 0) {
+            if (!transmit(HID_REPORT_ID_KEYBOARD, &keyboard_, sizeof(keyboard_))) {
+                break;
+            }
+            keyboardPending_ = false;
+            continue;
+        }
+        if (mouseCount_ == 0 || !transmit(HID_REPORT_ID_MOUSE, &mouse_[mouseHead_], sizeof(HiResMouseReport))) {
+            break;
+        }
+        sentButtons_ = mouse_[mouseHead_].buttons;
+        mouseHead_ = (mouseHead_ + 1) % HID_PENDING_REPORTS;
+        mouseCount_--;
+        if (keyboardPending_) {
+            keyboardAfter_--;
+        }
+    }
+    return pendingReports();
+}
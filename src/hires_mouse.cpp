@@ -0,0 +1,200 @@
+#include "hid_tap.h"
+#include "hires_mouse.h"
+
+// 特性报告：位 0~1 = 滚轮倍率，位 2~3 = 水平滚动倍率（0 = 整格，1 = 1/120 格）
+static const uint8_t reportDescriptor[] = {
+    0x05, 0x01,                    // Usage Page (Generic Desktop)
+    0x09, 0x02,                    // Usage (Mouse)
+    0xA1, 0x01,                    // Collection (Application)
+    0x85, HID_REPORT_ID_MOUSE,     //   Report ID
+    0x09, 0x01,                    //   Usage (Pointer)
+    0xA1, 0x00,                    //   Collection (Physical)
+    // 5 个按键 + 3 位填充
+    0x05, 0x09,                    //     Usage Page (Button)
+    0x19, 0x01,                    //     Usage Minimum (1)
+    0x29, 0x05,                    //     Usage Maximum (5)
+    0x15, 0x00,                    //     Logical Minimum (0)
+    0x25, 0x01,                    //     Logical Maximum (1)
+    0x95, 0x05,                    //     Report Count (5)
+    0x75, 0x01,                    //     Report Size (1)
+    0x81, 0x02,                    //     Input (Data, Variable, Absolute)
+    0x95, 0x01,                    //     Report Count (1)
+    0x75, 0x03,                    //     Report Size (3)
+    0x81, 0x01,                    //     Input (Constant)
+    // X/Y：16 位相对量
+    0x05, 0x01,                    //     Usage Page (Generic Desktop)
+    0x09, 0x30,                    //     Usage (X)
+    0x09, 0x31,                    //     Usage (Y)
+    0x16, 0x01, 0x80,              //     Logical Minimum (-32767)
+    0x26, 0xFF, 0x7F,              //     Logical Maximum (32767)
+    0x75, 0x10,                    //     Report Size (16)
+    0x95, 0x02,                    //     Report Count (2)
+    0x81, 0x06,                    //     Input (Data, Variable, Relative)
+    // 垂直滚轮及其倍率
+    0xA1, 0x02,                    //     Collection (Logical)
+    0x09, 0x48,                    //       Usage (Resolution Multiplier)
+    0x15, 0x00,                    //       Logical Minimum (0)
+    0x25, 0x01,                    //       Logical Maximum (1)
+    0x35, 0x01,                    //       Physical Minimum (1)
+    0x45, SCROLL_UNITS_PER_DETENT, //       Physical Maximum (120)
+    0x75, 0x02,                    //       Report Size (2)
+    0x95, 0x01,                    //       Report Count (1)
+    0xB1, 0x02,                    //       Feature (Data, Variable, Absolute)
+    0x35, 0x00,                    //       Physical Minimum (0)
+    0x45, 0x00,                    //       Physical Maximum (0)
+    0x09, 0x38,                    //       Usage (Wheel)
+    0x15, 0x81,                    //       Logical Minimum (-127)
+    0x25, 0x7F,                    //       Logical Maximum (127)
+    0x75, 0x08,                    //       Report Size (8)
+    0x81, 0x06,                    //       Input (Data, Variable, Relative)
+    0xC0,                          //     End Collection
+    // 水平滚动（AC Pan）及其倍率
+    0xA1, 0x02,                    //     Collection (Logical)
+    0x09, 0x48,                    //       Usage (Resolution Multiplier)
+    0x15, 0x00,                    //       Logical Minimum (0)
+    0x25, 0x01,                    //       Logical Maximum (1)
+    0x35, 0x01,                    //       Physical Minimum (1)
+    0x45, SCROLL_UNITS_PER_DETENT, //       Physical Maximum (120)
+    0x75, 0x02,                    //       Report Size (2)
+    0xB1, 0x02,                    //       Feature (Data, Variable, Absolute)
+    0x35, 0x00,                    //       Physical Minimum (0)
+    0x45, 0x00,                    //       Physical Maximum (0)
+    0x05, 0x0C,                    //       Usage Page (Consumer)
+    0x0A, 0x38, 0x02,              //       Usage (AC Pan)
+    0x15, 0x81,                    //       Logical Minimum (-127)
+    0x25, 0x7F,                    //       Logical Maximum (127)
+    0x75, 0x08,                    //       Report Size (8)
+    0x81, 0x06,                    //       Input (Data, Variable, Relative)
+    0xC0,                          //     End Collection
+    // 特性报告填充到整字节
+    0x75, 0x04,                    //     Report Size (4)
+    0xB1, 0x01,                    //     Feature (Constant)
+    0xC0,                          //   End Collection
+    0xC0,                          // End Collection
+};
+
+HiResMouse::HiResMouse(HidReportQueue& queue) : hid_(), queue_(queue) {
+    static bool initialized = false;
+    if (!initialized) {
+        initialized = true;
+        hid_.addDevice(this, sizeof(reportDescriptor));
+    }
+}
+
+void HiResMouse::begin() {
+    hid_.begin();
+}
+
+uint16_t HiResMouse::_onGetDescriptor(uint8_t* buffer) {
+    memcpy(buffer, reportDescriptor, sizeof(reportDescriptor));
+    return sizeof(reportDescriptor);
+}
+
+uint16_t HiResMouse::_onGetFeature(uint8_t reportId, uint8_t* buffer, uint16_t len) {
+    if (reportId != HID_REPORT_ID_MOUSE || len < 1) {
+        return 0;
+    }
+    buffer[0] = (wheelHiRes_ ? 0x01 : 0) | (panHiRes_ ? 0x04 : 0);
+    return 1;
+}
+
+void HiResMouse::_onSetFeature(uint8_t reportId, const uint8_t* buffer, uint16_t len) {
+    if (reportId != HID_REPORT_ID_MOUSE || len < 1) {
+        return;
+    }
+    wheelHiRes_ = (buffer[0] & 0x03) != 0;
+    panHiRes_ = (buffer[0] & 0x0C) != 0;
+}
+
+// 取出能上报的部分，余数（向零截断）留到下次
+int8_t HiResMouse::takeScroll(int32_t& remainder, bool hiRes) {
+    const int32_t unit = hiRes ? 1 : SCROLL_UNITS_PER_DETENT;
+    int32_t out = remainder / unit;
+    if (out > INT8_MAX) out = INT8_MAX;
+    if (out < -INT8_MAX) out = -INT8_MAX;
+    remainder -= out * unit;
+    return (int8_t)out;
+}
+
+void HiResMouse::move(int16_t x, int16_t y, int16_t scroll, int16_t pan) {
+    scrollRemainder_ += scroll;
+    panRemainder_ += pan;
+    const int8_t wheel = takeScroll(scrollRemainder_, wheelHiRes_);
+    const int8_t acPan = takeScroll(panRemainder_, panHiRes_);
+    if (x == 0 && y == 0 && wheel == 0 && acPan == 0) {
+        return;
+    }
+    send(buttons_, x, y, wheel, acPan);
+}
+
+bool HiResMouse::report(int16_t x, int16_t y, int16_t scroll, int16_t pan, uint8_t buttons, bool force) {
+    scrollRemainder_ += scroll;
+    panRemainder_ += pan;
+    const int8_t wheel = takeScroll(scrollRemainder_, wheelHiRes_);
+    const int8_t acPan = takeScroll(panRemainder_, panHiRes_);
+    buttons &= HIRES_BUTTON_ALL;
+    if (!force && x == 0 && y == 0 && wheel == 0 && acPan == 0 && buttons == buttons_) {
+        return false;
+    }
+    // 主机挂起时报告被丢弃，buttons_ 保持主机看到的状态，恢复后的下一个报告会带上这次的变化
+    if (!send(buttons, x, y, wheel, acPan)) {
+        return false;
+    }
+    buttons_ = buttons;
+    return true;
+}
+
+void HiResMouse::press(uint8_t buttons) {
+    const uint8_t next = buttons_ | (buttons & HIRES_BUTTON_ALL);
+    if (next != buttons_ && send(next, 0, 0, 0, 0)) {
+        buttons_ = next;
+    }
+}
+
+void HiResMouse::release(uint8_t buttons) {
+    const uint8_t next = buttons_ & ~buttons;
+    if (next != buttons_ && send(next, 0, 0, 0, 0)) {
+        buttons_ = next;
+    }
+}
+
+bool HiResMouse::send(uint8_t buttons, int16_t x, int16_t y, int8_t wheel, int8_t pan) {
+    // 逻辑范围为 ±32767，-32768 不合法
+    const HiResMouseReport report = {buttons, x == INT16_MIN ? (int16_t)-INT16_MAX : x,
+                                     y == INT16_MIN ? (int16_t)-INT16_MAX : y, wheel, pan};
+    if (hidTapIntercept(HID_REPORT_ID_MOUSE, &report, sizeof(report))) {
+        return true;
+    }
+    if (tud_suspended()) {
+        queue_.dropMouseReports();
+        requestWakeIfNeeded(report);
+        return false;
+    }
+    suspendMotion_ = 0;
+    queue_.submitMouse(report);
+    return true;
+}
+
+// 挂起期间的唤醒判定：主机看到的最后状态之外新按下的键，或一个窗口内足够大的移动
+void HiResMouse::requestWakeIfNeeded(const HiResMouseReport& report) {
+    static const uint32_t WAKE_MOTION_WINDOW_US = 250000;
+    static const uint32_t WAKE_RETRY_US = 100000;  // 主机响应唤醒需要时间，期间不重复请求
+
+    const uint32_t now = micros();
+    if (suspendMotion_ == 0 || now - suspendMotionStartUs_ > WAKE_MOTION_WINDOW_US) {
+        suspendMotion_ = 0;
+        suspendMotionStartUs_ = now;
+    }
+    suspendMotion_ += abs(report.x) + abs(report.y);
+
+    const bool pressed = (report.buttons & ~queue_.sentButtons()) != 0;
+    const bool moved = wakeMotion_ > 0 && suspendMotion_ >= wakeMotion_;
+    if ((pressed || moved) && now - lastWakeRequestUs_ >= WAKE_RETRY_US) {
+        lastWakeRequestUs_ = now;
+        suspendMotion_ = 0;
+        // 主机没有允许远程唤醒时返回 false
+        if (tud_remote_wakeup()) {
+            wakeRequests_++;
+        }
+    }
+}
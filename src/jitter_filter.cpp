@@ -0,0 +1,109 @@
+#include <Arduino.h>
+#include <math.h>
+
+#include "jitter_filter.h"
+
+static uint16_t alphaForCutoff(float cutoffHz, float periodS) {
+    const float tau = 1.0f / (2.0f * (float)M_PI * cutoffHz);
+    float alpha = 1.0f / (1.0f + tau / periodS);
+    if (alpha >= JITTER_ALPHA_SNAP) {
+        alpha = 1.0f;
+    }
+    return (uint16_t)lroundf(alpha * JITTER_ALPHA_ONE);
+}
+
+bool buildJitterFilterTables(const JitterFilterParams& params, JitterFilterTables& out) {
+    if (!(params.minCutoffHz > 0.0f) || params.beta < 0.0f || !(params.derivCutoffHz > 0.0f) ||
+        !(params.samplePeriodMs > 0.0f)) {
+        return false;
+    }
+
+    const float periodS = params.samplePeriodMs / 1000.0f;
+    JitterFilterTables tables;
+    for (size_t i = 0; i < JITTER_LUT_SIZE; i++) {
+        // 速度换算为 计数/秒 后代入 One Euro 的截止频率公式
+        const float speed = (float)i / periodS;
+        tables.alpha[i] = params.enabled ? alphaForCutoff(params.minCutoffHz + params.beta * speed, periodS)
+                                         : (uint16_t)JITTER_ALPHA_ONE;
+    }
+    tables.derivAlpha = alphaForCutoff(params.derivCutoffHz, periodS);
+    out = tables;
+    return true;
+}
+
+void printJitterFilterParams(const JitterFilterParams& params) {
+    Serial.printf("抖动滤波: %s 最小截止=%.2fHz beta=%.4f 速度截止=%.2fHz 采样周期=%.2fms\n",
+                  params.enabled ? "开" : "关", params.minCutoffHz, params.beta,
+                  params.derivCutoffHz, params.samplePeriodMs);
+}
+
+JitterFilterEvaluator::JitterFilterEvaluator(const JitterFilterTables& tables) { filter_.setTables(tables); }
+
+void JitterFilterEvaluator::add(int16_t dx, int16_t dy, uint32_t atUs) {
+    const size_t prev = (samples_ + JITTER_EVAL_HISTORY - 1) % JITTER_EVAL_HISTORY;
+    const size_t slot = samples_ % JITTER_EVAL_HISTORY;
+    rawX_[slot] = (samples_ ? rawX_[prev] : 0) + dx;
+    rawY_[slot] = (samples_ ? rawY_[prev] : 0) + dy;
+    atUs_[slot] = atUs;
+    samples_++;
+    rawReports_ += dx != 0 || dy != 0;
+    // ±1 的静止噪声不算移动
+    const bool moving = abs(dx) >= 2 || abs(dy) >= 2;
+
+    int16_t fx = dx, fy = dy;
+    const uint32_t start = ESP.getCycleCount();
+    filter_.apply(fx, fy);
+    cycles_ += ESP.getCycleCount() - start;
+    outX_ += fx;
+    outY_ += fy;
+    reports_ += fx != 0 || fy != 0;
+    if (!moving) {
+        return;
+    }
+
+    // 从最新的样本往回找，距离相同时取最近的
+    const size_t depth = samples_ < JITTER_EVAL_HISTORY ? samples_ : JITTER_EVAL_HISTORY;
+    int64_t best = INT64_MAX;
+    size_t bestSlot = slot;
+    for (size_t k = 0; k < depth; k++) {
+        const size_t j = (slot + JITTER_EVAL_HISTORY - k) % JITTER_EVAL_HISTORY;
+        const int64_t ex = rawX_[j] - outX_, ey = rawY_[j] - outY_;
+        const int64_t dist = ex * ex + ey * ey;
+        if (dist < best) {
+            best = dist;
+            bestSlot = j;
+        }
+    }
+    const uint32_t latency = atUs - atUs_[bestSlot];
+    moving_++;
+    latencySumUs_ += latency;
+    if (latency > maxLatencyUs_) {
+        maxLatencyUs_ = latency;
+    }
+}
+
+void benchJitterFilter(const JitterFilterTables& tables, uint32_t samples) {
+    JitterFilterEvaluator eval(tables);
+    uint32_t seed = 12345;
+    bool jitterHigh = false;
+
+    // 轨迹：四分之三时间静止（±1 噪声），四分之一时间以 8 计数/样本匀速移动；采样周期 1ms
+    for (uint32_t i = 0; i < samples; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        int16_t dx = 0;
+        if ((i % 400) >= 300) {
+            dx = 8;
+        } else if ((seed >> 31) != 0) {
+            // 静止噪声：位置在两个相邻计数之间随机跳动
+            dx = jitterHigh ? -1 : 1;
+            jitterHigh = !jitterHigh;
+        }
+        eval.add(dx, 0, i * 1000);
+    }
+
+    const uint32_t raw = eval.rawReports();
+    Serial.printf("[基准] 抖动滤波: %u 样本, 报告数 %u -> %u (减少 %.1f%%), 移动时附加延迟 平均 %.0fus 最大 %uus, "
+                  "%.1f 周期/样本\n",
+                  samples, raw, eval.reports(), raw ? 100.0f * ((float)raw - eval.reports()) / raw : 0.0f,
+                  eval.meanLatencyUs(), eval.maxLatencyUs(), eval.cyclesPerSample());
+}
@@ -0,0 +1,117 @@
+#include "hid_tap.h"
+#include "keyboard.h"
+
+static const uint8_t reportDescriptor[] = {
+    0x05, 0x01,                    // Usage Page (Generic Desktop)
+    0x09, 0x06,                    // Usage (Keyboard)
+    0xA1, 0x01,                    // Collection (Application)
+    0x85, HID_REPORT_ID_KEYBOARD,  //   Report ID
+    // 修饰键：8 个 1 位
+    0x05, 0x07,                    //   Usage Page (Keyboard/Keypad)
+    0x19, 0xE0,                    //   Usage Minimum (Left Control)
+    0x29, 0xE7,                    //   Usage Maximum (Right GUI)
+    0x15, 0x00,                    //   Logical Minimum (0)
+    0x25, 0x01,                    //   Logical Maximum (1)
+    0x75, 0x01,                    //   Report Size (1)
+    0x95, 0x08,                    //   Report Count (8)
+    0x81, 0x02,                    //   Input (Data, Variable, Absolute)
+    // 按键位图：用途 0x00~0x77
+    0x19, 0x00,                    //   Usage Minimum (0)
+    0x29, KEYBOARD_BITMAP_SIZE * 8 - 1, // Usage Maximum
+    0x95, KEYBOARD_BITMAP_SIZE * 8, //  Report Count
+    0x81, 0x02,                    //   Input (Data, Variable, Absolute)
+    // 指示灯输出：5 位 + 3 位填充
+    0x05, 0x08,                    //   Usage Page (LEDs)
+    0x19, 0x01,                    //   Usage Minimum (Num Lock)
+    0x29, 0x05,                    //   Usage Maximum (Kana)
+    0x95, 0x05,                    //   Report Count (5)
+    0x91, 0x02,                    //   Output (Data, Variable, Absolute)
+    0x95, 0x01,                    //   Report Count (1)
+    0x75, 0x03,                    //   Report Size (3)
+    0x91, 0x01,                    //   Output (Constant)
+    0xC0,                          // End Collection
+};
+
+NkroKeyboard::NkroKeyboard(HidReportQueue& queue) : hid_(), queue_(queue) {
+    static bool initialized = false;
+    if (!initialized) {
+        initialized = true;
+        hid_.addDevice(this, sizeof(reportDescriptor));
+    }
+}
+
+void NkroKeyboard::begin() {
+    hid_.begin();
+}
+
+uint16_t NkroKeyboard::_onGetDescriptor(uint8_t* buffer) {
+    memcpy(buffer, reportDescriptor, sizeof(reportDescriptor));
+    return sizeof(reportDescriptor);
+}
+
+void NkroKeyboard::_onOutput(uint8_t reportId, const uint8_t* buffer, uint16_t len) {
+    if (reportId == HID_REPORT_ID_KEYBOARD && len >= 1) {
+        leds_ = buffer[0];
+    }
+}
+
+void NkroKeyboard::sendReport(const KeyboardReport& report) {
+    if (hidTapIntercept(HID_REPORT_ID_KEYBOARD, &report, sizeof(report))) {
+        return;
+    }
+    // 主机挂起时有键按下则请求远程唤醒；状态留在队列里，恢复后发出
+    if (tud_suspended()) {
+        uint8_t any = report.modifiers;
+        for (size_t i = 0; i < KEYBOARD_BITMAP_SIZE; i++) {
+            any |= report.keys[i];
+        }
+        if (any != 0) {
+            tud_remote_wakeup();
+        }
+    }
+    queue_.submitKeyboard(report);
+}
+
+void KeyboardRelay::reset() {
+    seqValid_ = false;
+    if (anyPressed()) {
+        state_ = {};
+        keyboard_.sendReport(state_);
+        reports_++;
+    }
+}
+
+bool KeyboardRelay::anyPressed() const {
+    uint8_t any = state_.modifiers;
+    for (size_t i = 0; i < KEYBOARD_BITMAP_SIZE; i++) {
+        any |= state_.keys[i];
+    }
+    return any != 0;
+}
+
+void KeyboardRelay::apply(const KeyboardPacket& packet) {
+    // 与管线相同的回绕安全比较：落后不超过 64 视为过期，更大的回退视为发送端重启
+    if (seqValid_) {
+        const int16_t ahead = (int16_t)(uint16_t)(packet.seq - lastSeq_);
+        if (ahead <= 0 && ahead > -64) {
+            staleFrames_++;
+            return;
+        }
+    }
+    seqValid_ = true;
+    lastSeq_ = packet.seq;
+
+    uint32_t changed = __builtin_popcount((uint8_t)(packet.modifiers ^ state_.modifiers));
+    for (size_t i = 0; i < KEYBOARD_BITMAP_SIZE; i++) {
+        changed += __builtin_popcount((uint8_t)(packet.keys[i] ^ state_.keys[i]));
+    }
+    if (changed == 0) {
+        return; // 重复发送的相同状态
+    }
+
+    state_.modifiers = packet.modifiers;
+    memcpy(state_.keys, packet.keys, KEYBOARD_BITMAP_SIZE);
+    keyboard_.sendReport(state_);
+    reports_++;
+    keyChanges_ += changed;
+}
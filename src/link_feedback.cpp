@@ -0,0 +1,147 @@
+#include <Arduino.h>
+#include <esp_wifi.h>
+
+#include "link_feedback.h"
+
+// 判定阈值
+static const uint16_t LOSS_CLEAN_PERMILLE = 10;     // 丢包 < 1% 视为干净
+static const uint16_t LOSS_BAD_PERMILLE = 50;       // 丢包 > 5% 需要退避
+static const int8_t RSSI_GOOD_DBM = -65;
+static const int8_t RSSI_WEAK_DBM = -80;
+static const uint16_t MAX_SUGGESTED_INTERVAL_US = 8000;
+
+void LinkQualityMonitor::setPeer(const uint8_t mac[6]) {
+    portENTER_CRITICAL(&mux_);
+    memcpy(mac_, mac, 6);
+    active_ = true;
+    seqValid_ = false;
+    expected_ = received_ = 0;
+    rssiValid_ = false;
+    queuePeak_ = 0;
+    portEXIT_CRITICAL(&mux_);
+}
+
+void LinkQualityMonitor::clearPeer() {
+    portENTER_CRITICAL(&mux_);
+    active_ = false;
+    portEXIT_CRITICAL(&mux_);
+}
+
+void LinkQualityMonitor::observeSequence(const uint8_t mac[6], uint16_t seq) {
+    portENTER_CRITICAL_ISR(&mux_);
+    if (matches(mac)) {
+        const int16_t ahead = (int16_t)(uint16_t)(seq - lastSeq_);
+        if (!seqValid_) {
+            seqValid_ = true;
+            expected_++;
+            received_++;
+            lastSeq_ = seq;
+        } else if (ahead > 0) {
+            expected_ += ahead;
+            received_++;
+            lastSeq_ = seq;
+        }
+        // 重复或乱序的旧帧不计入
+    }
+    portEXIT_CRITICAL_ISR(&mux_);
+}
+
+void LinkQualityMonitor::observeRssi(const uint8_t mac[6], int8_t rssi) {
+    portENTER_CRITICAL_ISR(&mux_);
+    if (matches(mac)) {
+        if (!rssiValid_) {
+            rssiValid_ = true;
+            rssiQ4_ = rssi * 16;
+        } else {
+            rssiQ4_ += (rssi * 16 - rssiQ4_) / 8;
+        }
+    }
+    portEXIT_CRITICAL_ISR(&mux_);
+}
+
+void LinkQualityMonitor::observeQueueDepth(uint8_t depth) {
+    if (depth > queuePeak_) {
+        queuePeak_ = depth; // 只在 Wi-Fi 任务中写，单字节写入无需加锁
+    }
+}
+
+LinkQualityMonitor::Snapshot LinkQualityMonitor::takeSnapshot() {
+    Snapshot snap;
+    portENTER_CRITICAL(&mux_);
+    snap.expected = expected_;
+    snap.received = received_;
+    snap.rssi = rssiValid_ ? (int8_t)(rssiQ4_ / 16) : 0;
+    snap.queuePeak = queuePeak_;
+    expected_ = received_ = 0;
+    queuePeak_ = 0;
+    portEXIT_CRITICAL(&mux_);
+    return snap;
+}
+
+void buildLinkFeedback(const FeedbackInputs& in, uint16_t seq, LinkFeedbackPacket& out) {
+    LinkFeedbackPacket packet = {};
+    packet.type = PACKET_TYPE_LINK_FEEDBACK;
+    packet.seq = seq;
+
+    const LinkQualityMonitor::Snapshot& link = in.link;
+    packet.lossPermille = link.expected > 0 ? (uint16_t)((link.expected - link.received) * 1000 / link.expected) : 0;
+    packet.rssi = link.rssi;
+    packet.queuePeak = link.queuePeak;
+    packet.queueCapacity = in.queueCapacity;
+    packet.hidReportRate = in.periodMs > 0 ? (uint16_t)(in.hidReports * 1000 / in.periodMs) : 0;
+    packet.hidSendUs = in.hidReports > 0 ? (uint16_t)(in.hidBusyUs / in.hidReports) : 0;
+
+    // 拥塞：队列曾过半或有溢出丢弃
+    const bool congested = in.queueDrops > 0 || link.queuePeak * 2 > in.queueCapacity;
+    const bool weak = link.rssi != 0 && link.rssi < RSSI_WEAK_DBM;
+    const bool clean = !congested && packet.lossPermille < LOSS_CLEAN_PERMILLE && link.rssi != 0 && link.rssi >= RSSI_GOOD_DBM;
+    if (congested) packet.flags |= FEEDBACK_CONGESTED;
+    if (weak) packet.flags |= FEEDBACK_WEAK_SIGNAL;
+    if (clean) packet.flags |= FEEDBACK_LINK_CLEAN;
+
+    // 建议周期：拥塞或丢包严重时加倍，链路干净时回到协商出的最短周期
+    uint32_t interval = in.currentIntervalUs ? in.currentIntervalUs : in.minIntervalUs;
+    if (congested || packet.lossPermille > LOSS_BAD_PERMILLE) {
+        interval *= 2;
+    } else if (clean) {
+        interval = in.minIntervalUs;
+    }
+    if (interval < in.minIntervalUs) interval = in.minIntervalUs;
+    if (interval > MAX_SUGGESTED_INTERVAL_US) interval = MAX_SUGGESTED_INTERVAL_US;
+    packet.suggestedIntervalUs = (uint16_t)interval;
+
+    // 主机挂起时报告都到不了主机，只需维持连接并等待唤醒动作
+    if (in.hostSuspended) {
+        packet.flags |= FEEDBACK_HOST_SUSPENDED;
+        packet.suggestedIntervalUs = in.suspendedIntervalUs;
+    }
+
+    out = packet;
+}
+
+static LinkQualityMonitor* rssiMonitor = NULL;
+
+// 混杂模式回调（Wi-Fi 任务上下文）：ESP-NOW 帧是厂商自定义的 Action 管理帧，源地址在 addr2
+static void onPromiscuousRx(void* buf, wifi_promiscuous_pkt_type_t type) {
+    if (type != WIFI_PKT_MGMT || rssiMonitor == NULL) {
+        return;
+    }
+    const wifi_promiscuous_pkt_t* pkt = (const wifi_promiscuous_pkt_t*)buf;
+    if (pkt->rx_ctrl.sig_len < 24) {
+        return;
+    }
+    const uint8_t* addr2 = pkt->payload + 10;
+    rssiMonitor->observeRssi(addr2, (int8_t)pkt->rx_ctrl.rssi);
+}
+
+bool startRssiMonitor(LinkQualityMonitor* monitor) {
+    rssiMonitor = monitor;
+    const wifi_promiscuous_filter_t filter = {WIFI_PROMIS_FILTER_MASK_MGMT};
+    if (esp_wifi_set_promiscuous_filter(&filter) != ESP_OK ||
+        esp_wifi_set_promiscuous_rx_cb(onPromiscuousRx) != ESP_OK ||
+        esp_wifi_set_promiscuous(true) != ESP_OK) {
+        rssiMonitor = NULL;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,240 @@
+#include <Arduino.h>
+#include <esp_now.h>
+#include <esp_random.h>
+#include <mbedtls/md.h>
+#include <nvs.h>
+#include <stdlib.h>
+
+#include "link_security.h"
+
+static const char* NVS_NAMESPACE = "cymouse";
+static const char* NVS_KEY_PAIRING = "pairkey";
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool pairingKeyFromHex(const char* hex, PairingKey& out) {
+    if (strlen(hex) != PAIRING_KEY_SIZE * 2) {
+        return false;
+    }
+    PairingKey key = {};
+    for (size_t i = 0; i < PAIRING_KEY_SIZE; i++) {
+        const int hi = hexDigit(hex[i * 2]);
+        const int lo = hexDigit(hex[i * 2 + 1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        key.key[i] = (uint8_t)((hi << 4) | lo);
+    }
+    key.valid = true;
+    out = key;
+    return true;
+}
+
+bool pairingKeyLoad(PairingKey& key) {
+    key = {};
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    size_t len = sizeof(key.key);
+    const esp_err_t err = nvs_get_blob(handle, NVS_KEY_PAIRING, key.key, &len);
+    nvs_close(handle);
+    key.valid = (err == ESP_OK && len == sizeof(key.key));
+    return key.valid;
+}
+
+bool pairingKeySave(const PairingKey& key) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        Serial.printf("错误：打开NVS失败 (%s)\n", esp_err_to_name(err));
+        return false;
+    }
+    err = nvs_set_blob(handle, NVS_KEY_PAIRING, key.key, sizeof(key.key));
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        Serial.printf("错误：保存配对密钥失败 (%s)\n", esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+bool pairingKeyErase() {
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return false;
+    }
+    esp_err_t err = nvs_erase_key(handle, NVS_KEY_PAIRING);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND;
+}
+
+static void hmacLabel(const PairingKey& key, const char label[4], const uint8_t* data, size_t len,
+                      uint8_t* out, size_t outLen) {
+    uint8_t input[4 + 6 + 6 + AUTH_NONCE_SIZE * 2];
+    memcpy(input, label, 4);
+    if (len > 0) {
+        memcpy(input + 4, data, len);
+    }
+    uint8_t digest[32];
+    mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), key.key, sizeof(key.key), input, 4 + len,
+                    digest);
+    memcpy(out, digest, outLen);
+}
+
+static void hmacSession(const PairingKey& key, const char label[4], const uint8_t senderMac[6],
+                        const uint8_t receiverMac[6], const uint8_t receiverNonce[AUTH_NONCE_SIZE],
+                        const uint8_t senderNonce[AUTH_NONCE_SIZE], uint8_t* out, size_t outLen) {
+    uint8_t data[6 + 6 + AUTH_NONCE_SIZE * 2];
+    memcpy(data, senderMac, 6);
+    memcpy(data + 6, receiverMac, 6);
+    memcpy(data + 12, receiverNonce, AUTH_NONCE_SIZE);
+    memcpy(data + 12 + AUTH_NONCE_SIZE, senderNonce, AUTH_NONCE_SIZE);
+    hmacLabel(key, label, data, sizeof(data), out, outLen);
+}
+
+void derivePrimaryMasterKey(const PairingKey& key, uint8_t pmk[LINK_KEY_SIZE]) {
+    hmacLabel(key, "CYP1", NULL, 0, pmk, LINK_KEY_SIZE);
+}
+
+void computeAuthTag(const PairingKey& key, const uint8_t senderMac[6], const uint8_t receiverMac[6],
+                    const uint8_t receiverNonce[AUTH_NONCE_SIZE], const uint8_t senderNonce[AUTH_NONCE_SIZE],
+                    uint8_t tag[AUTH_TAG_SIZE]) {
+    hmacSession(key, "CYA1", senderMac, receiverMac, receiverNonce, senderNonce, tag, AUTH_TAG_SIZE);
+}
+
+void deriveLinkKey(const PairingKey& key, const uint8_t senderMac[6], const uint8_t receiverMac[6],
+                   const uint8_t receiverNonce[AUTH_NONCE_SIZE], const uint8_t senderNonce[AUTH_NONCE_SIZE],
+                   uint8_t lmk[LINK_KEY_SIZE]) {
+    hmacSession(key, "CYK1", senderMac, receiverMac, receiverNonce, senderNonce, lmk, LINK_KEY_SIZE);
+}
+
+void deriveFrameKey(const PairingKey& key, const uint8_t senderMac[6], const uint8_t receiverMac[6],
+                    const uint8_t receiverNonce[AUTH_NONCE_SIZE], const uint8_t senderNonce[AUTH_NONCE_SIZE],
+                    uint8_t frameKey[LINK_KEY_SIZE]) {
+    hmacSession(key, "CYT1", senderMac, receiverMac, receiverNonce, senderNonce, frameKey, LINK_KEY_SIZE);
+}
+
+bool authTagEqual(const uint8_t a[AUTH_TAG_SIZE], const uint8_t b[AUTH_TAG_SIZE]) {
+    uint8_t diff = 0;
+    for (size_t i = 0; i < AUTH_TAG_SIZE; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+// --- 测速 ---
+constexpr uint32_t LINK_BENCH_MAX_FRAMES = 500;
+constexpr uint32_t LINK_BENCH_SEND_TIMEOUT_US = 20000;
+
+static volatile bool benchSendDone = false;
+static volatile bool benchSendOk = false;
+static volatile uint32_t benchSendDoneUs = 0;
+
+static void onBenchSent(const uint8_t* mac, esp_now_send_status_t status) {
+    benchSendDoneUs = micros();
+    benchSendOk = (status == ESP_NOW_SEND_SUCCESS);
+    benchSendDone = true;
+}
+
+static int compareU16(const void* a, const void* b) {
+    return (int)*(const uint16_t*)a - (int)*(const uint16_t*)b;
+}
+
+static void runLinkBench(const char* label, const uint8_t mac[6], uint32_t frames, size_t bytes) {
+    static uint16_t latencies[LINK_BENCH_MAX_FRAMES];
+    uint8_t frame[ESP_NOW_MAX_DATA_LEN] = {};
+    frame[0] = PACKET_TYPE_LINK_PROBE;
+
+    uint32_t ok = 0, failed = 0, timeouts = 0;
+    uint64_t callCycles = 0;
+    const uint32_t begin = micros();
+    for (uint32_t i = 0; i < frames; i++) {
+        frame[1] = (uint8_t)i;
+        benchSendDone = false;
+        const uint32_t start = micros();
+        const uint32_t startCycles = ESP.getCycleCount();
+        const esp_err_t err = esp_now_send(mac, frame, bytes);
+        callCycles += ESP.getCycleCount() - startCycles;
+        if (err != ESP_OK) {
+            failed++;
+            continue;
+        }
+        while (!benchSendDone && micros() - start < LINK_BENCH_SEND_TIMEOUT_US) {
+        }
+        if (!benchSendDone) {
+            timeouts++;
+            continue;
+        }
+        if (!benchSendOk) {
+            failed++;
+            continue;
+        }
+        const uint32_t latency = benchSendDoneUs - start;
+        latencies[ok++] = latency > UINT16_MAX ? UINT16_MAX : (uint16_t)latency;
+    }
+    const uint32_t elapsed = micros() - begin;
+
+    qsort(latencies, ok, sizeof(latencies[0]), compareU16);
+    const float kbps = elapsed ? (float)ok * bytes * 8 * 1000.0f / elapsed : 0.0f;
+    Serial.printf("[基准] %s %u 字节: 成功 %u 失败 %u 超时 %u, 发送完成延迟 p50=%uus p99=%uus, "
+                  "吞吐 %.1f kbit/s, esp_now_send 调用 %.0f 周期\n",
+                  label, (unsigned)bytes, ok, failed, timeouts, ok ? latencies[ok / 2] : 0,
+                  ok ? latencies[(ok * 99) / 100] : 0, kbps, frames ? (float)callCycles / frames : 0.0f);
+}
+
+void benchLinkCrypto(const uint8_t mac[6], const uint8_t* lmk, uint32_t frames, size_t bytes) {
+    if (frames > LINK_BENCH_MAX_FRAMES) {
+        frames = LINK_BENCH_MAX_FRAMES;
+    }
+    if (bytes < 2 || bytes > ESP_NOW_MAX_DATA_LEN) {
+        bytes = ESP_NOW_MAX_DATA_LEN;
+    }
+    esp_now_peer_info_t original;
+    if (esp_now_get_peer(mac, &original) != ESP_OK) {
+        Serial.println("错误：对端尚未注册，无法测速。");
+        return;
+    }
+
+    esp_now_peer_info_t plain = original;
+    plain.encrypt = false;
+    esp_now_peer_info_t encrypted = original;
+    encrypted.encrypt = true;
+    if (lmk != NULL) {
+        memcpy(encrypted.lmk, lmk, LINK_KEY_SIZE);
+    } else {
+        esp_fill_random(encrypted.lmk, LINK_KEY_SIZE);
+    }
+
+    // 派生一次会话密钥的 CPU 开销（每次配对只发生一次）
+    PairingKey key = {};
+    uint8_t nonce[AUTH_NONCE_SIZE] = {};
+    uint8_t out[LINK_KEY_SIZE];
+    const uint32_t deriveStart = ESP.getCycleCount();
+    deriveLinkKey(key, mac, mac, nonce, nonce, out);
+    const uint32_t deriveCycles = ESP.getCycleCount() - deriveStart;
+
+    esp_now_register_send_cb(onBenchSent);
+    if (esp_now_mod_peer(&plain) == ESP_OK) {
+        runLinkBench("明文", mac, frames, bytes);
+    }
+    if (esp_now_mod_peer(&encrypted) == ESP_OK) {
+        runLinkBench("加密", mac, frames, bytes);
+    } else {
+        Serial.println("错误：无法以加密方式注册对端（加密对端数量已满？）");
+    }
+    esp_now_unregister_send_cb();
+    esp_now_mod_peer(&original);
+    Serial.printf("[基准] 派生会话密钥 %u 周期\n", deriveCycles);
+}
@@ -0,0 +1,455 @@
+#include <Arduino.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "link_sim.h"
+
+// 第一个场景必须是无损的，用作对比参照
+const LinkSimScenario kLinkSimScenarios[] = {
+    {"clean", "无损、无延迟（参照）", {0.0f, 1.0f, 0.0f, 0.0f, 0, 0, 0.0f, 0.0f, 0}},
+    {"typical", "偶发短突发丢包，轻微抖动", {0.005f, 0.25f, 0.002f, 0.4f, 800, 400, 0.0f, 0.0f, 0}},
+    {"bursty", "长突发丢包（平均 20 帧），偶有乱序", {0.01f, 0.05f, 0.005f, 0.9f, 800, 1000, 0.0f, 0.01f, 3000}},
+    {"congested", "拥塞：高丢包、大抖动、重复与乱序", {0.03f, 0.15f, 0.03f, 0.6f, 1500, 4000, 0.01f, 0.05f, 5000}},
+    {"reorder", "无丢包，10% 的帧晚 2ms 送达", {0.0f, 1.0f, 0.0f, 0.0f, 800, 300, 0.02f, 0.1f, 2000}},
+    {"outage", "长时间中断（平均 4000 帧，约每 5000 帧一次），会触发心跳超时", {0.0002f, 0.00025f, 0.001f, 1.0f, 800, 400, 0.0f, 0.0f, 0}},
+};
+const size_t kLinkSimScenarioCount = sizeof(kLinkSimScenarios) / sizeof(kLinkSimScenarios[0]);
+
+const LinkSimScenario* linkSimFindScenario(const char* name) {
+    for (size_t i = 0; i < kLinkSimScenarioCount; i++) {
+        if (strcmp(kLinkSimScenarios[i].name, name) == 0) {
+            return &kLinkSimScenarios[i];
+        }
+    }
+    return NULL;
+}
+
+bool linkSimParseOverride(LinkSimParams& params, const char* token) {
+    const char* eq = strchr(token, '=');
+    if (eq == NULL || eq[1] == '\0') {
+        return false;
+    }
+    const size_t keyLen = eq - token;
+    const char* value = eq + 1;
+    static const struct {
+        const char* key;
+        float LinkSimParams::*probability;
+        uint32_t LinkSimParams::*micros;
+    } fields[] = {
+        {"pgb", &LinkSimParams::pGoodToBad, NULL},
+        {"pbg", &LinkSimParams::pBadToGood, NULL},
+        {"lossg", &LinkSimParams::lossGood, NULL},
+        {"lossb", &LinkSimParams::lossBad, NULL},
+        {"dup", &LinkSimParams::duplicate, NULL},
+        {"reorder", &LinkSimParams::reorder, NULL},
+        {"latency", NULL, &LinkSimParams::latencyUs},
+        {"jitter", NULL, &LinkSimParams::jitterUs},
+        {"delay", NULL, &LinkSimParams::reorderDelayUs},
+    };
+    for (const auto& field : fields) {
+        if (strlen(field.key) != keyLen || strncmp(field.key, token, keyLen) != 0) {
+            continue;
+        }
+        if (field.probability != NULL) {
+            const float p = atof(value);
+            if (p < 0.0f || p > 1.0f) {
+                return false;
+            }
+            params.*field.probability = p;
+        } else {
+            const long us = atol(value);
+            if (us < 0 || us > 1000000) {
+                return false;
+            }
+            params.*field.micros = (uint32_t)us;
+        }
+        return true;
+    }
+    return false;
+}
+
+void linkSimPrintParams(const LinkSimParams& params) {
+    Serial.printf("信道: 好->坏 %.4f 坏->好 %.4f 丢包率 好 %.3f 坏 %.3f | 延迟 %uus 抖动 %uus 重复 %.3f 乱序 %.3f(+%uus)\n",
+                  params.pGoodToBad, params.pBadToGood, params.lossGood, params.lossBad, params.latencyUs,
+                  params.jitterUs, params.duplicate, params.reorder, params.reorderDelayUs);
+}
+
+void LinkSimChannel::reset(const LinkSimParams& params, uint32_t seed) {
+    params_ = params;
+    random_.seed(seed);
+    bad_ = false;
+    sent_ = lost_ = duplicated_ = 0;
+    burst_ = longestBurst_ = 0;
+}
+
+uint32_t LinkSimChannel::deliveryTime(uint32_t sendUs) {
+    uint32_t at = sendUs + params_.latencyUs;
+    if (params_.jitterUs > 0) {
+        at += random_.next() % (params_.jitterUs + 1);
+    }
+    if (random_.chance(params_.reorder)) {
+        at += params_.reorderDelayUs;
+    }
+    return at;
+}
+
+uint8_t LinkSimChannel::transmit(uint32_t sendUs, uint32_t deliverUs[2]) {
+    sent_++;
+    bad_ = bad_ ? !random_.chance(params_.pBadToGood) : random_.chance(params_.pGoodToBad);
+    if (random_.chance(bad_ ? params_.lossBad : params_.lossGood)) {
+        lost_++;
+        if (++burst_ > longestBurst_) {
+            longestBurst_ = burst_;
+        }
+        return 0;
+    }
+    burst_ = 0;
+    deliverUs[0] = deliveryTime(sendUs);
+    if (!random_.chance(params_.duplicate)) {
+        return 1;
+    }
+    duplicated_++;
+    deliverUs[1] = deliveryTime(sendUs);
+    return 2;
+}
+
+bool simFormatFromName(const char* name, SimFormat& format) {
+    for (uint8_t i = SIM_FORMAT_MOTION; i <= SIM_FORMAT_PACKED; i++) {
+        if (strcmp(simFormatName((SimFormat)i), name) == 0) {
+            format = (SimFormat)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* simFormatName(SimFormat format) {
+    switch (format) {
+    case SIM_FORMAT_FEC: return "fec";
+    case SIM_FORMAT_CUMULATIVE: return "cumulative";
+    case SIM_FORMAT_PACKED: return "packed";
+    default: return "motion";
+    }
+}
+
+static constexpr uint32_t SIM_MOTION_STEPS = SIM_MOTION_US / SIM_INTERVAL_US;
+static constexpr uint32_t SIM_PAUSE_BEATS = (SIM_PAUSE_US - 1) / SIM_HEARTBEAT_US;
+static constexpr uint32_t SIM_PERIOD_US = SIM_MOTION_US + SIM_PAUSE_US;
+static constexpr float SIM_SEGMENT_DISTANCE = 2000.0f; // 每段的位移（计数）
+static constexpr float SIM_GOLDEN_ANGLE = 2.39996323f;  // 相邻段方向相差黄金角，覆盖各个方向
+
+void SimTrafficSource::reset(SimFormat format, uint32_t durationUs) {
+    format_ = format;
+    segments_ = (durationUs + SIM_PERIOD_US - 1) / SIM_PERIOD_US;
+    if (segments_ == 0) {
+        segments_ = 1;
+    }
+    segment_ = step_ = 0;
+    seq_ = 0;
+    segX_ = segY_ = 0;
+    truthX_ = truthY_ = 0;
+    historyCount_ = 0;
+    totalX_ = totalY_ = 0;
+    batchCount_ = 0;
+    lastButtons_ = 0;
+    prepare();
+}
+
+void SimTrafficSource::take(SimEvent& event) {
+    event = pending_;
+    prepare();
+}
+
+// 本段第 step_ 个样本：位移沿 (1 - cos) 曲线平滑加速再减速，取整后与上一样本相减，全段总和精确
+void SimTrafficSource::sample(int16_t& dx, int16_t& dy) {
+    const float angle = segment_ * SIM_GOLDEN_ANGLE;
+    const float u = (float)step_ / SIM_MOTION_STEPS;
+    const float distance = SIM_SEGMENT_DISTANCE * (1.0f - cosf((float)M_PI * u)) * 0.5f;
+    const int32_t x = lroundf(distance * cosf(angle));
+    const int32_t y = lroundf(distance * sinf(angle));
+    dx = (int16_t)(x - segX_);
+    dy = (int16_t)(y - segY_);
+    segX_ = x;
+    segY_ = y;
+    truthX_ += dx;
+    truthY_ += dy;
+}
+
+void SimTrafficSource::encodeSample(uint32_t atUs, int16_t dx, int16_t dy, bool lastInSegment) {
+    pending_.atUs = atUs;
+    pending_.kind = SIM_EVENT_FRAME;
+    const uint16_t seq = seq_++;
+
+    switch (format_) {
+    case SIM_FORMAT_FEC: {
+        MotionFecPacket packet = {};
+        packet.type = PACKET_TYPE_MOTION_FEC;
+        packet.seq = seq;
+        packet.intervalUs = SIM_INTERVAL_US;
+        packet.deltaX = dx;
+        packet.deltaY = dy;
+        packet.redundancy = historyCount_ < SIM_FEC_REDUNDANCY ? historyCount_ : SIM_FEC_REDUNDANCY;
+        memcpy(packet.history, history_, sizeof(packet.history));
+        pending_.len = (uint8_t)(FEC_HEADER_SIZE + packet.redundancy * sizeof(RedundantSample));
+        memcpy(pending_.data, &packet, pending_.len);
+        // history[i] 对应序号 seq-1-i
+        memmove(&history_[1], &history_[0], sizeof(history_) - sizeof(history_[0]));
+        history_[0] = {dx, dy, 0, 0};
+        if (historyCount_ < FEC_MAX_REDUNDANCY) {
+            historyCount_++;
+        }
+        hasPending_ = true;
+        break;
+    }
+    case SIM_FORMAT_CUMULATIVE: {
+        totalX_ += (uint32_t)(int32_t)dx;
+        totalY_ += (uint32_t)(int32_t)dy;
+        CumulativeMotionPacket packet = {};
+        packet.type = PACKET_TYPE_MOTION_CUMULATIVE;
+        packet.seq = seq;
+        packet.intervalUs = SIM_INTERVAL_US;
+        packet.totalX = totalX_;
+        packet.totalY = totalY_;
+        pending_.len = sizeof(packet);
+        memcpy(pending_.data, &packet, sizeof(packet));
+        hasPending_ = true;
+        break;
+    }
+    case SIM_FORMAT_PACKED: {
+        batch_[batchCount_++] = {dx, dy, 0, 0};
+        if (batchCount_ < SIM_PACKED_BATCH && !lastInSegment) {
+            return;
+        }
+        const uint16_t first = (uint16_t)(seq + 1 - batchCount_);
+        pending_.len = (uint8_t)encodePackedMotion(batch_, batchCount_, first, SIM_INTERVAL_US, lastButtons_, false,
+                                                   pending_.data, sizeof(pending_.data));
+        batchCount_ = 0;
+        hasPending_ = pending_.len > 0;
+        break;
+    }
+    default: {
+        MotionPacket packet = {};
+        packet.type = PACKET_TYPE_MOTION;
+        packet.seq = seq;
+        packet.intervalUs = SIM_INTERVAL_US;
+        packet.deltaX = dx;
+        packet.deltaY = dy;
+        pending_.len = sizeof(packet);
+        memcpy(pending_.data, &packet, sizeof(packet));
+        hasPending_ = true;
+        break;
+    }
+    }
+}
+
+void SimTrafficSource::prepare() {
+    hasPending_ = false;
+    while (!hasPending_ && segment_ < segments_) {
+        const uint32_t base = segment_ * SIM_PERIOD_US;
+        if (step_ < SIM_MOTION_STEPS) {
+            step_++;
+            int16_t dx, dy;
+            sample(dx, dy);
+            encodeSample(base + step_ * SIM_INTERVAL_US, dx, dy, step_ == SIM_MOTION_STEPS);
+        } else if (step_ < SIM_MOTION_STEPS + SIM_PAUSE_BEATS) {
+            step_++;
+            UniversalPacket heartbeat = {};
+            heartbeat.type = PACKET_TYPE_HEARTBEAT;
+            pending_.atUs = base + SIM_MOTION_US + (step_ - SIM_MOTION_STEPS) * SIM_HEARTBEAT_US;
+            pending_.kind = SIM_EVENT_FRAME;
+            pending_.len = sizeof(heartbeat);
+            memcpy(pending_.data, &heartbeat, sizeof(heartbeat));
+            hasPending_ = true;
+        } else {
+            pending_.atUs = base + SIM_PERIOD_US;
+            pending_.kind = SIM_EVENT_CHECKPOINT;
+            pending_.len = 0;
+            hasPending_ = true;
+            segment_++;
+            step_ = 0;
+            segX_ = segY_ = 0;
+        }
+    }
+}
+
+void SimDeliveryQueue::push(uint32_t deliverUs, uint32_t sendUs, const uint8_t* data, uint8_t len) {
+    if (size_ == SIM_IN_FLIGHT_CAPACITY || len > SIM_MAX_FRAME) {
+        overflows_++;
+        return;
+    }
+    size_t i = size_++;
+    heap_[i].deliverUs = deliverUs;
+    heap_[i].sendUs = sendUs;
+    heap_[i].len = len;
+    memcpy(heap_[i].data, data, len);
+    while (i > 0) {
+        const size_t parent = (i - 1) / 2;
+        if (!earlier(heap_[i], heap_[parent])) {
+            break;
+        }
+        const SimDelivery tmp = heap_[i];
+        heap_[i] = heap_[parent];
+        heap_[parent] = tmp;
+        i = parent;
+    }
+}
+
+void SimDeliveryQueue::pop() {
+    if (size_ == 0) {
+        return;
+    }
+    heap_[0] = heap_[--size_];
+    size_t i = 0;
+    for (;;) {
+        const size_t left = 2 * i + 1;
+        const size_t right = left + 1;
+        size_t smallest = i;
+        if (left < size_ && earlier(heap_[left], heap_[smallest])) {
+            smallest = left;
+        }
+        if (right < size_ && earlier(heap_[right], heap_[smallest])) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            break;
+        }
+        const SimDelivery tmp = heap_[i];
+        heap_[i] = heap_[smallest];
+        heap_[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+void LatencyHistogram::reset() {
+    memset(buckets_, 0, sizeof(buckets_));
+    count_ = 0;
+    max_ = 0;
+}
+
+void LatencyHistogram::add(uint32_t us) {
+    const size_t bucket = us / LATENCY_BUCKET_US;
+    buckets_[bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1]++;
+    count_++;
+    if (us > max_) {
+        max_ = us;
+    }
+}
+
+uint32_t LatencyHistogram::percentileUs(uint8_t percent) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    const uint32_t target = (count_ * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += buckets_[i];
+        if (seen >= target) {
+            // 档的上界可能超过实际记录到的最大值（例如全部样本都是 0）
+            const uint32_t upper = (uint32_t)(i + 1) * LATENCY_BUCKET_US;
+            return upper < max_ ? upper : max_;
+        }
+    }
+    return max_;
+}
+
+void simCursorError(const SimPassResult& ref, const SimPassResult& run, float& mean, float& worst) {
+    const uint32_t count = ref.checkpoints < run.checkpoints ? ref.checkpoints : run.checkpoints;
+    float sum = 0.0f;
+    worst = 0.0f;
+    for (uint32_t i = 0; i < count; i++) {
+        const float error = hypotf((float)(run.checkX[i] - ref.checkX[i]), (float)(run.checkY[i] - ref.checkY[i]));
+        sum += error;
+        if (error > worst) {
+            worst = error;
+        }
+    }
+    mean = count ? sum / count : 0.0f;
+}
+
+static void printSimPass(const char* label, const SimPassResult& r) {
+    Serial.printf("[仿真] %s: 发送 %u 丢失 %u (最长连续 %u) 重复 %u 乱序 %u 在途溢出 %u\n", label, r.sent, r.lost,
+                  r.longestBurst, r.duplicated, r.reordered, r.overflows);
+    Serial.printf("[仿真] %s: 队列丢包 %u FEC恢复 %u FEC无法恢复 %u 重新同步 %u 断线 %u HID报告 %u "
+                  "延迟 p50=%uus p99=%uus 最大=%uus\n",
+                  label, r.queueDrops, r.fecRecovered, r.fecUnrecoverable, r.resyncs, r.disconnects, r.reports,
+                  r.latencyP50, r.latencyP99, r.latencyMax);
+}
+
+void simPrintComparison(const char* scenario, SimFormat format, uint32_t seed, int32_t truthX, int32_t truthY,
+                        const SimPassResult& ref, const SimPassResult& run) {
+    Serial.printf("[仿真] 场景 %s 格式 %s 种子 %u，发送端总位移 (%d, %d)\n", scenario, simFormatName(format), seed,
+                  truthX, truthY);
+    printSimPass("参照", ref);
+    printSimPass(scenario, run);
+    float mean, worst;
+    simCursorError(ref, run, mean, worst);
+    Serial.printf("[仿真] 光标误差（相对参照）: 检查点 %u 个 平均 %.1f 最大 %.1f，终点偏差 (%d, %d)\n",
+                  ref.checkpoints < run.checkpoints ? ref.checkpoints : run.checkpoints, mean, worst,
+                  run.finalX - ref.finalX, run.finalY - ref.finalY);
+}
+
+void simDefaultSettings(SimSettings& settings) {
+    settings.scenario = &kLinkSimScenarios[0];
+    settings.params = settings.scenario->params;
+    settings.format = SIM_FORMAT_MOTION;
+    settings.seconds = 5;
+    settings.seed = 1;
+    settings.overridden = false;
+}
+
+bool simParseSettingLine(SimSettings& settings, const char* line) {
+    // 去掉注释和首尾空白
+    char token[64];
+    size_t len = strcspn(line, "#\r\n");
+    while (len > 0 && isspace((unsigned char)line[len - 1])) {
+        len--;
+    }
+    while (len > 0 && isspace((unsigned char)*line)) {
+        line++;
+        len--;
+    }
+    if (len == 0) {
+        return true;
+    }
+    if (len >= sizeof(token)) {
+        return false;
+    }
+    memcpy(token, line, len);
+    token[len] = '\0';
+    const char* eq = strchr(token, '=');
+    if (eq == NULL || strpbrk(token, " \t") != NULL) {
+        return false;
+    }
+    const size_t keyLen = eq - token;
+    const char* value = eq + 1;
+    char* end = NULL;
+
+    if (keyLen == 8 && strncmp(token, "scenario", keyLen) == 0) {
+        const LinkSimScenario* scenario = linkSimFindScenario(value);
+        if (scenario == NULL || settings.overridden) {
+            return false;
+        }
+        settings.scenario = scenario;
+        settings.params = scenario->params;
+    } else if (keyLen == 6 && strncmp(token, "format", keyLen) == 0) {
+        return simFormatFromName(value, settings.format);
+    } else if (keyLen == 7 && strncmp(token, "seconds", keyLen) == 0) {
+        const unsigned long seconds = strtoul(value, &end, 10);
+        if (*value == '\0' || *end != '\0' || seconds == 0 || seconds > SIM_MAX_SECONDS) {
+            return false;
+        }
+        settings.seconds = (uint32_t)seconds;
+    } else if (keyLen == 4 && strncmp(token, "seed", keyLen) == 0) {
+        const unsigned long seed = strtoul(value, &end, 0);
+        if (*value == '\0' || *end != '\0') {
+            return false;
+        }
+        settings.seed = (uint32_t)seed;
+    } else {
+        if (!linkSimParseOverride(settings.params, token)) {
+            return false;
+        }
+        settings.overridden = true;
+    }
+    return true;
+}
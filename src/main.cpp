@@ -1,148 +1,406 @@
 #include <Arduino.h>
 #include <esp_now.h>
 #include <USB.h>
-#include <USBHIDMouse.h>
 #include <esp_wifi.h>
 #include <esp_log.h>
 #include <esp_err.h>
 #include <esp_netif.h>
 #include <esp_event.h>
+#include <esp_timer.h>
+#include <esp_random.h>
 #include <nvs_flash.h>
 #include <string.h>
+#include <atomic>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
 
+#include "accel.h"
+#include "capture.h"
+#include "clock.h"
+#include "config.h"
+#include "connection.h"
+#include "console.h"
+#include "dpi_scale.h"
+#include "frame_auth.h"
+#include "frame_parser.h"
+#include "handshake.h"
+#include "hid_tap.h"
+#include "hires_mouse.h"
+#include "jitter_buffer.h"
+#include "jitter_filter.h"
+#include "keyboard.h"
+#include "link_feedback.h"
+#include "link_security.h"
+#include "link_sim.h"
+#include "microbench.h"
+#include "motion_predictor.h"
+#include "packed_motion.h"
+#include "protocol.h"
+#include "pipeline.h"
+#include "receive_path.h"
+#include "replay.h"
+#include "spsc_ring.h"
+
 // --- 配置定义 ---
-#define WIFI_CHANNEL 13
-#define CONNECTION_TIMEOUT 3000 // 3秒无数据则认为连接丢失
+// 可调参数统一在 config.h 的 kReceiverConfig 中
+constexpr const ReceiverConfig& CFG = kReceiverConfig;
 const char* MY_DEVICE_NAME = "CyMouseReceiver_V1";
 uint8_t broadcastAddress[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
 
-// --- 数据结构定义 ---
-typedef enum {
-    PACKET_TYPE_DISCOVERY = 0,
-    PACKET_TYPE_MOUSE_DATA,
-    PACKET_TYPE_HEARTBEAT // 新增心跳包类型
-} PacketType;
+// --- 全局变量 ---
+static HidReportQueue hidQueue(0); // 鼠标与键盘共用的 HID 接口
+HiResMouse Mouse(hidQueue);
+// 出队之后的抖动缓冲与管线，仅在 mouseTask 中处理样本（set* 参数可由其他任务暂存）
+static ReceivePath<kReceiverConfig, HiResMouse> receivePath(Mouse, systemClock);
+static MousePipeline<kReceiverConfig, HiResMouse>& pipeline = receivePath.pipeline();
+static KeyboardRelay* keyboardRelay = NULL;    // features.keyboard 打开时在 setup() 中创建
+static QueueHandle_t keyboardQueue = NULL;     // 键盘状态帧，由 mouseTask 处理
+// 接收 -> HID 输出的无锁通道。生产者是接收回调，或接管了解析路径的回放/仿真/负载测试；消费者是 mouseTask
+static SpscRing<QueueItem_t, CFG.queueLength> mouseDataQueue;
+static TaskHandle_t mouseTaskHandle = NULL;   // 入队后通知它取数据
+static volatile uint32_t queueDropCount = 0; // 队列满导致的丢包数
+static FrameParser frameParser;               // 仅在接收回调中使用
+static QueueHandle_t controlQueue;            // 握手、新连接登记等控制消息，由控制任务处理
+static LinkQualityMonitor linkMonitor;            // 丢包率/RSSI/队列深度统计
+static AccelCurveParams accelParams = CFG.accel; // 当前生效的加速曲线参数
+static JitterFilterParams jitterParams = CFG.jitter; // 当前生效的抖动滤波参数
+static PredictorParams predictorParams = CFG.predictor; // 当前生效的外推参数
+static JitterBufferParams jitterBufferParams = CFG.jitterBuffer; // 当前生效的抖动缓冲参数
+static esp_timer_handle_t playoutTimer = NULL;  // 到播放时间时唤醒 mouseTask（精度高于系统节拍）
+static DpiScaleTable dpiTable;                   // 按发送端的DPI缩放表（持久化在NVS）
+static portMUX_TYPE dpiTableMux = portMUX_INITIALIZER_UNLOCKED;
+static PairingKey pairingKey;                    // 配对密钥（持久化在NVS），设置后只接受认证配对
+static volatile bool authRequired = false;       // 供 mouseTask 读取的 pairingKey.valid 副本
+static std::atomic<uint32_t> peerPacketMs{0};    // mouseTask 最近收到对端数据包的时刻，控制任务取走后刷新心跳（0 = 没有新的）
+static bool linkEncrypted = false;               // 当前连接是否已启用加密
+static uint8_t linkKey[LINK_KEY_SIZE];           // 当前连接的 LMK
+static bool preferFrameTags = CFG.preferFrameTags; // 认证配对时优先协商明文帧 + 认证标签
+static FrameAuthenticator frameAuth;             // 快速模式下在接收回调中验证帧标签
+static std::atomic<bool> replayActive{false};    // 回放/链路仿真/负载测试期间忽略无线数据
+static std::atomic<bool> radioIngestBusy{false}; // 接收回调正在解析（接管解析路径前要等它退出）
+static volatile uint32_t dispatchArrivalUs = 0;  // mouseTask 正在处理的数据项的到达时间（负载测试计算延迟）
+static volatile bool usbSuspended = false;       // USB 主机已挂起（由 USB 事件任务写入）
+static volatile bool usbRemoteWakeup = false;    // 挂起时主机是否允许远程唤醒
+static volatile uint32_t usbSuspendCount = 0;
+
+// 已发出挑战、等待应答的配对请求（仅在控制任务中访问）
+static struct {
+    bool active;
+    uint8_t mac[6];
+    uint8_t nonce[AUTH_NONCE_SIZE];
+    LinkMode mode;
+    uint32_t issuedAt;
+} pendingAuth;
+
 
-#pragma pack(push, 1)
+// 键盘队列项：记录来源，认证模式下只接受已认证对端的按键
 typedef struct {
-    PacketType type;
-    char deviceName[32];
-    int16_t deltaX;
-    int16_t deltaY;
-    int8_t wheel;
-    uint8_t buttons;
-} UniversalPacket;
-#pragma pack(pop)
+    uint8_t mac_addr[6];
+    KeyboardPacket packet;
+} KeyboardMessage;
+
+// 控制消息类型（与包类型共用 type 字段）
+enum : uint8_t {
+    CONTROL_PEER_SEEN = 0xFF, // 未连接时收到了数据包（由 mouseTask 发出，控制任务以它建立旧式连接）
+    CONTROL_RECONNECT = 0xFE, // 以旧式链路模式重建连接（链路仿真在两遍之间清空管线状态）
+};
 
+// 控制消息：从接收回调、mouseTask 或仿真任务转交给控制任务
 typedef struct {
     uint8_t mac_addr[6];
-    PacketType type; // 新增type字段，用于区分包类型
-    int16_t deltaX;
-    int16_t deltaY;
-    int8_t wheel;
-    uint8_t buttons;
-} QueueItem_t;
+    uint8_t type; // PACKET_TYPE_HELLO / PACKET_TYPE_AUTH_RESPONSE / CONTROL_*
+    union {
+        HelloPacket hello;
+        AuthResponsePacket auth;
+    };
+} ControlMessage;
 
-// --- 全局变量 ---
-USBHIDMouse Mouse;
-static QueueHandle_t mouseDataQueue;
-static bool isConnected = false;
-static unsigned long lastPacketTime = 0; // 用于心跳检测
-static uint8_t peerMacAddress[6] = {0};   // 保存已连接的对端MAC地址
+// 连接状态机的对外动作：对等设备增删、身份广播和日志
+class ReceiverConnectionEvents final : public ConnectionEvents {
+public:
+    void onConnected(const uint8_t mac[6], const LinkMode& mode) override;
+    void onDisconnected(const uint8_t mac[6], DisconnectReason reason) override;
+    void onBeacon() override;
+};
+
+static ReceiverConnectionEvents connectionEvents;
+// 连接状态：对端 MAC、链路模式、心跳超时与广播。只在控制任务中修改，其他任务读 connection.snapshot()；
+// 快照中的 generation 每建立一次连接加一，mouseTask 据此清空残留状态
+static ConnectionManager connection({CFG.connectionTimeoutMs, CFG.beaconIntervalMs}, systemClock, connectionEvents);
+
+// 送入通道；通道满时计数后丢弃。设置了配对密钥时只接受已认证对端的数据，
+// 未认证的发送端不能靠首个数据包配对，它的帧在这里就丢掉，不占用通道
+static void enqueueItem(const QueueItem_t& item) {
+    if (authRequired && !connection.snapshot().isPeer(item.mac_addr)) {
+        return;
+    }
+    if (!mouseDataQueue.push(item)) {
+        queueDropCount++;
+    }
+    if constexpr (CFG.features.feedback) {
+        // 由冗余恢复的样本不算空中收到的帧，否则会掩盖真实丢包
+        if ((item.flags & QUEUE_ITEM_HAS_SEQ) && !(item.flags & QUEUE_ITEM_RECOVERED)) {
+            linkMonitor.observeSequence(item.mac_addr, item.seq);
+        }
+        linkMonitor.observeQueueDepth((uint8_t)mouseDataQueue.size());
+    }
+}
 
+static void parseDataFrame(const uint8_t *mac_addr, const uint8_t *data, int data_len, uint32_t arrivalUs);
 
-// ESP-NOW数据接收回调
-// 职责：只负责接收数据包，验证类型和长度，然后快速送入队列。不做任何业务逻辑。
+static void ingestRadioFrame(const uint8_t *mac_addr, const uint8_t *data, int data_len);
+
+// ESP-NOW数据接收回调（Wi-Fi 任务，核 0）
+// 职责：接收阶段。校验、认证、解码和过滤在这里完成，合法的样本经无锁通道交给 HID 输出任务。不做任何业务逻辑。
 void OnDataRecv(const uint8_t *mac_addr, const uint8_t *data, int data_len) {
-    if (data_len != sizeof(UniversalPacket)) {
-        return; // 长度不匹配，立即丢弃
+    radioIngestBusy = true;
+    // 回放/仿真/负载测试期间不接收无线数据，避免两路数据混在一起（通道只允许一个生产者）
+    if (!replayActive) {
+        ingestRadioFrame(mac_addr, data, data_len);
+    }
+    radioIngestBusy = false;
+}
+
+static void ingestRadioFrame(const uint8_t *mac_addr, const uint8_t *data, int data_len) {
+    const uint32_t arrivalUs = micros();
+
+    // 配对握手：交给控制任务处理，不占用高优先级的鼠标任务
+    if (FrameParser::isControl(data, data_len)) {
+        ControlMessage msg;
+        memcpy(msg.mac_addr, mac_addr, 6);
+        msg.type = data[0];
+        memcpy(&msg.hello, data, data_len);
+        xQueueSendFromISR(controlQueue, &msg, NULL);
+        return;
+    }
+
+    // 快速模式：先验证并去掉帧尾的认证标签，未通过（伪造/重放/非对端）的帧直接丢弃
+    if (frameAuth.active()) {
+        if (!frameAuth.verify(mac_addr, data, data_len)) {
+            return;
+        }
+        data_len -= FRAME_TAG_SIZE;
+    }
+
+    captureFrame(mac_addr, data, data_len, arrivalUs);
+    parseDataFrame(mac_addr, data, data_len, arrivalUs);
+}
+
+// 通知 mouseTask 通道中有新数据（一帧展开的多项全部入队后只通知一次）
+static void wakeMouseTask() {
+    if (mouseTaskHandle != NULL) {
+        xTaskNotifyGive(mouseTaskHandle);
+    }
+}
+
+// 解析数据帧并送入通道（无线接收与回放共用）
+static void parseDataFrame(const uint8_t *mac_addr, const uint8_t *data, int data_len, uint32_t arrivalUs) {
+    const FrameRoute route = frameParser.parse(mac_addr, data, data_len, arrivalUs, enqueueItem);
+    if (route == FRAME_QUEUED) {
+        wakeMouseTask();
+        return;
+    }
+    if (route != FRAME_KEYBOARD) {
+        return; // 控制帧在接收回调中已转交，其余为非法或不接收的帧
+    }
+
+    // 键盘帧：状态放进键盘队列，再在鼠标通道中放一个通知项，保持与鼠标数据的先后顺序
+    if (keyboardQueue != NULL) {
+        KeyboardMessage msg;
+        memcpy(msg.mac_addr, mac_addr, 6);
+        memcpy(&msg.packet, data, sizeof(msg.packet));
+        if (xQueueSendFromISR(keyboardQueue, &msg, NULL) == pdTRUE) {
+            QueueItem_t item = {};
+            memcpy(item.mac_addr, mac_addr, 6);
+            item.type = PACKET_TYPE_KEYBOARD;
+            item.arrivalUs = arrivalUs;
+            enqueueItem(item);
+            wakeMouseTask();
+        }
+    }
+}
+
+void printMac(const uint8_t mac[6]) {
+    for (int i = 0; i < 6; i++) {
+        Serial.printf("%02X", mac[i]);
+        if (i < 5) Serial.print(":");
     }
+}
 
-    UniversalPacket* packet = (UniversalPacket*)data;
+// 将发送端添加为对等设备，以便向它单播；给出 lmk 时以加密方式注册
+void registerPeer(const uint8_t mac[6], const uint8_t* lmk = NULL) {
+    esp_now_peer_info_t peerInfo = {};
+    memcpy(peerInfo.peer_addr, mac, 6);
+    peerInfo.channel = CFG.wifiChannel;
+    peerInfo.encrypt = (lmk != NULL);
+    if (lmk != NULL) {
+        memcpy(peerInfo.lmk, lmk, LINK_KEY_SIZE);
+    }
+    peerInfo.ifidx = WIFI_IF_STA;
+    
+    // 尝试添加对等设备，如果已存在则尝试修改
+    if (esp_now_add_peer(&peerInfo) != ESP_OK) {
+        if (esp_now_mod_peer(&peerInfo) == ESP_OK) {
+            Serial.println("对等设备已存在，更新信息成功。");
+        } else {
+            Serial.println("警告：添加或更新对等设备失败。");
+        }
+    } else {
+        Serial.println("已将发送端添加为对等设备。");
+    }
+}
+
+void applyPeerDpiScale(const uint8_t mac[6]);
 
-    // 现在接收数据包或心跳包
-    if (packet->type == PACKET_TYPE_MOUSE_DATA || packet->type == PACKET_TYPE_HEARTBEAT) {
-        QueueItem_t item;
-        memcpy(item.mac_addr, mac_addr, 6);
-        item.type = packet->type; // 记录包类型
-        item.deltaX = packet->deltaX;
-        item.deltaY = packet->deltaY;
-        item.wheel = packet->wheel;
-        item.buttons = packet->buttons;
+// 连接建立：按对端下发DPI缩放，开始统计它的链路质量
+void ReceiverConnectionEvents::onConnected(const uint8_t mac[6], const LinkMode& mode) {
+    applyPeerDpiScale(mac);
+    linkMonitor.setPeer(mac);
+}
+
+// 将指定发送端的DPI缩放系数下发给管线
+void applyPeerDpiScale(const uint8_t mac[6]) {
+    int32_t scaleX, scaleY;
+    portENTER_CRITICAL(&dpiTableMux);
+    dpiTableLookup(dpiTable, mac, scaleX, scaleY);
+    portEXIT_CRITICAL(&dpiTableMux);
+    pipeline.setDpiScale(scaleX, scaleY);
+}
 
-        xQueueSendFromISR(mouseDataQueue, &item, NULL);
+// USB 事件回调（USB 事件任务上下文）：主机挂起时停止广播、让发送端降速，恢复后立即回到全速。
+// HID 设备自己按 tud_suspended() 停止提交报告并负责远程唤醒。这里只记录状态，由控制任务打印。
+static void onUsbEvent(void* arg, esp_event_base_t base, int32_t id, void* data) {
+    if (id == ARDUINO_USB_SUSPEND_EVENT) {
+        const arduino_usb_event_data_t* event = (const arduino_usb_event_data_t*)data;
+        usbRemoteWakeup = event->suspend.remote_wakeup_en;
+        usbSuspended = true;
+        usbSuspendCount++;
+    } else if (id == ARDUINO_USB_RESUME_EVENT) {
+        usbSuspended = false;
     }
 }
 
-// 高优先级任务，用于处理鼠标数据和USB HID通信
-// 职责：处理队列数据，执行配对逻辑，并控制USB HID。
+// 在控制任务中报告 USB 挂起/恢复（两次检查之间来回切换的不打印，见统计中的挂起次数）
+static void serviceUsbState() {
+    static bool reported = false;
+    const bool suspended = usbSuspended;
+    if (suspended == reported) {
+        return;
+    }
+    reported = suspended;
+    if (suspended) {
+        Serial.printf("USB 主机已挂起（远程唤醒%s）。\n", usbRemoteWakeup ? "已允许" : "未允许");
+    } else {
+        Serial.println("USB 主机已恢复。");
+    }
+}
+
+// 播放定时器回调：唤醒 mouseTask，及时放出到期的样本（不向通道写入，通道只有一个生产者）
+static void onPlayoutTimer(void* arg) {
+    wakeMouseTask();
+}
+
+// 系统节拍只有 1ms，亚毫秒级的播放时间由 esp_timer 单次定时器唤醒
+static void schedulePlayoutWake() {
+    static bool armed = false;
+    static uint32_t armedAt = 0;
+    uint32_t playAt;
+    if (playoutTimer == NULL || !receivePath.nextPlayAt(playAt) || (armed && playAt == armedAt)) {
+        return;
+    }
+    const int32_t remaining = (int32_t)(playAt - systemClock.nowUs());
+    esp_timer_stop(playoutTimer);
+    esp_timer_start_once(playoutTimer, remaining > 0 ? remaining : 1);
+    armed = true;
+    armedAt = playAt;
+}
+
+// 处理键盘队列中积压的全部状态帧（通知项可能因鼠标队列满而丢失，因此一次取完）
+static void drainKeyboardQueue() {
+    const ConnectionSnapshot link = connection.snapshot();
+    KeyboardMessage msg;
+    while (xQueueReceive(keyboardQueue, &msg, 0) == pdTRUE) {
+        if (!authRequired || link.isPeer(msg.mac_addr)) {
+            keyboardRelay->apply(msg.packet);
+        }
+    }
+}
+
+// 未连接时收到数据包：请控制任务以这个发送端建立连接（旧发送端不握手）。控制任务处理之前陆续到达的
+// 数据包不再重复发送，超过一个控制周期仍未连接（队列满或被拒绝）才再发一次
+static void postPeerSeen(const uint8_t mac[6]) {
+    static bool posted = false;
+    static uint32_t postedAt = 0;
+    const uint32_t now = systemClock.nowMs();
+    if (posted && now - postedAt < CFG.loopIntervalMs) {
+        return;
+    }
+    ControlMessage msg;
+    memcpy(msg.mac_addr, mac, 6);
+    msg.type = CONTROL_PEER_SEEN;
+    posted = xQueueSend(controlQueue, &msg, 0) == pdTRUE;
+    postedAt = now;
+}
+
+// 高优先级任务（核 1），HID 输出阶段：从通道取出样本，经管线变换后向 USB HID 发送报告。
+// 不修改连接状态，也不做对等设备登记、NVS 读写或日志输出，这些都交给控制任务。
 void mouseTask(void *pvParameters) {
     QueueItem_t receivedItem;
-    uint8_t lastButtons = 0;
-
-    Serial.println("鼠标处理任务已启动。");
+    uint32_t seenGeneration = 0;
 
     for (;;) {
-        if (xQueueReceive(mouseDataQueue, &receivedItem, portMAX_DELAY) == pdTRUE) {
-            
-            // 收到任何数据包都代表连接是活动的，更新心跳时间
-            lastPacketTime = millis();
-
-            // 当我们收到第一个鼠标数据包时，意味着发送端已经与我们配对成功。
-            // 此时我们才需要将发送端添加为对等设备，并标记连接状态。
-            if (!isConnected) {
-                Serial.print("收到首个鼠标数据包，连接建立！发送端 MAC: ");
-                for (int i = 0; i < 6; i++) {
-                    Serial.printf("%02X", receivedItem.mac_addr[i]);
-                    if (i < 5) Serial.print(":");
-                }
-                Serial.println();
-                
-                // 保存对端的MAC地址，以便断开连接时使用
-                memcpy(peerMacAddress, receivedItem.mac_addr, 6);
-
-                esp_now_peer_info_t peerInfo = {};
-                memcpy(peerInfo.peer_addr, peerMacAddress, 6);
-                peerInfo.channel = WIFI_CHANNEL;
-                peerInfo.encrypt = false;
-                peerInfo.ifidx = WIFI_IF_STA;
-                
-                // 尝试添加对等设备，如果已存在则尝试修改
-                if (esp_now_add_peer(&peerInfo) != ESP_OK) {
-                    if (esp_now_mod_peer(&peerInfo) == ESP_OK) {
-                        Serial.println("对等设备已存在，更新信息成功。");
-                    } else {
-                        Serial.println("警告：添加或更新对等设备失败。");
-                    }
-                } else {
-                    Serial.println("已将发送端添加为对等设备。");
-                }
-                isConnected = true; // 确认连接
+        if constexpr (CFG.features.jitterBuffer) {
+            schedulePlayoutWake();
+        }
+        // 开启外推或按键保活时，最多只等到下一个截止时间；有积压的 HID 报告时每个节拍重试一次
+        TickType_t wait = pipeline.ticksUntilDue();
+        if (hidQueue.flush() > 0 && wait > 1) {
+            wait = 1;
+        }
+        // 通道为空时等待接收回调或播放定时器的通知（通知在入队之后发出，不会漏掉）
+        if (mouseDataQueue.empty()) {
+            ulTaskNotifyTake(pdTRUE, wait);
+        }
+
+        while (mouseDataQueue.pop(receivedItem)) {
+            // 对端的数据包代表连接是活动的，把到达时间交给控制任务刷新心跳。
+            // 旧发送端不握手：未连接时收到的数据包意味着发送端已经与我们配对成功，
+            // 由控制任务建立连接并把发送端添加为对等设备。
+            const ConnectionSnapshot link = connection.snapshot();
+            if (link.isPeer(receivedItem.mac_addr)) {
+                peerPacketMs.store(systemClock.nowMs(), std::memory_order_relaxed);
+            } else if (!link.connected) {
+                postPeerSeen(receivedItem.mac_addr);
             }
-            
-            // 只有当包类型是MOUSE_DATA时，才处理鼠标动作
-            if (receivedItem.type == PACKET_TYPE_MOUSE_DATA) {
-                // 处理鼠标移动和滚轮
-                if (receivedItem.deltaX != 0 || receivedItem.deltaY != 0 || receivedItem.wheel != 0) {
-                    Mouse.move(receivedItem.deltaX, receivedItem.deltaY, receivedItem.wheel);
+
+            // 新连接（无论经握手还是首个数据包建立）都要清空上一次连接残留的运动状态
+            if (seenGeneration != link.generation) {
+                seenGeneration = link.generation;
+                receivePath.reset();
+                if (keyboardRelay != NULL) {
+                    keyboardRelay->reset();
                 }
+            }
 
-                // 处理按键
-                if (receivedItem.buttons != lastButtons) {
-                    uint8_t changed_buttons = receivedItem.buttons ^ lastButtons;
-                    if (changed_buttons & 0x01) { (receivedItem.buttons & 0x01) ? Mouse.press(MOUSE_LEFT) : Mouse.release(MOUSE_LEFT); }
-                    if (changed_buttons & 0x02) { (receivedItem.buttons & 0x02) ? Mouse.press(MOUSE_RIGHT) : Mouse.release(MOUSE_RIGHT); }
-                    if (changed_buttons & 0x04) { (receivedItem.buttons & 0x04) ? Mouse.press(MOUSE_MIDDLE) : Mouse.release(MOUSE_MIDDLE); }
-                    if (changed_buttons & 0x08) { (receivedItem.buttons & 0x08) ? Mouse.press(MOUSE_BACKWARD) : Mouse.release(MOUSE_BACKWARD); }
-                    if (changed_buttons & 0x10) { (receivedItem.buttons & 0x10) ? Mouse.press(MOUSE_FORWARD) : Mouse.release(MOUSE_FORWARD); }
-                    lastButtons = receivedItem.buttons;
+            if (receivedItem.type == PACKET_TYPE_KEYBOARD) {
+                if (keyboardRelay != NULL) {
+                    drainKeyboardQueue();
                 }
+            } else {
+                dispatchArrivalUs = receivedItem.arrivalUs;
+                receivePath.dispatch(receivedItem);
             }
         }
+
+        // 连接断开时松开仍按着的键，避免主机端按键卡住
+        if (keyboardRelay != NULL && keyboardRelay->anyPressed() && !connection.snapshot().connected) {
+            keyboardRelay->reset();
+        }
+
+        // 放出抖动缓冲中已到播放时间的样本，并在需要时外推
+        receivePath.poll();
     }
 }
 
@@ -200,7 +458,7 @@ bool initWiFi() {
         return false;
     }
 
-    err = esp_wifi_set_channel(WIFI_CHANNEL, WIFI_SECOND_CHAN_NONE);
+    err = esp_wifi_set_channel(CFG.wifiChannel, WIFI_SECOND_CHAN_NONE);
     if (err != ESP_OK) {
         Serial.printf("错误：设置Wi-Fi频道失败 (%s)\n", esp_err_to_name(err));
         return false;
@@ -215,11 +473,15 @@ bool initWiFi() {
     return true;
 }
 
-// 断开并重置连接状态
-void resetConnection() {
-    Serial.println("\n--- 连接超时，重置状态 ---");
+// 连接断开（心跳超时或测试收尾）：删除对等设备，清除链路密钥
+void ReceiverConnectionEvents::onDisconnected(const uint8_t mac[6], DisconnectReason reason) {
     // 从ESP-NOW中删除旧的对等设备，这是保证重连成功的关键
-    esp_err_t result = esp_now_del_peer(peerMacAddress);
+    esp_err_t result = esp_now_del_peer(mac);
+    if (reason == DISCONNECT_TIMEOUT) {
+        Serial.println("\n--- 连接超时，重置状态 ---");
+    } else {
+        Serial.println("\n--- 连接已断开，重置状态 ---");
+    }
     if (result == ESP_OK) {
         Serial.println("已成功删除旧的对等设备。");
     } else if (result == ESP_ERR_ESPNOW_NOT_FOUND) {
@@ -227,23 +489,1233 @@ void resetConnection() {
     } else {
         Serial.println("错误：删除对等设备失败。");
     }
-    isConnected = false;
-    memset(peerMacAddress, 0, 6); // 清空MAC地址
+    linkEncrypted = false;
+    frameAuth.clear();
+    linkMonitor.clearPeer();
     Serial.println("接收端已回到广播模式，等待新的连接...");
     Serial.println("--------------------------\n");
 }
 
+// 作为“灯塔”，在未连接时坚持广播自己的身份信息。
+// 回放/仿真/测试期间不接收无线数据、USB 主机挂起时没人使用鼠标，广播只计数、不发出。
+void ReceiverConnectionEvents::onBeacon() {
+    if (replayActive || usbSuspended) {
+        return;
+    }
+
+    UniversalPacket discoveryPacket = {}; // Zero-initialize
+    discoveryPacket.type = PACKET_TYPE_DISCOVERY;
+    strcpy(discoveryPacket.deviceName, MY_DEVICE_NAME);
+
+    esp_now_send(broadcastAddress, (uint8_t *)&discoveryPacket, sizeof(discoveryPacket));
+    Serial.println("正在广播身份，等待配对...");
+}
+
+// 拒绝握手：回复后删除临时注册的对等设备（已连接的对端除外）
+static void rejectHello(const uint8_t mac[6], HelloAckPacket& ack, HelloStatus status) {
+    ack.status = status;
+    esp_now_send(mac, (const uint8_t*)&ack, sizeof(ack));
+    Serial.printf("握手被拒绝 (状态 %u)。\n", ack.status);
+    if (!connection.isPeer(mac)) {
+        esp_now_del_peer(mac);
+    }
+}
+
+static HelloAckPacket makeHelloAck() {
+    HelloAckPacket ack = {};
+    ack.type = PACKET_TYPE_HELLO_ACK;
+    ack.handshakeVersion = HANDSHAKE_VERSION;
+    ack.caps = receiverCapabilities(CFG);
+    if (pairingKey.valid) {
+        ack.caps.features |= CAP_ENCRYPTION;
+        if (preferFrameTags) {
+            ack.caps.features |= CAP_AUTH_TAG;
+        }
+    }
+    return ack;
+}
+
+// 处理握手请求：协商链路模式，注册对等设备并回复结果
+void handleHello(const ControlMessage& msg) {
+    const HelloPacket& hello = msg.hello;
+    HelloAckPacket ack = makeHelloAck();
+
+    Serial.print("收到握手请求，发送端 MAC: ");
+    printMac(msg.mac_addr);
+    Serial.println();
+
+    LinkMode mode;
+    if (connection.connected() && !connection.isPeer(msg.mac_addr)) {
+        ack.status = HELLO_STATUS_BUSY;
+    } else if (hello.handshakeVersion != HANDSHAKE_VERSION || !negotiateLinkMode(ack.caps, hello.caps, mode)) {
+        ack.status = HELLO_STATUS_UNSUPPORTED;
+    } else {
+        ack.status = HELLO_STATUS_OK;
+        ack.mode = mode;
+    }
+
+    // 回复需要先把发送端注册为对等设备；被拒绝的发送端回复后再删除
+    registerPeer(msg.mac_addr);
+    if (ack.status != HELLO_STATUS_OK) {
+        rejectHello(msg.mac_addr, ack, (HelloStatus)ack.status);
+        return;
+    }
+
+    // 设置了配对密钥：先发挑战，认证通过后才建立连接
+    if (pairingKey.valid) {
+        if (!(mode.features & CAP_ENCRYPTION)) {
+            rejectHello(msg.mac_addr, ack, HELLO_STATUS_AUTH_REQUIRED);
+            return;
+        }
+        // 已连接的对端重新配对：挑战以明文发出，认证完成前不再接受它的数据
+        if (connection.isPeer(msg.mac_addr)) {
+            connection.pause();
+            linkEncrypted = false;
+            frameAuth.clear();
+        }
+        AuthChallengePacket challenge;
+        challenge.type = PACKET_TYPE_AUTH_CHALLENGE;
+        esp_fill_random(challenge.nonce, sizeof(challenge.nonce));
+        pendingAuth.active = true;
+        memcpy(pendingAuth.mac, msg.mac_addr, 6);
+        memcpy(pendingAuth.nonce, challenge.nonce, sizeof(challenge.nonce));
+        pendingAuth.mode = mode;
+        pendingAuth.issuedAt = systemClock.nowMs();
+        esp_now_send(msg.mac_addr, (const uint8_t*)&challenge, sizeof(challenge));
+        Serial.println("已发送认证挑战，等待应答...");
+        return;
+    }
+
+    esp_now_send(msg.mac_addr, (const uint8_t*)&ack, sizeof(ack));
+    linkEncrypted = false;
+    frameAuth.clear();
+    connection.connect(msg.mac_addr, mode);
+    Serial.println("握手完成，连接建立！");
+    printLinkMode(connection.mode());
+}
+
+// 校验认证应答：通过后以派生出的 LMK 加密注册对端，并经加密链路回复握手结果
+void handleAuthResponse(const ControlMessage& msg) {
+    const bool matches = pendingAuth.active && memcmp(msg.mac_addr, pendingAuth.mac, 6) == 0;
+    if (!matches) {
+        return; // 没有对应的挑战，忽略
+    }
+    pendingAuth.active = false;
+    HelloAckPacket ack = makeHelloAck();
+    if (systemClock.nowMs() - pendingAuth.issuedAt > AUTH_TIMEOUT_MS) {
+        rejectHello(msg.mac_addr, ack, HELLO_STATUS_AUTH_FAILED);
+        return;
+    }
+
+    uint8_t receiverMac[6];
+    esp_wifi_get_mac(WIFI_IF_STA, receiverMac);
+    uint8_t expected[AUTH_TAG_SIZE];
+    computeAuthTag(pairingKey, msg.mac_addr, receiverMac, pendingAuth.nonce, msg.auth.nonce, expected);
+    if (!authTagEqual(expected, msg.auth.tag)) {
+        Serial.println("错误：认证码校验失败。");
+        rejectHello(msg.mac_addr, ack, HELLO_STATUS_AUTH_FAILED);
+        return;
+    }
+
+    ack.status = HELLO_STATUS_OK;
+    ack.mode = pendingAuth.mode;
+    if (pendingAuth.mode.features & CAP_AUTH_TAG) {
+        // 快速模式：对端以明文注册，HelloAck 附带标签供发送端确认接收端身份
+        uint8_t frameKey[FRAME_KEY_SIZE];
+        deriveFrameKey(pairingKey, msg.mac_addr, receiverMac, pendingAuth.nonce, msg.auth.nonce, frameKey);
+        uint8_t reply[sizeof(ack) + FRAME_TAG_SIZE];
+        memcpy(reply, &ack, sizeof(ack));
+        frameAuthSign(frameKey, FRAME_SEQ_HELLO_ACK, reply, sizeof(ack), reply + sizeof(ack));
+        frameAuth.install(msg.mac_addr, frameKey);
+        esp_now_send(msg.mac_addr, reply, sizeof(reply));
+        linkEncrypted = false;
+    } else {
+        deriveLinkKey(pairingKey, msg.mac_addr, receiverMac, pendingAuth.nonce, msg.auth.nonce, linkKey);
+        registerPeer(msg.mac_addr, linkKey);
+        esp_now_send(msg.mac_addr, (const uint8_t*)&ack, sizeof(ack));
+        frameAuth.clear();
+        linkEncrypted = true;
+    }
+    connection.connect(msg.mac_addr, pendingAuth.mode);
+    Serial.println(linkEncrypted ? "认证通过，加密连接建立！" : "认证通过，带认证标签的明文连接建立！");
+    printLinkMode(connection.mode());
+}
+
+// 旧发送端的首个数据包：建立连接并登记对等设备（以便单播）。设置了配对密钥时只能经认证配对；
+// 消息在途中时可能已经建立了连接（握手或更早的消息），这时不再处理
+static void handlePeerSeen(const ControlMessage& msg) {
+    if (authRequired || !connection.packetSeen(msg.mac_addr)) {
+        return;
+    }
+    Serial.print("收到首个鼠标数据包，连接建立！发送端 MAC: ");
+    printMac(msg.mac_addr);
+    Serial.println();
+    registerPeer(msg.mac_addr);
+}
+
+void processControlMessages() {
+    ControlMessage msg;
+    while (xQueueReceive(controlQueue, &msg, 0) == pdTRUE) {
+        if (msg.type == PACKET_TYPE_AUTH_RESPONSE) {
+            handleAuthResponse(msg);
+        } else if (msg.type == CONTROL_PEER_SEEN) {
+            handlePeerSeen(msg);
+        } else if (msg.type == CONTROL_RECONNECT) {
+            if (replayActive) {
+                connection.connect(msg.mac_addr, legacyLinkMode());
+            }
+        } else {
+            handleHello(msg);
+        }
+    }
+}
+
+// 周期性地向握手时声明支持反馈的发送端单播链路质量
+void sendLinkFeedback() {
+    static uint32_t lastSendTime = 0;
+    static uint16_t feedbackSeq = 0;
+    static uint32_t lastDrops = 0, lastHidReports = 0, lastHidBusyUs = 0;
+    static uint16_t suggestedIntervalUs = 0;
+    static uint32_t lastGeneration = 0;
+    static bool lastSuspended = false;
+
+    // 主机挂起/恢复时不等周期，立即通知发送端
+    const bool suspended = usbSuspended;
+    const uint32_t now = systemClock.nowMs();
+    if (!connection.connected() || !(connection.mode().features & CAP_FEEDBACK) ||
+        (now - lastSendTime < CFG.feedbackIntervalMs && suspended == lastSuspended)) {
+        return;
+    }
+    const uint32_t periodMs = now - lastSendTime;
+    lastSendTime = now;
+
+    // 新连接和主机恢复后都从协商出的周期开始
+    if (lastGeneration != connection.generation() || (lastSuspended && !suspended)) {
+        lastGeneration = connection.generation();
+        suggestedIntervalUs = connection.mode().intervalUs;
+    }
+    lastSuspended = suspended;
+
+    FeedbackInputs in = {};
+    in.link = linkMonitor.takeSnapshot();
+    in.queueCapacity = (uint8_t)CFG.queueLength;
+    in.queueDrops = queueDropCount - lastDrops;
+    in.hidReports = pipeline.hidReports() - lastHidReports;
+    in.hidBusyUs = pipeline.hidBusyUs() - lastHidBusyUs;
+    in.periodMs = periodMs;
+    in.currentIntervalUs = suggestedIntervalUs;
+    in.minIntervalUs = connection.mode().intervalUs;
+    in.hostSuspended = suspended;
+    in.suspendedIntervalUs = CFG.suspendedIntervalUs;
+    lastDrops = queueDropCount;
+    lastHidReports = pipeline.hidReports();
+    lastHidBusyUs = pipeline.hidBusyUs();
+
+    LinkFeedbackPacket packet;
+    buildLinkFeedback(in, feedbackSeq++, packet);
+    if (!suspended) {
+        suggestedIntervalUs = packet.suggestedIntervalUs;
+    }
+    esp_now_send(connection.peer(), (const uint8_t*)&packet, sizeof(packet));
+}
+
+// 周期性输出管线统计
+void printStats() {
+    static uint32_t lastReportTime = 0;
+    const uint32_t now = systemClock.nowMs();
+    if (!connection.connected() || now - lastReportTime < CFG.statsReportIntervalMs) {
+        return;
+    }
+    lastReportTime = now;
+
+    pipeline.printStats();
+    Serial.printf("[统计] 队列丢包:%u FEC恢复:%u FEC无法恢复:%u 累计计数重新同步:%u 非法帧:%u\n",
+                  queueDropCount, frameParser.fecRecovered(), frameParser.fecUnrecoverable(),
+                  frameParser.cumulativeResyncs(), frameParser.rejected());
+    Serial.printf("[统计] HID 延后:%u 合并:%u 溢出:%u 积压:%u 主机挂起:%u 唤醒请求:%u\n", hidQueue.deferredReports(),
+                  hidQueue.mergedReports(), hidQueue.overruns(), (unsigned)hidQueue.pendingReports(), usbSuspendCount,
+                  Mouse.wakeRequests());
+    if (keyboardRelay != NULL) {
+        Serial.printf("[统计] 键盘报告:%u 按键变化:%u 过期键盘帧:%u\n", keyboardRelay->reports(),
+                      keyboardRelay->keyChanges(), keyboardRelay->staleFrames());
+    }
+    if (frameAuth.active()) {
+        Serial.printf("[统计] 帧认证失败:%u 重放:%u\n", frameAuth.forged(), frameAuth.replayed());
+    }
+    if constexpr (CFG.features.jitterBuffer) {
+        const JitterBuffer& jitterBuffer = receivePath.jitterBuffer();
+        if (jitterBuffer.enabled()) {
+            const ClockSync& clock = jitterBuffer.clock();
+            Serial.printf("[统计] 播放延迟:%uus 抖动:%uus 迟到:%u 缓冲溢出:%u 时钟偏移:%dus 漂移:%dppm\n",
+                          jitterBuffer.playoutDelayUs(), jitterBuffer.jitterUs(), jitterBuffer.lateCount(),
+                          jitterBuffer.overflowCount(), clock.offsetUs(), clock.driftPpm());
+        }
+    }
+}
+
+// --- 串口命令 ---
+// accel [linear <灵敏度> <斜率> | power <灵敏度> <指数> <参考速度> | piecewise <速度:增益>...]
+void cmdAccel(int argc, char* argv[]) {
+    if (argc == 1) {
+        printAccelCurveParams(accelParams);
+        return;
+    }
+
+    AccelCurveParams params = {};
+    if (strcmp(argv[1], "linear") == 0 && argc == 4) {
+        params.type = ACCEL_CURVE_LINEAR;
+        params.sensitivity = atof(argv[2]);
+        params.slope = atof(argv[3]);
+    } else if (strcmp(argv[1], "power") == 0 && argc == 5) {
+        params.type = ACCEL_CURVE_POWER;
+        params.sensitivity = atof(argv[2]);
+        params.exponent = atof(argv[3]);
+        params.refSpeed = atof(argv[4]);
+    } else if (strcmp(argv[1], "piecewise") == 0 && argc >= 3 && argc - 2 <= (int)ACCEL_MAX_POINTS) {
+        params.type = ACCEL_CURVE_PIECEWISE;
+        params.sensitivity = 1.0f;
+        for (int i = 2; i < argc; i++) {
+            if (!accelParsePoint(argv[i], params.points[params.pointCount])) {
+                Serial.printf("错误：控制点 %s 非法（格式 速度:增益，速度 0~255，增益 0~%.1f）\n", argv[i],
+                              ACCEL_MAX_GAIN);
+                return;
+            }
+            params.pointCount++;
+        }
+    } else {
+        Serial.println("错误：参数不正确（输入 help 查看用法）");
+        return;
+    }
+
+    AccelCurve curve;
+    if (!buildAccelCurve(params, curve)) {
+        Serial.println("错误：加速曲线参数非法。");
+        return;
+    }
+    pipeline.setAccelCurve(curve);
+    accelParams = params;
+    printAccelCurveParams(accelParams);
+}
+
+// bench [样本数]
+void cmdBench(int argc, char* argv[]) {
+    uint32_t samples = argc > 1 ? (uint32_t)atol(argv[1]) : 100000;
+    if (samples == 0) {
+        samples = 1;
+    }
+    AccelCurve curve;
+    if (buildAccelCurve(accelParams, curve)) {
+        benchAccel(curve, samples);
+    }
+    // 基准测试总是打开滤波，否则只是在测直通
+    JitterFilterParams params = jitterParams;
+    params.enabled = true;
+    JitterFilterTables tables;
+    if (buildJitterFilterTables(params, tables)) {
+        benchJitterFilter(tables, samples);
+    }
+    benchFrameAuth(samples);
+}
+
+// microbench [迭代次数] [名称过滤]：分阶段微基准，结果为 JSON 行
+void cmdMicrobench(int argc, char* argv[]) {
+    uint32_t iterations = argc > 1 ? (uint32_t)atol(argv[1]) : 20000;
+    if (iterations == 0) {
+        iterations = 1;
+    }
+    if (connection.connected() || replayActive) {
+        Serial.println("错误：微基准会截下 HID 报告，请先断开发送端。");
+        return;
+    }
+    runMicrobenchSuite(Mouse, iterations, argc > 2 ? argv[2] : NULL);
+}
+
+// fuzz [次数] [种子]：对帧解析器做变异测试，使用独立的解析器实例，不影响接收
+void cmdFuzz(int argc, char* argv[]) {
+    const uint32_t iterations = argc > 1 ? (uint32_t)atol(argv[1]) : 100000;
+    const uint32_t seed = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 1;
+    fuzzFrameParser(iterations, seed);
+}
+
+// jitter [on | off | <最小截止Hz> <beta> [速度截止Hz] [采样周期ms]]
+void cmdJitter(int argc, char* argv[]) {
+    JitterFilterParams params = jitterParams;
+    if (argc == 2 && strcmp(argv[1], "on") == 0) {
+        params.enabled = true;
+    } else if (argc == 2 && strcmp(argv[1], "off") == 0) {
+        params.enabled = false;
+    } else if (argc >= 3 && argc <= 5) {
+        params.enabled = true;
+        params.minCutoffHz = atof(argv[1]);
+        params.beta = atof(argv[2]);
+        if (argc >= 4) params.derivCutoffHz = atof(argv[3]);
+        if (argc >= 5) params.samplePeriodMs = atof(argv[4]);
+    } else if (argc != 1) {
+        Serial.println("错误：参数不正确（输入 help 查看用法）");
+        return;
+    }
+
+    if (argc > 1) {
+        JitterFilterTables tables;
+        if (!buildJitterFilterTables(params, tables)) {
+            Serial.println("错误：抖动滤波参数非法。");
+            return;
+        }
+        pipeline.setJitterFilter(tables);
+        jitterParams = params;
+    }
+    printJitterFilterParams(jitterParams);
+}
+
+// dpi [<MAC|*> <X系数> [Y系数] | clear <MAC|*>]
+void cmdDpi(int argc, char* argv[]) {
+    if (argc == 1) {
+        dpiTablePrint(dpiTable);
+        return;
+    }
+
+    const bool clear = strcmp(argv[1], "clear") == 0;
+    const char* target = clear ? (argc == 3 ? argv[2] : NULL) : argv[1];
+    if (target == NULL || (!clear && argc != 3 && argc != 4)) {
+        Serial.println("错误：参数不正确（输入 help 查看用法）");
+        return;
+    }
+
+    uint8_t mac[6];
+    const uint8_t* macPtr = NULL; // NULL 表示默认系数
+    if (strcmp(target, "*") != 0) {
+        if (!parseMacAddress(target, mac)) {
+            Serial.println("错误：MAC地址格式应为 AA:BB:CC:DD:EE:FF");
+            return;
+        }
+        macPtr = mac;
+    }
+
+    int32_t scaleX = DPI_SCALE_ONE, scaleY = DPI_SCALE_ONE;
+    if (!clear && (!dpiScaleFromFloat(atof(argv[2]), scaleX) ||
+                   !dpiScaleFromFloat(atof(argc == 4 ? argv[3] : argv[2]), scaleY))) {
+        Serial.printf("错误：缩放系数必须在 0 ~ %.0f 之间\n", DPI_SCALE_MAX);
+        return;
+    }
+
+    bool ok;
+    DpiScaleTable snapshot;
+    portENTER_CRITICAL(&dpiTableMux);
+    ok = clear ? dpiTableRemove(dpiTable, macPtr) : dpiTableSet(dpiTable, macPtr, scaleX, scaleY);
+    snapshot = dpiTable;
+    portEXIT_CRITICAL(&dpiTableMux);
+    if (!ok) {
+        Serial.println(clear ? "错误：缩放表中没有该发送端。" : "错误：缩放表已满。");
+        return;
+    }
+
+    if (connection.connected()) {
+        applyPeerDpiScale(connection.peer());
+    }
+    dpiTableSave(snapshot);
+    dpiTablePrint(snapshot);
+}
+
+void printPredictorParams(const PredictorParams& params) {
+    Serial.printf("丢包外推: %s 最多%u帧 衰减=%.2f 宽限=%u%%\n", params.enabled ? "开" : "关",
+                  params.maxPredictions, (float)params.dampingQ8 / (1 << PREDICTOR_DAMPING_SHIFT), params.gracePercent);
+}
+
+// predict [on | off | <最多帧数> <衰减系数> [宽限%]]
+void cmdPredict(int argc, char* argv[]) {
+    PredictorParams params = predictorParams;
+    if (argc == 2 && strcmp(argv[1], "on") == 0) {
+        params.enabled = true;
+    } else if (argc == 2 && strcmp(argv[1], "off") == 0) {
+        params.enabled = false;
+    } else if (argc == 3 || argc == 4) {
+        const int maxPredictions = atoi(argv[1]);
+        const float damping = atof(argv[2]);
+        const int grace = argc == 4 ? atoi(argv[3]) : params.gracePercent;
+        if (maxPredictions < 1 || maxPredictions > (int)PREDICTOR_MAX_SLOTS || !(damping > 0.0f && damping <= 1.0f) ||
+            grace < 0 || grace > 255) {
+            Serial.println("错误：外推参数非法。");
+            return;
+        }
+        params.enabled = true;
+        params.maxPredictions = (uint8_t)maxPredictions;
+        params.dampingQ8 = (uint16_t)lroundf(damping * (1 << PREDICTOR_DAMPING_SHIFT));
+        params.gracePercent = (uint8_t)grace;
+    } else if (argc != 1) {
+        Serial.println("错误：参数不正确（输入 help 查看用法）");
+        return;
+    }
+
+    if (argc > 1) {
+        pipeline.setPredictor(params);
+        predictorParams = params;
+    }
+    printPredictorParams(predictorParams);
+}
+
+void printJitterBufferParams(const JitterBufferParams& params) {
+    Serial.printf("抖动缓冲: %s 播放延迟 %u~%uus 抖动倍数=%u\n", params.enabled ? "开" : "关",
+                  params.minDelayUs, params.maxDelayUs, params.jitterMultiplier);
+}
+
+// playout [on | off | <最小延迟us> <最大延迟us> [抖动倍数]]
+void cmdPlayout(int argc, char* argv[]) {
+    JitterBufferParams params = jitterBufferParams;
+    if (argc == 2 && strcmp(argv[1], "on") == 0) {
+        params.enabled = true;
+    } else if (argc == 2 && strcmp(argv[1], "off") == 0) {
+        params.enabled = false;
+    } else if (argc == 3 || argc == 4) {
+        const long minDelay = atol(argv[1]);
+        const long maxDelay = atol(argv[2]);
+        const long multiplier = argc == 4 ? atol(argv[3]) : params.jitterMultiplier;
+        if (minDelay < 0 || maxDelay < minDelay || maxDelay > UINT16_MAX || multiplier < 1 || multiplier > 16) {
+            Serial.println("错误：抖动缓冲参数非法。");
+            return;
+        }
+        params.enabled = true;
+        params.minDelayUs = (uint16_t)minDelay;
+        params.maxDelayUs = (uint16_t)maxDelay;
+        params.jitterMultiplier = (uint8_t)multiplier;
+    } else if (argc != 1) {
+        Serial.println("错误：参数不正确（输入 help 查看用法）");
+        return;
+    }
+
+    if (argc > 1) {
+        if (params.enabled && playoutTimer == NULL) {
+            Serial.println("错误：播放定时器不可用，无法开启抖动缓冲。");
+            return;
+        }
+        receivePath.setJitterBufferParams(params);
+        jitterBufferParams = params;
+    }
+    printJitterBufferParams(jitterBufferParams);
+}
+
+// 配对密钥变化后更新 PMK；已建立的连接不受影响，下次配对生效
+static void applyPairingKey() {
+    authRequired = pairingKey.valid;
+    if (pairingKey.valid) {
+        uint8_t pmk[LINK_KEY_SIZE];
+        derivePrimaryMasterKey(pairingKey, pmk);
+        if (esp_now_set_pmk(pmk) != ESP_OK) {
+            Serial.println("警告：设置PMK失败。");
+        }
+    }
+}
+
+// pairkey [<64位十六进制> | clear | mode <encrypt|tag>]
+void cmdPairKey(int argc, char* argv[]) {
+    if (argc == 3 && strcmp(argv[1], "mode") == 0) {
+        if (strcmp(argv[2], "encrypt") == 0) {
+            preferFrameTags = false;
+        } else if (strcmp(argv[2], "tag") == 0) {
+            preferFrameTags = true;
+        } else {
+            Serial.println("错误：模式应为 encrypt 或 tag。");
+            return;
+        }
+    } else if (argc == 2 && strcmp(argv[1], "clear") == 0) {
+        if (!pairingKeyErase()) {
+            Serial.println("错误：清除配对密钥失败。");
+            return;
+        }
+        pairingKey = {};
+        applyPairingKey();
+    } else if (argc == 2) {
+        PairingKey key;
+        if (!pairingKeyFromHex(argv[1], key)) {
+            Serial.println("错误：配对密钥应为 64 个十六进制字符。");
+            return;
+        }
+        if (!pairingKeySave(key)) {
+            return;
+        }
+        pairingKey = key;
+        applyPairingKey();
+    } else if (argc != 1) {
+        Serial.println("错误：参数不正确（输入 help 查看用法）");
+        return;
+    }
+    Serial.printf("认证配对: %s，首选: %s，当前连接: %s\n", pairingKey.valid ? "已启用" : "未启用",
+                  preferFrameTags ? "认证标签" : "硬件加密",
+                  !connection.connected() ? "未连接" : (linkEncrypted ? "加密" : (frameAuth.active() ? "认证标签" : "明文")));
+}
+
+// linkbench [帧数] [字节数]
+void cmdLinkBench(int argc, char* argv[]) {
+    if (!connection.connected()) {
+        Serial.println("错误：需要先与发送端建立连接。");
+        return;
+    }
+    const uint32_t frames = argc > 1 ? (uint32_t)atol(argv[1]) : 200;
+    const size_t bytes = argc > 2 ? (size_t)atol(argv[2]) : sizeof(MotionPacket);
+    benchLinkCrypto(connection.peer(), linkEncrypted ? linkKey : NULL, frames, bytes);
+}
+
+// 回放/仿真/负载测试接管解析路径：此后接收回调不再解析无线帧；等正在执行的回调退出后，
+// 测试成为通道唯一的生产者
+static void takeOverIngest() {
+    replayActive = true;
+    while (radioIngestBusy) {
+        vTaskDelay(1);
+    }
+}
+
+// --- 回放 ---
+// 把捕获的帧按原始间隔（realtime）或尽可能快（max）送回解析路径，经 mouseTask 与管线生成
+// HID 报告。报告被旁路截下，不发往 USB；输出报告数、摘要（FNV-1a，便于比较两个固件版本）
+// 和吞吐。print 模式下逐条输出报告，串口输出会拖慢回放，此时的吞吐数字没有参考价值。
+// 导出的捕获也可以在主机上回放（test/replay）。
+static struct {
+    CaptureReader reader;
+    bool realtime;
+    bool print;
+    uint32_t frames;
+    uint32_t startUs;
+    uint32_t elapsedUs;
+    ReplayDigest digest;
+} replayState;
+static volatile bool replayDone = false;
+
+static bool replayHidTap(uint8_t reportId, const void* report, size_t len) {
+    const uint8_t* bytes = (const uint8_t*)report;
+    replayState.digest.add(reportId, report, len);
+    if (replayState.print) {
+        // 每行：H <相对时间us> <报告ID> <报告十六进制>
+        Serial.printf("H %u %u ", (unsigned)(micros() - replayState.startUs), reportId);
+        for (size_t i = 0; i < len; i++) {
+            Serial.printf("%02X", bytes[i]);
+        }
+        Serial.println();
+    }
+    return true;
+}
+
+static void replayTask(void* arg) {
+    CaptureRecordHeader header;
+    uint8_t data[CAPTURE_MAX_FRAME];
+    bool first = true;
+    uint32_t firstArrival = 0;
+    while (replayState.reader.next(header, data)) {
+        if (replayState.realtime) {
+            if (first) {
+                firstArrival = header.arrivalUs;
+                first = false;
+            }
+            const uint32_t due = replayState.startUs + (header.arrivalUs - firstArrival);
+            while ((int32_t)(due - micros()) > 1000) {
+                vTaskDelay(1);
+            }
+            while ((int32_t)(due - micros()) > 0) {
+            }
+        }
+        // 全速回放时等待通道腾出空间（一帧最多展开为 PACKED_MAX_SAMPLES 项），而不是丢弃
+        while (mouseDataQueue.capacity() - mouseDataQueue.size() <= PACKED_MAX_SAMPLES) {
+            vTaskDelay(1);
+        }
+        parseDataFrame(header.mac, data, header.len, micros());
+        replayState.frames++;
+    }
+    while (!mouseDataQueue.empty()) {
+        vTaskDelay(1);
+    }
+    replayState.elapsedUs = micros() - replayState.startUs;
+    replayDone = true;
+    vTaskDelete(NULL);
+}
+
+// 在控制任务中收尾：输出结果并恢复正常接收
+static void serviceReplay() {
+    if (!replayDone) {
+        return;
+    }
+    replayDone = false;
+    hidReportTap = NULL;
+    const float seconds = replayState.elapsedUs / 1e6f;
+    Serial.printf("[回放] %u 帧 用时 %.3fs (%.0f 帧/s) HID报告 %u 摘要 %08X\n", replayState.frames, seconds,
+                  seconds > 0 ? replayState.frames / seconds : 0.0f, replayState.digest.reports(), replayState.digest.value());
+    if (connection.connected()) {
+        connection.disconnect();
+    }
+    replayActive = false;
+}
+
+// capture [ram | flash [KB] | stop | dump [ram | flash]]
+void cmdCapture(int argc, char* argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "ram") == 0) {
+        if (!captureStart(CAPTURE_RAM, 0)) {
+            Serial.println("错误：捕获已在进行中。");
+            return;
+        }
+    } else if (argc >= 2 && strcmp(argv[1], "flash") == 0) {
+        const uint32_t kb = argc > 2 ? (uint32_t)atol(argv[2]) : 512;
+        if (!captureStart(CAPTURE_FLASH, kb * 1024)) {
+            Serial.println("错误：无法开始闪存捕获。");
+            return;
+        }
+    } else if (argc == 2 && strcmp(argv[1], "stop") == 0) {
+        captureStop();
+    } else if (argc >= 2 && strcmp(argv[1], "dump") == 0) {
+        captureDump(argc > 2 && strcmp(argv[2], "flash") == 0 ? CAPTURE_FLASH : CAPTURE_RAM);
+        return;
+    } else if (argc != 1) {
+        Serial.println("错误：参数不正确（输入 help 查看用法）");
+        return;
+    }
+    capturePrintStatus();
+}
+
+// replay [ram | flash] [realtime | max] [print]
+void cmdReplay(int argc, char* argv[]) {
+    CaptureMode source = CAPTURE_RAM;
+    replayState.realtime = true;
+    replayState.print = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "ram") == 0) source = CAPTURE_RAM;
+        else if (strcmp(argv[i], "flash") == 0) source = CAPTURE_FLASH;
+        else if (strcmp(argv[i], "realtime") == 0) replayState.realtime = true;
+        else if (strcmp(argv[i], "max") == 0) replayState.realtime = false;
+        else if (strcmp(argv[i], "print") == 0) replayState.print = true;
+        else {
+            Serial.println("错误：参数不正确（输入 help 查看用法）");
+            return;
+        }
+    }
+    if (replayActive || connection.connected()) {
+        Serial.println("错误：回放需要先断开发送端，且不能同时进行两次回放。");
+        return;
+    }
+
+    // 先读出第一帧的来源，以它作为回放期间的对端
+    CaptureReader probe;
+    CaptureRecordHeader header;
+    uint8_t data[CAPTURE_MAX_FRAME];
+    if (!probe.open(source) || !probe.next(header, data) || !replayState.reader.open(source)) {
+        Serial.println("错误：没有可回放的捕获（捕获进行中或为空）。");
+        return;
+    }
+
+    takeOverIngest();
+    frameParser.reset();
+    connection.connect(header.mac, legacyLinkMode());
+    replayState.frames = 0;
+    replayState.digest.reset();
+    replayState.startUs = micros();
+    hidReportTap = replayHidTap;
+    if (xTaskCreatePinnedToCore(replayTask, "Replay", 4096, NULL, 1, NULL, 0) != pdPASS) {
+        Serial.println("错误：创建回放任务失败。");
+        hidReportTap = NULL;
+        connection.disconnect();
+        replayActive = false;
+    }
+}
+
+// --- 链路仿真 ---
+// 合成发送端的帧经过有损信道模型后送入解析路径，报告同样被旁路截下。先以无损信道跑一遍作为
+// 参照，再以所选场景跑一遍，在每个检查点比较两遍的光标位置。两遍的轨迹相同，信道决策只取决于
+// 种子。仿真按真实时间进行，心跳超时、抖动缓冲和外推都和实际运行时一样工作。主机上按虚拟时间
+// 运行的版本见 sim_runner.h（test/sim），统计项与这里相同。
+static struct {
+    const char* scenario;
+    LinkSimParams params;
+    SimFormat format;
+    uint32_t seed;
+    uint32_t durationUs;
+    TaskHandle_t task;
+    SimTrafficSource traffic;
+    LinkSimChannel channel;
+    SimDeliveryQueue inFlight;
+    LatencyHistogram latency;        // 只在报告旁路（mouseTask）中写入
+    volatile int32_t posX, posY;     // 报告累计出的光标位置
+    volatile uint32_t reports;
+    volatile uint32_t newestSendUs;  // 已送达帧中最新的发送时刻
+    volatile bool delivered;
+    SimPassResult pass[2];           // 0 = 无损参照，1 = 所选场景
+} simState;
+static esp_timer_handle_t simTimer = NULL;
+static volatile bool simDone = false;
+
+// 报告延迟 = 报告时刻 - 最新已送达帧的发送时刻，包含信道延迟、排队、抖动缓冲与外推
+static bool simHidTap(uint8_t reportId, const void* report, size_t len) {
+    if (reportId == HID_REPORT_ID_MOUSE && len == sizeof(HiResMouseReport)) {
+        HiResMouseReport r;
+        memcpy(&r, report, sizeof(r));
+        simState.posX += r.x;
+        simState.posY += r.y;
+        simState.reports++;
+        if (simState.delivered) {
+            simState.latency.add(micros() - simState.newestSendUs);
+        }
+    }
+    return true;
+}
+
+// 系统节拍只有 1ms，帧的发送/送达时刻由 esp_timer 单次定时器唤醒仿真任务
+static void onSimTimer(void* arg) {
+    xTaskNotifyGive(simState.task);
+}
+
+static void runSimPass(const LinkSimParams& params, SimPassResult& result) {
+    frameParser.reset();
+    // 重新建立连接，清空上一遍残留的管线状态。连接状态只由控制任务修改：发出请求，等到新的一代发布
+    const uint32_t generation = connection.snapshot().generation;
+    ControlMessage reconnect;
+    memcpy(reconnect.mac_addr, SIM_PEER_MAC, 6);
+    reconnect.type = CONTROL_RECONNECT;
+    xQueueSend(controlQueue, &reconnect, portMAX_DELAY);
+    while (connection.snapshot().generation == generation) {
+        vTaskDelay(1);
+    }
+    simState.traffic.reset(simState.format, simState.durationUs);
+    simState.channel.reset(params, simState.seed);
+    simState.inFlight.clear();
+    simState.latency.reset();
+    simState.posX = simState.posY = 0;
+    simState.reports = 0;
+    simState.delivered = false;
+    const uint32_t drops = queueDropCount;
+    const uint32_t recovered = frameParser.fecRecovered();
+    const uint32_t unrecoverable = frameParser.fecUnrecoverable();
+    const uint32_t resyncs = frameParser.cumulativeResyncs();
+    const uint32_t disconnects = connection.snapshot().disconnects;
+    result.checkpoints = 0;
+    result.reordered = 0;
+
+    const uint32_t startUs = micros();
+    for (;;) {
+        // 发出到时的帧，经信道决定丢弃、送达时间或重复
+        while (!simState.traffic.done() && (int32_t)(startUs + simState.traffic.nextAtUs() - micros()) <= 0) {
+            SimEvent event;
+            simState.traffic.take(event);
+            if (event.kind == SIM_EVENT_CHECKPOINT) {
+                if (result.checkpoints < SIM_MAX_CHECKPOINTS) {
+                    result.checkX[result.checkpoints] = simState.posX;
+                    result.checkY[result.checkpoints] = simState.posY;
+                    result.checkpoints++;
+                }
+                continue;
+            }
+            const uint32_t sendUs = startUs + event.atUs;
+            uint32_t deliverUs[2];
+            const uint8_t copies = simState.channel.transmit(sendUs, deliverUs);
+            for (uint8_t i = 0; i < copies; i++) {
+                simState.inFlight.push(deliverUs[i], sendUs, event.data, event.len);
+            }
+        }
+
+        // 送达到时的帧
+        while (simState.inFlight.size() > 0 && (int32_t)(simState.inFlight.top().deliverUs - micros()) <= 0) {
+            const SimDelivery& frame = simState.inFlight.top();
+            if (simState.delivered && (int32_t)(frame.sendUs - simState.newestSendUs) < 0) {
+                result.reordered++;
+            } else {
+                simState.newestSendUs = frame.sendUs;
+                simState.delivered = true;
+            }
+            parseDataFrame(SIM_PEER_MAC, frame.data, frame.len, micros());
+            simState.inFlight.pop();
+        }
+
+        if (simState.traffic.done() && simState.inFlight.size() == 0) {
+            break;
+        }
+        uint32_t nextUs = simState.inFlight.size() > 0 ? simState.inFlight.top().deliverUs
+                                                       : startUs + simState.traffic.nextAtUs();
+        if (!simState.traffic.done() && (int32_t)(startUs + simState.traffic.nextAtUs() - nextUs) < 0) {
+            nextUs = startUs + simState.traffic.nextAtUs();
+        }
+        const int32_t remaining = (int32_t)(nextUs - micros());
+        if (remaining > 0) {
+            esp_timer_stop(simTimer);
+            esp_timer_start_once(simTimer, remaining);
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+    }
+
+    while (!mouseDataQueue.empty()) {
+        vTaskDelay(1);
+    }
+    vTaskDelay(pdMS_TO_TICKS(SIM_SETTLE_MS));
+
+    result.sent = simState.channel.sent();
+    result.lost = simState.channel.lost();
+    result.longestBurst = simState.channel.longestBurst();
+    result.duplicated = simState.channel.duplicated();
+    result.overflows = simState.inFlight.overflows();
+    result.queueDrops = queueDropCount - drops;
+    result.fecRecovered = frameParser.fecRecovered() - recovered;
+    result.fecUnrecoverable = frameParser.fecUnrecoverable() - unrecoverable;
+    result.resyncs = frameParser.cumulativeResyncs() - resyncs;
+    result.disconnects = connection.snapshot().disconnects - disconnects;
+    result.reports = simState.reports;
+    result.latencyP50 = simState.latency.percentileUs(50);
+    result.latencyP99 = simState.latency.percentileUs(99);
+    result.latencyMax = simState.latency.maxUs();
+    result.finalX = simState.posX;
+    result.finalY = simState.posY;
+}
+
+static void simTask(void* arg) {
+    simState.task = xTaskGetCurrentTaskHandle();
+    runSimPass(kLinkSimScenarios[0].params, simState.pass[0]);
+    runSimPass(simState.params, simState.pass[1]);
+    simDone = true;
+    vTaskDelete(NULL);
+}
+
+// 在控制任务中收尾：输出对比结果并恢复正常接收
+static void serviceSim() {
+    if (!simDone) {
+        return;
+    }
+    simDone = false;
+    hidReportTap = NULL;
+    simPrintComparison(simState.scenario, simState.format, simState.seed, simState.traffic.truthX(),
+                       simState.traffic.truthY(), simState.pass[0], simState.pass[1]);
+    if (connection.connected()) {
+        connection.disconnect();
+    }
+    replayActive = false;
+}
+
+// sim [list | <场景> [秒数] [种子] [motion | fec | cumulative | packed] [键=值]...]
+void cmdSim(int argc, char* argv[]) {
+    if (argc < 2 || strcmp(argv[1], "list") == 0) {
+        for (size_t i = 0; i < kLinkSimScenarioCount; i++) {
+            Serial.printf("  %-10s %s\n", kLinkSimScenarios[i].name, kLinkSimScenarios[i].description);
+        }
+        Serial.println("  可用 键=值 覆盖参数：pgb pbg lossg lossb dup reorder（概率）latency jitter delay（us）");
+        return;
+    }
+    const LinkSimScenario* scenario = linkSimFindScenario(argv[1]);
+    if (scenario == NULL) {
+        Serial.println("错误：未知场景（输入 sim list 查看）。");
+        return;
+    }
+    LinkSimParams params = scenario->params;
+    SimFormat format = SIM_FORMAT_MOTION;
+    uint32_t seconds = 5;
+    uint32_t seed = 1;
+    int numbers = 0;
+    for (int i = 2; i < argc; i++) {
+        if (strchr(argv[i], '=') != NULL) {
+            if (!linkSimParseOverride(params, argv[i])) {
+                Serial.printf("错误：无法解析参数 %s\n", argv[i]);
+                return;
+            }
+        } else if (simFormatFromName(argv[i], format)) {
+            continue;
+        } else if (numbers == 0) {
+            seconds = (uint32_t)atol(argv[i]);
+            numbers++;
+        } else if (numbers == 1) {
+            seed = (uint32_t)strtoul(argv[i], NULL, 0);
+            numbers++;
+        } else {
+            Serial.println("错误：参数不正确（输入 help 查看用法）");
+            return;
+        }
+    }
+    if (seconds == 0 || seconds > SIM_MAX_SECONDS) {
+        Serial.printf("错误：时长应为 1~%u 秒。\n", SIM_MAX_SECONDS);
+        return;
+    }
+    if (replayActive || connection.connected()) {
+        Serial.println("错误：仿真需要先断开发送端，且不能与回放同时进行。");
+        return;
+    }
+    if (simTimer == NULL) {
+        const esp_timer_create_args_t timerArgs = {
+            .callback = onSimTimer,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "linksim",
+            .skip_unhandled_events = true,
+        };
+        if (esp_timer_create(&timerArgs, &simTimer) != ESP_OK) {
+            Serial.println("错误：创建仿真定时器失败。");
+            return;
+        }
+    }
+
+    simState.scenario = scenario->name;
+    simState.params = params;
+    simState.format = format;
+    simState.seed = seed;
+    simState.durationUs = seconds * 1000000;
+    linkSimPrintParams(params);
+    Serial.printf("[仿真] 开始：格式 %s 种子 %u，参照与场景各约 %u 秒。\n", simFormatName(format), seed, seconds);
+
+    takeOverIngest();
+    connection.connect(SIM_PEER_MAC, legacyLinkMode());
+    hidReportTap = simHidTap;
+    if (xTaskCreatePinnedToCore(simTask, "LinkSim", 4096, NULL, 1, NULL, 0) != pdPASS) {
+        Serial.println("错误：创建仿真任务失败。");
+        hidReportTap = NULL;
+        connection.disconnect();
+        replayActive = false;
+    }
+}
+
+// --- 负载测试 ---
+// 由高频定时器在 esp_timer 任务中（与 Wi-Fi 接收回调同在核心 0、同为高优先级）向解析路径注入
+// 合成运动帧，不经过无线。速率按档位递增，每档输出实际注入速率、队列丢包率、最大队列深度和
+// 端到端延迟（注入到 HID 报告组装），据此确定队列深度与任务优先级。默认截下报告；指定 usb 时
+// 报告照常发往主机（光标原地来回抖动），测得的上限包含 USB 轮询的反压。
+constexpr uint8_t LOAD_PEER_MAC[6] = {0x02, 'C', 'Y', 'L', 'O', 'D'};
+constexpr uint32_t LOAD_MAX_TICK_HZ = 10000;  // 定时器最高频率，更高的速率每次触发注入多帧
+constexpr float LOAD_RATE_STEP = 1.25f;       // 相邻档位的速率倍数
+constexpr float LOAD_SATURATED_DROP = 0.01f;  // 丢包率超过该值视为饱和
+constexpr uint8_t LOAD_STOP_AFTER = 2;        // 连续饱和的档位数达到该值时提前结束
+constexpr uint32_t LOAD_DRAIN_MS = 100;       // 每档结束后等待队列排空的时间
+
+static struct {
+    uint32_t startHz;
+    uint32_t maxHz;
+    uint32_t stepMs;
+    bool usb;
+    uint8_t burst;                    // 每次定时器触发注入的帧数
+    uint16_t intervalUs;              // 帧中声明的发送周期
+    uint16_t seq;
+    volatile uint32_t injected;
+    volatile uint32_t maxDepth;
+    volatile uint32_t reports;
+    LatencyHistogram latency;         // 只在报告旁路（mouseTask）中写入
+} loadState;
+static esp_timer_handle_t loadTimer = NULL;
+static volatile bool loadDone = false;
+
+static bool loadHidTap(uint8_t reportId, const void* report, size_t len) {
+    if (reportId == HID_REPORT_ID_MOUSE) {
+        loadState.latency.add(micros() - dispatchArrivalUs);
+        loadState.reports++;
+    }
+    return !loadState.usb;
+}
+
+// 在 esp_timer 任务中运行，与接收回调处于同样的上下文
+static void onLoadTimer(void* arg) {
+    for (uint8_t i = 0; i < loadState.burst; i++) {
+        const uint16_t seq = loadState.seq++;
+        const int16_t delta = (seq & 1) ? 3 : -3; // 来回移动，光标位置不累积
+        const MotionPacket packet = {PACKET_TYPE_MOTION, seq, loadState.intervalUs, delta, delta, 0, 0};
+        parseDataFrame(LOAD_PEER_MAC, (const uint8_t*)&packet, sizeof(packet), micros());
+    }
+    loadState.injected += loadState.burst;
+    const uint32_t depth = mouseDataQueue.size();
+    if (depth > loadState.maxDepth) {
+        loadState.maxDepth = depth;
+    }
+}
+
+static void loadTask(void* arg) {
+    uint32_t lastClean = 0, firstSaturated = 0;
+    uint8_t saturatedSteps = 0;
+    for (float rate = loadState.startHz; rate <= loadState.maxHz * 1.001f; rate *= LOAD_RATE_STEP) {
+        const uint32_t hz = (uint32_t)rate;
+        loadState.burst = (uint8_t)((hz + LOAD_MAX_TICK_HZ - 1) / LOAD_MAX_TICK_HZ);
+        loadState.intervalUs = (uint16_t)(1000000 / hz < UINT16_MAX ? 1000000 / hz : UINT16_MAX);
+        loadState.injected = 0;
+        loadState.maxDepth = 0;
+        loadState.reports = 0;
+        loadState.latency.reset();
+        const uint32_t drops = queueDropCount;
+
+        const uint32_t startUs = micros();
+        esp_timer_start_periodic(loadTimer, (uint64_t)1000000 * loadState.burst / hz);
+        vTaskDelay(pdMS_TO_TICKS(loadState.stepMs));
+        esp_timer_stop(loadTimer);
+        const uint32_t elapsedUs = micros() - startUs;
+        vTaskDelay(pdMS_TO_TICKS(LOAD_DRAIN_MS));
+
+        const uint32_t injected = loadState.injected;
+        const uint32_t dropped = queueDropCount - drops;
+        const float dropRate = injected ? (float)dropped / injected : 0.0f;
+        Serial.printf("[负载] 目标 %uHz 实际 %.0fHz 注入 %u 队列丢包 %u (%.2f%%) 最大队列深度 %u/%u HID报告 %u "
+                      "延迟 p50=%uus p99=%uus 最大=%uus\n",
+                      hz, elapsedUs ? injected * 1e6f / elapsedUs : 0.0f, injected, dropped, dropRate * 100.0f,
+                      loadState.maxDepth, (unsigned)CFG.queueLength, loadState.reports,
+                      loadState.latency.percentileUs(50), loadState.latency.percentileUs(99),
+                      loadState.latency.maxUs());
+
+        if (dropRate > LOAD_SATURATED_DROP) {
+            if (firstSaturated == 0) {
+                firstSaturated = hz;
+            }
+            if (++saturatedSteps >= LOAD_STOP_AFTER) {
+                break;
+            }
+        } else {
+            saturatedSteps = 0;
+            if (dropped == 0) {
+                lastClean = hz;
+            }
+        }
+    }
+    if (firstSaturated != 0) {
+        Serial.printf("[负载] 饱和点：无丢包的最高档 %uHz，丢包率超过 %.0f%% 的最低档 %uHz\n", lastClean,
+                      LOAD_SATURATED_DROP * 100.0f, firstSaturated);
+    } else {
+        Serial.printf("[负载] 到 %uHz 仍未饱和（无丢包的最高档 %uHz）\n", loadState.maxHz, lastClean);
+    }
+    loadDone = true;
+    vTaskDelete(NULL);
+}
+
+// 在控制任务中收尾，恢复正常接收
+static void serviceLoadTest() {
+    if (!loadDone) {
+        return;
+    }
+    loadDone = false;
+    hidReportTap = NULL;
+    if (connection.connected()) {
+        connection.disconnect();
+    }
+    replayActive = false;
+}
+
+// loadtest [起始Hz] [最高Hz] [每档ms] [usb]
+void cmdLoadTest(int argc, char* argv[]) {
+    loadState.startHz = 500;
+    loadState.maxHz = 20000;
+    loadState.stepMs = 1000;
+    loadState.usb = false;
+    int numbers = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "usb") == 0) {
+            loadState.usb = true;
+        } else if (numbers == 0) {
+            loadState.startHz = (uint32_t)atol(argv[i]);
+            numbers++;
+        } else if (numbers == 1) {
+            loadState.maxHz = (uint32_t)atol(argv[i]);
+            numbers++;
+        } else if (numbers == 2) {
+            loadState.stepMs = (uint32_t)atol(argv[i]);
+            numbers++;
+        } else {
+            Serial.println("错误：参数不正确（输入 help 查看用法）");
+            return;
+        }
+    }
+    if (loadState.startHz == 0 || loadState.maxHz < loadState.startHz ||
+        loadState.maxHz > LOAD_MAX_TICK_HZ * 10 || loadState.stepMs == 0) {
+        Serial.printf("错误：速率应满足 0 < 起始 <= 最高 <= %u，每档时长不能为 0。\n", LOAD_MAX_TICK_HZ * 10);
+        return;
+    }
+    if (replayActive || connection.connected()) {
+        Serial.println("错误：负载测试需要先断开发送端，且不能与回放/仿真同时进行。");
+        return;
+    }
+    if (loadTimer == NULL) {
+        const esp_timer_create_args_t timerArgs = {
+            .callback = onLoadTimer,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "loadgen",
+            .skip_unhandled_events = true,
+        };
+        if (esp_timer_create(&timerArgs, &loadTimer) != ESP_OK) {
+            Serial.println("错误：创建负载定时器失败。");
+            return;
+        }
+    }
+
+    Serial.printf("[负载] 开始：%u ~ %uHz，每档 %ums，报告%s\n", loadState.startHz, loadState.maxHz, loadState.stepMs,
+                  loadState.usb ? "发往 USB" : "被截下");
+    takeOverIngest();
+    connection.connect(LOAD_PEER_MAC, legacyLinkMode());
+    hidReportTap = loadHidTap;
+    loadState.seq = 0;
+    if (xTaskCreatePinnedToCore(loadTask, "LoadTest", 4096, NULL, 1, NULL, 0) != pdPASS) {
+        Serial.println("错误：创建负载测试任务失败。");
+        hidReportTap = NULL;
+        connection.disconnect();
+        replayActive = false;
+    }
+}
+
+static const ConsoleCommand consoleCommands[] = {
+    {"accel", "[linear <灵敏度> <斜率> | power <灵敏度> <指数> <参考速度> | piecewise <速度:增益>...]", cmdAccel},
+    {"bench", "[样本数]", cmdBench},
+    {"capture", "[ram | flash [KB] | stop | dump [ram | flash]]", cmdCapture},
+    {"dpi", "[<MAC|*> <X系数> [Y系数] | clear <MAC|*>]", cmdDpi},
+    {"fuzz", "[次数] [种子]", cmdFuzz},
+    {"jitter", "[on | off | <最小截止Hz> <beta> [速度截止Hz] [采样周期ms]]", cmdJitter},
+    {"linkbench", "[帧数] [字节数]", cmdLinkBench},
+    {"loadtest", "[起始Hz] [最高Hz] [每档ms] [usb]", cmdLoadTest},
+    {"microbench", "[迭代次数] [名称过滤]", cmdMicrobench},
+    {"pairkey", "[<64位十六进制> | clear | mode <encrypt|tag>]", cmdPairKey},
+    {"predict", "[on | off | <最多帧数> <衰减系数> [宽限%]]", cmdPredict},
+    {"playout", "[on | off | <最小延迟us> <最大延迟us> [抖动倍数]]", cmdPlayout},
+    {"replay", "[ram | flash] [realtime | max] [print]", cmdReplay},
+    {"sim", "[list | <场景> [秒数] [种子] [motion | fec | cumulative | packed] [键=值]...]", cmdSim},
+};
+
+// 控制任务的一轮：各项都是非阻塞的轮询
+static void controlService() {
+    const uint32_t peerPacketAt = peerPacketMs.exchange(0, std::memory_order_relaxed);
+    if (peerPacketAt != 0) {
+        connection.heartbeat(peerPacketAt);
+    }
+    connection.service();
+    serviceUsbState();
+    processControlMessages();
+    captureService();
+    serviceReplay();
+    serviceSim();
+    serviceLoadTest();
+
+    if constexpr (CFG.features.feedback) {
+        sendLinkFeedback();
+    }
+
+    if constexpr (CFG.features.stats) {
+        printStats();
+    }
+
+    consolePoll(consoleCommands, sizeof(consoleCommands) / sizeof(consoleCommands[0]));
+}
+
+// 低优先级控制任务（与 HID 输出任务不在同一个核）：连接管理、握手与对等设备增删、测试收尾、
+// 链路反馈、统计输出和串口命令（包括 NVS 读写）都在这里进行，不会推迟 HID 报告
+void controlTask(void *pvParameters) {
+    for (;;) {
+        controlService();
+        // 每 loopIntervalMs 一轮以降低CPU占用；有控制消息（握手、首个数据包）时立即开始下一轮
+        ControlMessage msg;
+        xQueuePeek(controlQueue, &msg, pdMS_TO_TICKS(CFG.loopIntervalMs));
+    }
+}
+
 void setup() {
     Serial.begin(115200);
     Serial.println("CyMouse接收端启动...");
     Serial.printf("Size of UniversalPacket: %u bytes\n", sizeof(UniversalPacket));
 
+    // 复合设备的各个 HID 设备必须在 USB.begin() 之前创建，才能进入报告描述符
+    if constexpr (CFG.features.keyboard) {
+        static NkroKeyboard keyboard(hidQueue);
+        static KeyboardRelay relay(keyboard);
+        keyboardQueue = xQueueCreate(8, sizeof(KeyboardMessage));
+        if (keyboardQueue != NULL) {
+            keyboardRelay = &relay;
+        } else {
+            Serial.println("警告：创建键盘队列失败，键盘不可用。");
+        }
+    }
+
+    USB.onEvent(onUsbEvent);
     USB.begin();
     Mouse.begin();
+    Mouse.setRemoteWakeMotion(CFG.remoteWakeMotion);
     
-    mouseDataQueue = xQueueCreate(20, sizeof(QueueItem_t));
-    if (mouseDataQueue == NULL) {
-        Serial.println("错误：创建鼠标数据队列失败！");
+    controlQueue = xQueueCreate(8, sizeof(ControlMessage));
+    if (controlQueue == NULL) {
+        Serial.println("错误：创建控制消息队列失败！");
         return;
     }
     
@@ -252,6 +1724,36 @@ void setup() {
         return;
     }
 
+    if constexpr (CFG.features.jitterBuffer) {
+        const esp_timer_create_args_t timerArgs = {
+            .callback = onPlayoutTimer,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "playout",
+            .skip_unhandled_events = true,
+        };
+        if (esp_timer_create(&timerArgs, &playoutTimer) != ESP_OK) {
+            Serial.println("警告：创建播放定时器失败，抖动缓冲不可用。");
+            jitterBufferParams.enabled = false;
+        }
+    }
+    receivePath.setJitterBufferParams(jitterBufferParams);
+
+    if constexpr (CFG.features.feedback) {
+        if (!startRssiMonitor(&linkMonitor)) {
+            Serial.println("警告：开启RSSI监测失败，反馈中将不含RSSI。");
+        }
+    }
+
+    if (dpiTableLoad(dpiTable)) {
+        Serial.println("已从NVS加载DPI缩放表。");
+    }
+
+    if (pairingKeyLoad(pairingKey)) {
+        Serial.println("已从NVS加载配对密钥，只接受认证配对。");
+    }
+    applyPairingKey();
+
     esp_err_t cbErr = esp_now_register_recv_cb(OnDataRecv);
     if (cbErr != ESP_OK) {
         Serial.printf("错误：注册接收回调失败 (%s)\n", esp_err_to_name(cbErr));
@@ -261,38 +1763,31 @@ void setup() {
     // 添加广播地址为对等设备，以便我们可以发送广播包
     esp_now_peer_info_t peerInfo = {};
     memcpy(peerInfo.peer_addr, broadcastAddress, 6);
-    peerInfo.channel = WIFI_CHANNEL;
+    peerInfo.channel = CFG.wifiChannel;
     peerInfo.encrypt = false;
     if (esp_now_add_peer(&peerInfo) != ESP_OK) {
         Serial.println("错误：添加广播对等设备失败。");
         return;
     }
 
-    xTaskCreatePinnedToCore(mouseTask, "MouseTask", 4096, NULL, configMAX_PRIORITIES - 1, NULL, 1);
+    if (xTaskCreatePinnedToCore(mouseTask, "MouseTask", CFG.mouseTaskStackSize, NULL,
+                                configMAX_PRIORITIES - 1 - CFG.mouseTaskPriorityBelowMax, &mouseTaskHandle,
+                                CFG.mouseTaskCore) != pdPASS) {
+        Serial.println("错误：创建鼠标处理任务失败！");
+        return;
+    }
+    Serial.println("鼠标处理任务已启动。");
+
+    if (xTaskCreatePinnedToCore(controlTask, "Control", CFG.controlTaskStackSize, NULL, CFG.controlTaskPriority, NULL,
+                                CFG.controlTaskCore) != pdPASS) {
+        Serial.println("错误：创建控制任务失败！");
+        return;
+    }
     
     Serial.println("初始化完成，开始广播身份...");
 }
 
 void loop() {
-    // 职责：作为“灯塔”，在未连接时，坚持广播自己的身份信息。
-    if (!isConnected) {
-        static unsigned long lastBroadcastTime = 0;
-        if (millis() - lastBroadcastTime >= 1000) {
-            lastBroadcastTime = millis();
-            
-            UniversalPacket discoveryPacket = {}; // Zero-initialize
-            discoveryPacket.type = PACKET_TYPE_DISCOVERY;
-            strcpy(discoveryPacket.deviceName, MY_DEVICE_NAME);
-            
-            esp_now_send(broadcastAddress, (uint8_t *)&discoveryPacket, sizeof(discoveryPacket));
-            Serial.println("正在广播身份，等待配对...");
-        }
-    } else {
-        // 如果已连接，则检查心跳是否超时
-        if (millis() - lastPacketTime > CONNECTION_TIMEOUT) {
-            resetConnection();
-        }
-    }
-    
-    delay(100); // 降低主循环CPU占用
+    // 全部工作都在 mouseTask 和 controlTask 中进行
+    vTaskDelete(NULL);
 }
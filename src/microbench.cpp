@@ -0,0 +1,230 @@
+#include <Arduino.h>
+
+#include "config.h"
+#include "frame_auth.h"
+#include "frame_parser.h"
+#include "microbench.h"
+#include "packed_motion.h"
+#include "pipeline.h"
+
+const uint8_t benchMac[6] = {0x02, 'B', 'E', 'N', 'C', 'H'};
+const char* benchFilter = NULL;
+volatile int32_t benchSink = 0;
+
+// 固定种子的 LCG，保证每次运行输入一致；位移覆盖慢速到快速
+void fillBenchInputs(BenchInputs& inputs) {
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < BENCH_INPUTS; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        inputs.dx[i] = (int16_t)((int8_t)(seed >> 24) >> 1);
+        inputs.dy[i] = (int16_t)((int8_t)(seed >> 16) >> 1);
+    }
+}
+
+// 管线的空输出端：只累计位移与按键
+struct BenchSink {
+    bool report(int16_t x, int16_t y, int16_t scroll, int16_t pan, uint8_t buttons, bool) {
+        benchSink += x + y + scroll + pan + buttons;
+        return true;
+    }
+};
+
+// 与接收回调中的 enqueueItem 一样是一次真正的函数调用，两种解析做法的对比才公平
+__attribute__((noinline)) static void benchEmit(const QueueItem_t& item) {
+    benchSink += item.deltaX;
+}
+
+// 旧的旧格式解析路径，作为 parse/universal_cast 的对照：按原先的顺序逐个比较其他格式的长度和类型，
+// 都不匹配后把缓冲直接转换为 UniversalPacket* 读取，不做字段校验
+__attribute__((noinline)) static void legacyCastParse(const uint8_t* data, size_t len) {
+    if ((len == sizeof(KeyboardPacket) && data[0] == PACKET_TYPE_KEYBOARD) ||
+        (len == sizeof(TimedMotionPacket) && data[0] == PACKET_TYPE_MOTION_TIMED) ||
+        (len == sizeof(MotionHiResPacket) && data[0] == PACKET_TYPE_MOTION_HIRES) ||
+        (len == sizeof(ClockSyncPacket) && data[0] == PACKET_TYPE_CLOCK_SYNC) ||
+        (len >= FEC_HEADER_SIZE && data[0] == PACKET_TYPE_MOTION_FEC) ||
+        (data[0] == PACKET_TYPE_MOTION_PACKED && len <= PACKED_MAX_FRAME_SIZE) ||
+        (len == sizeof(CumulativeMotionPacket) && data[0] == PACKET_TYPE_MOTION_CUMULATIVE) ||
+        (len == sizeof(MotionPacket) && data[0] == PACKET_TYPE_MOTION) || len != sizeof(UniversalPacket)) {
+        return;
+    }
+    const UniversalPacket* packet = (const UniversalPacket*)data;
+    if (packet->type == PACKET_TYPE_MOUSE_DATA || packet->type == PACKET_TYPE_HEARTBEAT) {
+        QueueItem_t item = {};
+        memcpy(item.mac_addr, benchMac, 6);
+        item.type = packet->type;
+        item.deltaX = packet->deltaX;
+        item.deltaY = packet->deltaY;
+        item.wheel = packet->wheel;
+        item.buttons = packet->buttons;
+        benchEmit(item);
+    }
+}
+
+// 帧校验与解码：经接收回调使用的同一个表驱动解析器，解码结果送入空的 emit
+static void benchParse(uint32_t iterations, const int16_t* dx, const int16_t* dy) {
+    static MotionPacket motion[BENCH_INPUTS];
+    static UniversalPacket universal[BENCH_INPUTS];
+    static MotionFecPacket fec[BENCH_INPUTS];
+    static CumulativeMotionPacket cumulative[BENCH_INPUTS];
+    static uint8_t packed[BENCH_INPUTS][PACKED_MAX_FRAME_SIZE];
+    static uint8_t packedLen[BENCH_INPUTS];
+    static FrameParser parser;
+    uint32_t totalX = 0, totalY = 0;
+    uint8_t lastButtons = 0;
+    for (size_t i = 0; i < BENCH_INPUTS; i++) {
+        motion[i] = {PACKET_TYPE_MOTION, (uint16_t)i, 1000, dx[i], dy[i], 0, 0};
+        universal[i] = {};
+        universal[i].type = PACKET_TYPE_MOUSE_DATA;
+        universal[i].deltaX = dx[i];
+        universal[i].deltaY = dy[i];
+        fec[i] = {};
+        fec[i].type = PACKET_TYPE_MOTION_FEC;
+        fec[i].intervalUs = 1000;
+        fec[i].deltaX = dx[i];
+        fec[i].deltaY = dy[i];
+        fec[i].redundancy = 2;
+        fec[i].history[0] = {dx[(i - 1) & (BENCH_INPUTS - 1)], dy[(i - 1) & (BENCH_INPUTS - 1)], 0, 0};
+        fec[i].history[1] = {dx[(i - 2) & (BENCH_INPUTS - 1)], dy[(i - 2) & (BENCH_INPUTS - 1)], 0, 0};
+        totalX += (uint32_t)(int32_t)dx[i];
+        totalY += (uint32_t)(int32_t)dy[i];
+        cumulative[i] = {PACKET_TYPE_MOTION_CUMULATIVE, (uint16_t)i, 1000, totalX, totalY, 0, 0};
+        PackedSample batch[4];
+        for (size_t k = 0; k < 4; k++) {
+            const size_t j = (i * 4 + k) & (BENCH_INPUTS - 1);
+            batch[k] = {dx[j], dy[j], 0, 0};
+        }
+        packedLen[i] = (uint8_t)encodePackedMotion(batch, 4, (uint16_t)(i * 4), 1000, lastButtons, false, packed[i],
+                                                   sizeof(packed[i]));
+    }
+
+    runBenchCase("parse/universal_cast", iterations, [&](uint32_t i) {
+        legacyCastParse((const uint8_t*)&universal[i & (BENCH_INPUTS - 1)], sizeof(UniversalPacket));
+    });
+
+    runBenchCase("parse/universal", iterations, [&](uint32_t i) {
+        parser.parse(benchMac, (const uint8_t*)&universal[i & (BENCH_INPUTS - 1)], sizeof(UniversalPacket), 0,
+                     benchEmit);
+    });
+
+    runBenchCase("parse/motion", iterations, [&](uint32_t i) {
+        parser.parse(benchMac, (const uint8_t*)&motion[i & (BENCH_INPUTS - 1)], sizeof(MotionPacket), 0, benchEmit);
+    });
+
+    // 序号逐次递增，避免被当作重复帧；每帧的冗余都不需要用到
+    const size_t fecLen = FEC_HEADER_SIZE + 2 * sizeof(RedundantSample);
+    runBenchCase("parse/fec", iterations, [&](uint32_t i) {
+        MotionFecPacket& packet = fec[i & (BENCH_INPUTS - 1)];
+        packet.seq = (uint16_t)i;
+        parser.parse(benchMac, (const uint8_t*)&packet, fecLen, 0, benchEmit);
+    });
+
+    runBenchCase("parse/cumulative", iterations, [&](uint32_t i) {
+        CumulativeMotionPacket& packet = cumulative[i & (BENCH_INPUTS - 1)];
+        packet.seq = (uint16_t)i;
+        parser.parse(benchMac, (const uint8_t*)&packet, sizeof(packet), 0, benchEmit);
+    });
+
+    runBenchCase("parse/packed4", iterations, [&](uint32_t i) {
+        const size_t k = i & (BENCH_INPUTS - 1);
+        parser.parse(benchMac, packed[k], packedLen[k], 0, benchEmit);
+    });
+}
+
+// 管线：按编译期配置串联的全部变换阶段，以及按键差分
+static void benchPipeline(uint32_t iterations, const int16_t* dx, const int16_t* dy) {
+    static BenchSink sink;
+    static MousePipeline<kReceiverConfig, BenchSink> pipeline(sink, systemClock);
+
+    QueueItem_t item = {};
+    memcpy(item.mac_addr, benchMac, 6);
+    item.type = PACKET_TYPE_MOUSE_DATA;
+    item.flags = QUEUE_ITEM_HAS_SEQ;
+    item.intervalUs = 1000;
+
+    pipeline.resetMotionState();
+    runBenchCase("pipeline/motion", iterations, [&](uint32_t i) {
+        item.seq = (uint16_t)i;
+        item.deltaX = dx[i & (BENCH_INPUTS - 1)];
+        item.deltaY = dy[i & (BENCH_INPUTS - 1)];
+        item.buttons = 0;
+        pipeline.process(item);
+    });
+
+    // 每次交替按下/松开左键，不带位移
+    pipeline.resetMotionState();
+    runBenchCase("pipeline/buttons", iterations, [&](uint32_t i) {
+        item.seq = (uint16_t)i;
+        item.deltaX = item.deltaY = 0;
+        item.buttons = (i & 1) ? 0x01 : 0x00;
+        pipeline.process(item);
+    });
+
+    AccelEngine accel;
+    AccelCurve curve;
+    if (buildAccelCurve(kReceiverConfig.accel, curve)) {
+        accel.setCurve(curve);
+        runBenchCase("transform/accel", iterations, [&](uint32_t i) {
+            int16_t x = dx[i & (BENCH_INPUTS - 1)], y = dy[i & (BENCH_INPUTS - 1)];
+            accel.apply(x, y);
+            benchSink += x + y;
+        });
+    }
+    // 默认曲线不加速，再测一条典型的幂函数曲线（指数 1.5，参考速度 8 计数/毫秒）
+    const AccelCurveParams power = {ACCEL_CURVE_POWER, 1.0f, 0.0f, 1.5f, 8.0f, {}, 0};
+    if (buildAccelCurve(power, curve)) {
+        accel.setCurve(curve);
+        runBenchCase("transform/accel_power", iterations, [&](uint32_t i) {
+            int16_t x = dx[i & (BENCH_INPUTS - 1)], y = dy[i & (BENCH_INPUTS - 1)];
+            accel.apply(x, y);
+            benchSink += x + y;
+        });
+    }
+
+    JitterFilterParams params = kReceiverConfig.jitter;
+    params.enabled = true;
+    JitterFilterTables tables;
+    if (buildJitterFilterTables(params, tables)) {
+        static JitterFilter jitter;
+        jitter.setTables(tables);
+        runBenchCase("transform/jitter", iterations, [&](uint32_t i) {
+            int16_t x = dx[i & (BENCH_INPUTS - 1)], y = dy[i & (BENCH_INPUTS - 1)];
+            jitter.apply(x, y);
+            benchSink += x + y;
+        });
+    }
+}
+
+// 快速模式下接收回调对每帧的标签验证：预先为扩展序号 0~BENCH_INPUTS-1 签好名，每轮用完后
+// 重新安装密钥（清空重放窗口），摊到每帧的开销可以忽略
+static void benchFrameVerify(uint32_t iterations, const int16_t* dx, const int16_t* dy) {
+    static uint8_t frames[BENCH_INPUTS][sizeof(MotionPacket) + FRAME_TAG_SIZE];
+    static FrameAuthenticator auth;
+    uint8_t key[FRAME_KEY_SIZE];
+    for (size_t i = 0; i < sizeof(key); i++) {
+        key[i] = (uint8_t)(i * 17 + 3);
+    }
+    for (size_t i = 0; i < BENCH_INPUTS; i++) {
+        const MotionPacket packet = {PACKET_TYPE_MOTION, (uint16_t)i, 1000, dx[i], dy[i], 0, 0};
+        memcpy(frames[i], &packet, sizeof(packet));
+        frameAuthSign(key, (uint32_t)i, frames[i], sizeof(packet), frames[i] + sizeof(packet));
+    }
+
+    runBenchCase("auth/verify", iterations, [&](uint32_t i) {
+        const size_t k = i & (BENCH_INPUTS - 1);
+        if (k == 0) {
+            auth.install(benchMac, key);
+        }
+        benchSink += auth.verify(benchMac, frames[k], sizeof(frames[k]));
+    });
+}
+
+void runPortableMicrobenches(uint32_t iterations, const char* filter) {
+    static BenchInputs inputs;
+    fillBenchInputs(inputs);
+    benchFilter = filter;
+    runBenchCase("harness/empty", iterations, [](uint32_t i) { benchSink += (int32_t)i; });
+    benchParse(iterations, inputs.dx, inputs.dy);
+    benchFrameVerify(iterations, inputs.dx, inputs.dy);
+    benchPipeline(iterations, inputs.dx, inputs.dy);
+    benchFilter = NULL;
+}
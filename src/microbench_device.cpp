@@ -0,0 +1,81 @@
+#include <Arduino.h>
+
+#include "config.h"
+#include "hid_tap.h"
+#include "hires_mouse.h"
+#include "microbench.h"
+#include "spsc_ring.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+// 依赖 FreeRTOS 与 USB 的用例，只在固件中运行
+
+// 通道交接：接收回调入队并通知 + mouseTask 取通知并出队，同一任务内往返（不含跨核的缓存同步）。
+// queue/freertos 是改用无锁通道之前的 FreeRTOS 队列，作为对照
+static void benchQueue(uint32_t iterations) {
+    static SpscRing<QueueItem_t, kReceiverConfig.queueLength> ring;
+    const TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    runBenchCase("queue/handoff", iterations, [&](uint32_t i) {
+        QueueItem_t item = {};
+        item.deltaX = (int16_t)i;
+        ring.push(item);
+        xTaskNotifyGive(self);
+        ulTaskNotifyTake(pdTRUE, 0);
+        QueueItem_t out;
+        if (ring.pop(out)) {
+            benchSink += out.deltaX;
+        }
+    });
+
+    QueueHandle_t queue = xQueueCreate(kReceiverConfig.queueLength, sizeof(QueueItem_t));
+    if (queue == NULL) {
+        Serial.println("错误：创建基准队列失败。");
+        return;
+    }
+    runBenchCase("queue/freertos", iterations, [&](uint32_t i) {
+        QueueItem_t item = {};
+        item.deltaX = (int16_t)i;
+        xQueueSendFromISR(queue, &item, NULL);
+        QueueItem_t out;
+        if (xQueueReceive(queue, &out, 0) == pdTRUE) {
+            benchSink += out.deltaX;
+        }
+    });
+    vQueueDelete(queue);
+}
+
+static volatile uint32_t benchTapReports = 0;
+
+static bool benchHidTap(uint8_t reportId, const void* report, size_t len) {
+    benchTapReports++;
+    return true;
+}
+
+// HID 报告组装：报告旁路截下报告，只计组装与分发，不含 USB 传输
+static void benchHidReports(HiResMouse& mouse, uint32_t iterations, const int16_t* dx, const int16_t* dy) {
+    const HidReportTap previous = hidReportTap;
+    hidReportTap = benchHidTap;
+    runBenchCase("hid/move", iterations, [&](uint32_t i) {
+        mouse.move(dx[i & (BENCH_INPUTS - 1)], dy[i & (BENCH_INPUTS - 1)], 0, 0);
+    });
+    runBenchCase("hid/move_scroll", iterations, [&](uint32_t i) {
+        mouse.move(dx[i & (BENCH_INPUTS - 1)], dy[i & (BENCH_INPUTS - 1)], 40, 0);
+    });
+    runBenchCase("hid/button", iterations, [&](uint32_t i) {
+        (i & 1) ? mouse.release(HID_BUTTON_LEFT) : mouse.press(HID_BUTTON_LEFT);
+    });
+    mouse.release(HIRES_BUTTON_ALL);
+    hidReportTap = previous;
+}
+
+void runMicrobenchSuite(HiResMouse& mouse, uint32_t iterations, const char* filter) {
+    runPortableMicrobenches(iterations, filter);
+    static BenchInputs inputs;
+    fillBenchInputs(inputs);
+    benchFilter = filter;
+    benchQueue(iterations);
+    benchHidReports(mouse, iterations, inputs.dx, inputs.dy);
+    benchFilter = NULL;
+}
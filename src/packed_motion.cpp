@@ -0,0 +1,52 @@
+#include <Arduino.h>
+
+#include "packed_motion.h"
+
+static uint8_t* writeVarint(uint8_t* p, uint32_t value) {
+    while (value >= 0x80) {
+        *p++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+size_t encodePackedMotion(const PackedSample* samples, uint8_t count, uint16_t seq, uint16_t intervalUs,
+                          uint8_t& lastButtons, bool forceButtons, uint8_t* out, size_t outSize) {
+    if (count == 0 || count > PACKED_MAX_SAMPLES || outSize < PACKED_MAX_FRAME_SIZE) {
+        return 0;
+    }
+    out[0] = PACKET_TYPE_MOTION_PACKED;
+    out[1] = (uint8_t)seq;
+    out[2] = (uint8_t)(seq >> 8);
+    out[3] = count;
+    uint8_t* p = writeVarint(out + PACKED_HEADER_SIZE, intervalUs);
+    uint8_t* masks = p;
+    memset(masks, 0, (count + 1) / 2);
+    p += (count + 1) / 2;
+
+    for (uint8_t i = 0; i < count; i++) {
+        const PackedSample& s = samples[i];
+        uint8_t mask = 0;
+        if (s.deltaX != 0) {
+            mask |= PACKED_FIELD_DX;
+            p = writeVarint(p, zigzagEncode(s.deltaX));
+        }
+        if (s.deltaY != 0) {
+            mask |= PACKED_FIELD_DY;
+            p = writeVarint(p, zigzagEncode(s.deltaY));
+        }
+        if (s.wheel != 0) {
+            mask |= PACKED_FIELD_WHEEL;
+            p = writeVarint(p, zigzagEncode(s.wheel));
+        }
+        if (forceButtons || s.buttons != lastButtons) {
+            mask |= PACKED_FIELD_BUTTONS;
+            *p++ = s.buttons;
+            lastButtons = s.buttons;
+            forceButtons = false;
+        }
+        masks[i >> 1] |= (uint8_t)(mask << ((i & 1) * 4));
+    }
+    return (size_t)(p - out);
+}
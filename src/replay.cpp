@@ -0,0 +1,63 @@
+#include <Arduino.h>
+#include <stdlib.h>
+
+#include "replay.h"
+
+static int hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+bool replayParseRecord(const char* line, CaptureRecordHeader& header, uint8_t data[CAPTURE_MAX_FRAME]) {
+    if (line[0] != 'C' || line[1] != ' ') {
+        return false;
+    }
+    char* end;
+    const unsigned long long arrivalUs = strtoull(line + 2, &end, 10);
+    if (end == line + 2 || *end != ' ' || arrivalUs > UINT32_MAX) {
+        return false;
+    }
+    const char* p = end + 1;
+    for (int i = 0; i < 6; i++, p += 2) {
+        const int hi = hexNibble(p[0]);
+        const int lo = hi < 0 ? -1 : hexNibble(p[1]);
+        if (lo < 0) {
+            return false;
+        }
+        header.mac[i] = (uint8_t)(hi << 4 | lo);
+    }
+    if (*p++ != ' ') {
+        return false;
+    }
+    size_t len = 0;
+    for (; hexNibble(*p) >= 0; p += 2) {
+        const int lo = hexNibble(p[1]);
+        if (lo < 0 || len == CAPTURE_MAX_FRAME) {
+            return false;
+        }
+        data[len++] = (uint8_t)(hexNibble(p[0]) << 4 | lo);
+    }
+    // 行尾只允许空白（串口日志带 \r\n）
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+        p++;
+    }
+    if (*p != '\0' || len == 0) {
+        return false;
+    }
+    header.arrivalUs = (uint32_t)arrivalUs;
+    header.len = (uint8_t)len;
+    header.flags = 0;
+    return true;
+}
+
+void ReplayDigest::add(uint8_t reportId, const void* report, size_t len) {
+    const uint8_t* bytes = (const uint8_t*)report;
+    uint32_t hash = (hash_ ^ reportId) * 16777619u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    hash_ = hash;
+    reports_++;
+}
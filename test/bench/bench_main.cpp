@@ -0,0 +1,173 @@
+// 主机微基准：运行与硬件无关的用例（解析、管线、变换），输出与固件 microbench 命令相同的 JSON 行，
+// 主机上的“周期”即纳秒。结果重定向到文件存档，比较不同版本：
+//   pio run -e bench && .pio/build/bench/program [迭代次数] [名称过滤] > bench.jsonl
+// trace 模式从标准输入读取 capture dump 的串口输出，把其中的运动样本当作录制的轨迹，评估
+// 抖动滤波（开/关）的报告数与附加延迟，以及按 1/4/8 个样本一帧重新编码为压缩帧时的帧长与解码耗时，
+// 同样每行一个 JSON 对象：
+//   .pio/build/bench/program trace [名称过滤] < capture.log
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "config.h"
+#include "jitter_filter.h"
+#include "microbench.h"
+#include "packed_motion.h"
+#include "replay.h"
+
+// 录制轨迹中的一个运动样本；atUs 为发送端时刻（有时间戳时）或按报告周期累加的时刻
+struct TraceSample {
+    int16_t dx, dy;
+    int8_t wheel;
+    uint8_t buttons;
+    uint32_t atUs;
+};
+
+static std::vector<TraceSample> trace;
+static uint32_t traceClockUs = 0;
+
+static void collectSample(const QueueItem_t& item) {
+    if (item.type != PACKET_TYPE_MOUSE_DATA) {
+        return;
+    }
+    if (item.flags & QUEUE_ITEM_HAS_TIMESTAMP) {
+        traceClockUs = item.senderTimeUs;
+    } else if ((item.flags & QUEUE_ITEM_HAS_SEQ) && item.intervalUs != 0) {
+        traceClockUs += item.intervalUs;
+    } else {
+        traceClockUs = item.arrivalUs;
+    }
+    trace.push_back({item.deltaX, item.deltaY, item.wheel, item.buttons, traceClockUs});
+}
+
+static size_t loadTrace(FILE* in) {
+    static FrameParser parser;
+    char line[2 * CAPTURE_MAX_FRAME + 64];
+    CaptureRecordHeader header;
+    uint8_t data[CAPTURE_MAX_FRAME];
+    while (fgets(line, sizeof(line), in) != NULL) {
+        if (replayParseRecord(line, header, data)) {
+            parser.parse(header.mac, data, header.len, header.arrivalUs, collectSample);
+        }
+    }
+    return trace.size();
+}
+
+static void benchTraceJitter(const char* name, bool enabled) {
+    if (benchFilter != NULL && strstr(name, benchFilter) == NULL) {
+        return;
+    }
+    JitterFilterParams params = kReceiverConfig.jitter;
+    params.enabled = enabled;
+    JitterFilterTables tables;
+    if (!buildJitterFilterTables(params, tables)) {
+        return;
+    }
+    JitterFilterEvaluator eval(tables);
+    for (const TraceSample& s : trace) {
+        eval.add(s.dx, s.dy, s.atUs);
+    }
+    // 逐样本计时在主机上主要是时钟本身的开销，耗时另外对整条轨迹计一次
+    JitterFilter filter;
+    filter.setTables(tables);
+    const uint64_t start = hostNanos();
+    for (const TraceSample& s : trace) {
+        int16_t x = s.dx, y = s.dy;
+        filter.apply(x, y);
+        benchSink += x + y;
+    }
+    const float nsPerSample = (float)(hostNanos() - start) / trace.size();
+    const uint32_t raw = eval.rawReports();
+    printf("{\"bench\":\"%s\",\"samples\":%u,\"raw_reports\":%u,\"reports\":%u,\"report_reduction_pct\":%.1f,"
+           "\"moving_samples\":%u,\"mean_latency_us\":%.1f,\"max_latency_us\":%u,\"ns_per_sample\":%.1f}\n",
+           name, eval.samples(), raw, eval.reports(), raw ? 100.0f * ((float)raw - eval.reports()) / raw : 0.0f,
+           eval.movingSamples(), eval.meanLatencyUs(), eval.maxLatencyUs(), nsPerSample);
+}
+
+// 轨迹按 batch 个样本一帧重新编码（与发送端一样每 64 帧强制携带一次按键），统计平均帧长；
+// 再反复解码全部帧计时，并逐样本核对解码结果
+static void benchTracePacked(const char* name, uint8_t batch) {
+    if (benchFilter != NULL && strstr(name, benchFilter) == NULL) {
+        return;
+    }
+    std::vector<uint8_t> frames;
+    std::vector<uint8_t> lengths;
+    uint8_t lastButtons = 0;
+    uint16_t seq = 0;
+    for (size_t i = 0; i < trace.size(); i += batch) {
+        const uint8_t n = (uint8_t)(trace.size() - i < batch ? trace.size() - i : batch);
+        PackedSample samples[PACKED_MAX_SAMPLES];
+        for (uint8_t k = 0; k < n; k++) {
+            const TraceSample& s = trace[i + k];
+            samples[k] = {s.dx, s.dy, s.wheel, s.buttons};
+        }
+        uint8_t frame[PACKED_MAX_FRAME_SIZE];
+        const size_t len = encodePackedMotion(samples, n, seq, 1000, lastButtons, lengths.size() % 64 == 0, frame,
+                                              sizeof(frame));
+        frames.insert(frames.end(), frame, frame + len);
+        lengths.push_back((uint8_t)len);
+        seq = (uint16_t)(seq + n);
+    }
+
+    PackedMotionDecoder decoder;
+    size_t checked = 0;
+    uint32_t mismatches = 0;
+    const uint8_t* p = frames.data();
+    for (uint8_t len : lengths) {
+        const bool ok = decoder.decode(benchMac, 0, p, len, [&](const QueueItem_t& item) {
+            const TraceSample& s = trace[checked++];
+            mismatches += item.deltaX != s.dx || item.deltaY != s.dy || item.wheel != s.wheel || item.buttons != s.buttons;
+        });
+        mismatches += !ok;
+        p += len;
+    }
+    mismatches += checked != trace.size();
+
+    // 至少解码约 100 万个样本，计时才稳定
+    const uint32_t rounds = (uint32_t)(1000000 / trace.size() + 1);
+    const uint64_t start = hostNanos();
+    for (uint32_t r = 0; r < rounds; r++) {
+        decoder.reset();
+        p = frames.data();
+        for (uint8_t len : lengths) {
+            decoder.decode(benchMac, 0, p, len, [](const QueueItem_t& item) { benchSink += item.deltaX; });
+            p += len;
+        }
+    }
+    const float nsPerSample = (float)(hostNanos() - start) / ((float)rounds * trace.size());
+
+    printf("{\"bench\":\"%s\",\"samples\":%u,\"frames\":%u,\"bytes_per_frame\":%.2f,\"bytes_per_sample\":%.2f,"
+           "\"fixed_bytes_per_sample\":%u,\"ns_per_sample\":%.1f,\"mismatches\":%u}\n",
+           name, (unsigned)trace.size(), (unsigned)lengths.size(), (float)frames.size() / lengths.size(),
+           (float)frames.size() / trace.size(), (unsigned)sizeof(MotionPacket), nsPerSample, mismatches);
+}
+
+static int runTraceBenches(const char* filter) {
+    if (loadTrace(stdin) == 0) {
+        fprintf(stderr, "标准输入中没有运动样本（需要 capture dump 的输出）\n");
+        return 1;
+    }
+    benchFilter = filter;
+    benchTraceJitter("trace/jitter_off", false);
+    benchTraceJitter("trace/jitter_on", true);
+    benchTracePacked("trace/packed1", 1);
+    benchTracePacked("trace/packed4", 4);
+    benchTracePacked("trace/packed8", PACKED_MAX_SAMPLES);
+    benchFilter = NULL;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "trace") == 0) {
+        return runTraceBenches(argc > 2 ? argv[2] : NULL);
+    }
+    uint32_t iterations = argc > 1 ? (uint32_t)atol(argv[1]) : 1000000;
+    if (iterations == 0) {
+        iterations = 1;
+    }
+    runPortableMicrobenches(iterations, argc > 2 ? argv[2] : NULL);
+    return 0;
+}
@@ -0,0 +1,37 @@
+// 接收帧解析器的 libFuzzer 入口（pio run -e fuzz_parser）
+// 首字节是控制字节：最低位选择两个发送端之一，最高位清空解码器状态；其余字节是一帧。
+// 同一个解析器实例跨输入保留状态，覆盖 FEC 重组、累计计数与批量帧按发送端记住的状态。
+
+#include <stdlib.h>
+
+#include "frame_parser.h"
+
+static const uint8_t kMacs[2][6] = {
+    {0x02, 0x11, 0x22, 0x33, 0x44, 0x55},
+    {0x02, 0x66, 0x77, 0x88, 0x99, 0xAA},
+};
+
+static void checkItem(const QueueItem_t& item) {
+    if (!frameItemIsValid(item)) {
+        abort();
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static FrameParser parser;
+    if (size == 0) {
+        return 0;
+    }
+    const uint8_t control = data[0];
+    if (control & 0x80) {
+        parser.reset();
+    }
+    const uint8_t* frame = data + 1;
+    const size_t len = size - 1;
+    const FrameRoute route = parser.parse(kMacs[control & 1], frame, len, (uint32_t)size, checkItem);
+    // 认证前的控制帧判断必须与完整解析的去向一致
+    if (FrameParser::isControl(frame, len) != (route == FRAME_CONTROL)) {
+        abort();
+    }
+    return 0;
+}
@@ -0,0 +1,5 @@
+# libFuzzer 只随 clang 提供：编译与链接都换成 clang，链接时同样带上 sanitizer
+Import("env")
+
+env.Replace(CC="clang", CXX="clang++", LINK="clang++")
+env.Append(LINKFLAGS=["-fsanitize=fuzzer,address,undefined"])
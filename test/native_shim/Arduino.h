@@ -0,0 +1,68 @@
+#pragma once
+
+// --- 主机测试用的 Arduino 最小替身 ---
+// 只提供可在主机上编译的模块（管线、加速、滤波、解析、信道模拟等）用到的接口，
+// 供 [env:native] 的单元测试、回放、模拟与基准程序使用；不会进入固件构建。
+
+#include <chrono>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IRAM_ATTR
+#define HEX 16
+#define DEC 10
+
+inline uint64_t hostNanos() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+inline unsigned long micros() { return (unsigned long)(uint32_t)(hostNanos() / 1000); }
+inline unsigned long millis() { return (unsigned long)(uint32_t)(hostNanos() / 1000000); }
+inline void delay(uint32_t) {}
+
+// 串口输出直接写到标准输出
+class HostSerial {
+public:
+    void begin(unsigned long) {}
+    size_t print(const char* s) { return (size_t)fputs(s, stdout); }
+    size_t println(const char* s = "") { return (size_t)printf("%s\n", s); }
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, fmt);
+        const int n = vprintf(fmt, args);
+        va_end(args);
+        return n < 0 ? 0 : (size_t)n;
+    }
+};
+
+inline HostSerial Serial;
+
+// 主机上没有 CPU 周期计数器，以纳秒代替（基准输出中的“周期”即纳秒）
+class HostEsp {
+public:
+    uint32_t getCycleCount() const { return (uint32_t)hostNanos(); }
+    uint32_t getCpuFreqMHz() const { return 1000; }
+};
+
+inline HostEsp ESP;
+
+// FreeRTOS 临界区：主机测试是单线程的，全部退化为空操作
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+
+typedef uint32_t TickType_t;
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFu)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
@@ -0,0 +1,6 @@
+#pragma once
+
+// --- 主机测试用的 esp_now.h 替身 ---
+// 只提供与硬件无关的模块（帧认证）用到的常量
+
+#define ESP_NOW_MAX_DATA_LEN 250
@@ -0,0 +1,57 @@
+// 主机回放：从标准输入读取 capture dump 的串口输出，经解析器和接收路径（kReceiverConfig）重放
+//   pio run -e replay && .pio/build/replay/program [print] < capture.log
+// 不是记录的行（其他日志）被跳过。摘要按管线的输出计算，与设备上 replay 命令的摘要（USB 报告字节）
+// 不可直接比较，用来比较两个版本在主机上的输出。print 时逐条输出报告：
+//   H <相对时间us> <dx> <dy> <滚动> <水平滚动> <按键>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "replay.h"
+
+struct DigestSink {
+    bool report(int16_t x, int16_t y, int16_t scroll, int16_t pan, uint8_t buttons, bool force) {
+        const int16_t fields[4] = {x, y, scroll, pan};
+        uint8_t bytes[sizeof(fields) + 1];
+        memcpy(bytes, fields, sizeof(fields));
+        bytes[sizeof(fields)] = buttons;
+        digest.add(0, bytes, sizeof(bytes));
+        if (print) {
+            printf("H %u %d %d %d %d 0x%02X\n", (unsigned)(clock->nowUs() - startUs), x, y, scroll, pan, buttons);
+        }
+        return true;
+    }
+
+    ReplayDigest digest;
+    bool print = false;
+    const Clock* clock = nullptr;
+    uint32_t startUs = 0;
+};
+
+int main(int argc, char** argv) {
+    static DigestSink sink;
+    static FrameReplayer<kReceiverConfig, DigestSink> replayer(sink);
+    sink.print = argc > 1 && strcmp(argv[1], "print") == 0;
+    sink.clock = &replayer.clock();
+
+    char line[2 * CAPTURE_MAX_FRAME + 64];
+    CaptureRecordHeader header;
+    uint8_t data[CAPTURE_MAX_FRAME];
+    uint32_t skipped = 0;
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        if (!replayParseRecord(line, header, data)) {
+            skipped++;
+            continue;
+        }
+        if (replayer.frames() == 0) {
+            sink.startUs = header.arrivalUs;
+        }
+        replayer.feed(header, data);
+    }
+    replayer.finish(100000);
+
+    printf("[回放] %u 帧（跳过 %u 行）样本 %u HID报告 %u 摘要 %08X 非法帧 %u\n", replayer.frames(), skipped,
+           replayer.items(), sink.digest.reports(), sink.digest.value(), replayer.parser().rejected());
+    return replayer.frames() > 0 ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+// 主机链路仿真：按场景文件（test/sim/scenarios/*.txt）以虚拟时间运行参照与场景两遍，输出与固件
+// sim 命令相同的统计（丢包、断线、报告延迟、光标误差）
+//   pio run -e sim && .pio/build/sim/program test/sim/scenarios/*.txt
+// 场景文件的格式见 link_sim.h。任一文件不能解析时返回非零。
+
+#include <stdio.h>
+
+#include "config.h"
+#include "sim_runner.h"
+
+static bool loadSettings(const char* path, SimSettings& settings) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        printf("错误：无法打开 %s\n", path);
+        return false;
+    }
+    simDefaultSettings(settings);
+    char line[128];
+    int lineNo = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file) != NULL) {
+        lineNo++;
+        if (!simParseSettingLine(settings, line)) {
+            printf("错误：%s:%d 无法解析：%s", path, lineNo, line);
+            ok = false;
+        }
+    }
+    fclose(file);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("用法：%s <场景文件>...\n内置场景：\n", argv[0]);
+        for (size_t i = 0; i < kLinkSimScenarioCount; i++) {
+            printf("  %-10s %s\n", kLinkSimScenarios[i].name, kLinkSimScenarios[i].description);
+        }
+        return 1;
+    }
+    static HostLinkSim<kReceiverConfig> sim;
+    int failures = 0;
+    for (int i = 1; i < argc; i++) {
+        SimSettings settings;
+        if (!loadSettings(argv[i], settings)) {
+            failures++;
+            continue;
+        }
+        printf("== %s（%u 秒）\n", argv[i], settings.seconds);
+        linkSimPrintParams(settings.params);
+        sim.run(settings);
+        simPrintComparison(settings.scenario->name, settings.format, settings.seed, sim.truthX(), sim.truthY(),
+                           sim.reference(), sim.scenario());
+    }
+    return failures == 0 ? 0 : 1;
+}
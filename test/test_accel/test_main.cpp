@@ -0,0 +1,98 @@
+// 指针加速：速度归一化、控制点解析（pio test -e native -f test_accel）
+
+#include <unity.h>
+
+#include "accel.h"
+
+// 速度 >= 8 计数/毫秒时增益为 2，否则为 1
+static AccelCurve stepCurve() {
+    AccelCurveParams params = {};
+    params.type = ACCEL_CURVE_PIECEWISE;
+    params.points[0] = {7, 1.0f};
+    params.points[1] = {8, 2.0f};
+    params.pointCount = 2;
+    AccelCurve curve;
+    TEST_ASSERT_TRUE(buildAccelCurve(params, curve));
+    return curve;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_speed_is_normalized_to_counts_per_ms(void) {
+    AccelEngine engine;
+    engine.setCurve(stepCurve());
+
+    // 1kHz：每样本 4 计数 = 4 计数/毫秒，不加速
+    int16_t dx = 4, dy = 0;
+    engine.apply(dx, dy);
+    TEST_ASSERT_EQUAL_INT(4, dx);
+
+    // 8kHz：同样每样本 4 计数，实际速度 32 计数/毫秒
+    engine.setSampleInterval(125);
+    dx = 4;
+    dy = 0;
+    engine.apply(dx, dy);
+    TEST_ASSERT_EQUAL_INT(8, dx);
+
+    // 125Hz：每样本 40 计数只有 5 计数/毫秒
+    engine.setSampleInterval(8000);
+    dx = 40;
+    dy = 0;
+    engine.apply(dx, dy);
+    TEST_ASSERT_EQUAL_INT(40, dx);
+
+    // 周期未知时沿用上一次的值
+    engine.setSampleInterval(0);
+    dx = 64;
+    dy = 0;
+    engine.apply(dx, dy);
+    TEST_ASSERT_EQUAL_INT(128, dx);
+
+    // reset 恢复默认周期
+    engine.reset();
+    dx = 4;
+    dy = 0;
+    engine.apply(dx, dy);
+    TEST_ASSERT_EQUAL_INT(4, dx);
+}
+
+static void test_speed_scale_does_not_overflow(void) {
+    AccelEngine engine;
+    engine.setCurve(stepCurve());
+    engine.setSampleInterval(1);
+    int16_t dx = INT16_MAX, dy = INT16_MIN;
+    engine.apply(dx, dy);
+    TEST_ASSERT_EQUAL_INT(INT16_MAX, dx);
+    TEST_ASSERT_EQUAL_INT(INT16_MIN, dy);
+    TEST_ASSERT_EQUAL_UINT32(accelSpeedScale(ACCEL_MIN_INTERVAL_US), accelSpeedScale(1));
+}
+
+static void test_parse_point_accepts_valid_input(void) {
+    AccelPoint point = {};
+    TEST_ASSERT_TRUE(accelParsePoint("12:1.5", point));
+    TEST_ASSERT_EQUAL_UINT8(12, point.speed);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.5f, point.gain);
+    TEST_ASSERT_TRUE(accelParsePoint("255:0", point));
+    TEST_ASSERT_EQUAL_UINT8(255, point.speed);
+}
+
+static void test_parse_point_rejects_bad_input(void) {
+    AccelPoint point = {3, 0.5f};
+    const char* bad[] = {"256:1", "-1:1", "300:1", "12", "12:", ":1", "a:1", "12x:1", "12:1x", "12:-0.5", "12:99",
+                         "12:nan"};
+    for (const char* token : bad) {
+        TEST_ASSERT_FALSE(accelParsePoint(token, point));
+    }
+    TEST_ASSERT_EQUAL_UINT8(3, point.speed);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.5f, point.gain);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_speed_is_normalized_to_counts_per_ms);
+    RUN_TEST(test_speed_scale_does_not_overflow);
+    RUN_TEST(test_parse_point_accepts_valid_input);
+    RUN_TEST(test_parse_point_rejects_bad_input);
+    return UNITY_END();
+}
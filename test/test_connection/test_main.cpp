@@ -0,0 +1,356 @@
+// 连接状态机：首包连接、心跳超时、广播间隔与虚拟时钟下的连接抖动（pio test -e native -f test_connection）
+
+#include <unity.h>
+
+#include "config.h"
+#include "connection.h"
+#include "link_sim.h"
+
+static const uint8_t kMac[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+static const uint8_t kOtherMac[6] = {0x02, 0x66, 0x77, 0x88, 0x99, 0xAA};
+static const ConnectionParams kParams = {kReceiverConfig.connectionTimeoutMs, kReceiverConfig.beaconIntervalMs};
+
+// 记录状态机发出的动作
+struct RecordingEvents final : ConnectionEvents {
+    void onConnected(const uint8_t mac[6], const LinkMode& mode) override {
+        connects++;
+        memcpy(lastMac, mac, 6);
+        lastMode = mode;
+    }
+    void onDisconnected(const uint8_t mac[6], DisconnectReason reason) override {
+        disconnects++;
+        memcpy(lastMac, mac, 6);
+        timeouts += reason == DISCONNECT_TIMEOUT;
+    }
+    void onBeacon() override { beacons++; }
+
+    uint32_t connects = 0;
+    uint32_t disconnects = 0;
+    uint32_t timeouts = 0;  // 其中因心跳超时断开的次数
+    uint32_t beacons = 0;
+    uint8_t lastMac[6] = {};
+    LinkMode lastMode = {};
+};
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_first_packet_connects_legacy_sender(void) {
+    VirtualClock clock(5000);
+    RecordingEvents events;
+    ConnectionManager connection(kParams, clock, events);
+    TEST_ASSERT_FALSE(connection.connected());
+
+    TEST_ASSERT_TRUE(connection.packetSeen(kMac));
+    TEST_ASSERT_TRUE(connection.connected());
+    TEST_ASSERT_TRUE(connection.isPeer(kMac));
+    TEST_ASSERT_FALSE(connection.isPeer(kOtherMac));
+    TEST_ASSERT_EQUAL_UINT32(1, connection.generation());
+    TEST_ASSERT_EQUAL_UINT32(1, events.connects);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(kMac, events.lastMac, 6);
+    TEST_ASSERT_EQUAL_INT(MOTION_FORMAT_LEGACY, events.lastMode.format);
+
+    // 已连接时只刷新心跳；其他发送端的数据包既不重建连接，也不替对端保活
+    clock.advanceMs(10);
+    TEST_ASSERT_FALSE(connection.packetSeen(kMac));
+    TEST_ASSERT_EQUAL_UINT32(1, connection.generation());
+    TEST_ASSERT_EQUAL_UINT32(1, events.connects);
+    clock.advanceMs(kParams.timeoutMs);
+    TEST_ASSERT_FALSE(connection.packetSeen(kOtherMac));
+    TEST_ASSERT_TRUE(connection.isPeer(kMac));
+    clock.advanceMs(1);
+    connection.service();
+    TEST_ASSERT_FALSE(connection.connected());
+}
+
+// 其他任务读到的快照随每次状态变化发布
+static void test_snapshot_follows_state_changes(void) {
+    VirtualClock clock(0);
+    RecordingEvents events;
+    ConnectionManager connection(kParams, clock, events);
+    ConnectionSnapshot link = connection.snapshot();
+    TEST_ASSERT_FALSE(link.connected);
+    TEST_ASSERT_EQUAL_UINT32(0, link.generation);
+
+    connection.connect(kMac, legacyLinkMode());
+    link = connection.snapshot();
+    TEST_ASSERT_TRUE(link.isPeer(kMac));
+    TEST_ASSERT_FALSE(link.isPeer(kOtherMac));
+    TEST_ASSERT_EQUAL_UINT32(1, link.generation);
+
+    connection.pause();
+    link = connection.snapshot();
+    TEST_ASSERT_FALSE(link.isPeer(kMac));
+    TEST_ASSERT_EQUAL_UINT32(0, link.disconnects);
+
+    connection.connect(kOtherMac, legacyLinkMode());
+    connection.disconnect();
+    // 主动断开不算超时
+    TEST_ASSERT_EQUAL_UINT32(1, events.disconnects);
+    TEST_ASSERT_EQUAL_UINT32(0, events.timeouts);
+    link = connection.snapshot();
+    TEST_ASSERT_FALSE(link.connected);
+    TEST_ASSERT_EQUAL_UINT32(2, link.generation);
+    TEST_ASSERT_EQUAL_UINT32(1, link.disconnects);
+    const uint8_t zero[6] = {};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(zero, link.peer, 6);
+}
+
+// mouseTask 转交的心跳时刻：只向前推，未连接时忽略
+static void test_heartbeat_only_moves_forward(void) {
+    VirtualClock clock(UINT32_MAX - 50);  // 跨过 millis() 回绕
+    RecordingEvents events;
+    ConnectionManager connection(kParams, clock, events);
+    connection.heartbeat(clock.nowMs() + 10);
+    connection.connect(kMac, legacyLinkMode());
+    const uint32_t connectedAt = clock.nowMs();
+
+    clock.advanceMs(200);
+    connection.heartbeat(connectedAt + 200);
+    connection.heartbeat(connectedAt + 100);  // 迟到的旧时刻不会把心跳往回拨
+    clock.advanceMs(kParams.timeoutMs);
+    connection.service();
+    TEST_ASSERT_TRUE(connection.connected());
+    clock.advanceMs(1);
+    connection.service();
+    TEST_ASSERT_FALSE(connection.connected());
+
+    connection.heartbeat(clock.nowMs());
+    TEST_ASSERT_FALSE(connection.connected());
+    TEST_ASSERT_EQUAL_UINT32(1, connection.generation());
+}
+
+// 最后一个数据包之后恰好超过 timeoutMs 才断开；断开后清空对端并回到旧式链路模式
+static void test_timeout_disconnects_after_exact_silence(void) {
+    VirtualClock clock(UINT32_MAX - 1000);  // 心跳计时跨过 millis() 回绕
+    RecordingEvents events;
+    ConnectionManager connection(kParams, clock, events);
+    LinkMode mode = legacyLinkMode();
+    mode.format = MOTION_FORMAT_PACKED;
+    connection.connect(kMac, mode);
+    TEST_ASSERT_EQUAL_INT(MOTION_FORMAT_PACKED, connection.mode().format);
+
+    clock.advanceMs(kParams.timeoutMs);
+    connection.service();
+    TEST_ASSERT_TRUE(connection.connected());
+    clock.advanceMs(1);
+    connection.service();
+    TEST_ASSERT_FALSE(connection.connected());
+    TEST_ASSERT_EQUAL_UINT32(1, connection.disconnects());
+    TEST_ASSERT_EQUAL_UINT32(1, events.disconnects);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(kMac, events.lastMac, 6);
+    TEST_ASSERT_EQUAL_UINT32(1, events.timeouts);
+    TEST_ASSERT_FALSE(connection.isPeer(kMac));
+    TEST_ASSERT_EQUAL_INT(MOTION_FORMAT_LEGACY, connection.mode().format);
+}
+
+// 未连接时按间隔广播，已连接时不广播
+static void test_beacons_only_while_disconnected(void) {
+    VirtualClock clock(100000);
+    RecordingEvents events;
+    ConnectionManager connection(kParams, clock, events);
+    for (uint32_t ms = 0; ms < 10 * kParams.beaconIntervalMs; ms += 100) {
+        connection.service();
+        clock.advanceMs(100);
+    }
+    TEST_ASSERT_EQUAL_UINT32(10, events.beacons);
+    TEST_ASSERT_EQUAL_UINT32(10, connection.beacons());
+
+    connection.packetSeen(kMac);
+    for (uint32_t ms = 0; ms < kParams.timeoutMs; ms += 100) {
+        connection.service();
+        clock.advanceMs(100);
+        connection.packetSeen(kMac);
+    }
+    TEST_ASSERT_EQUAL_UINT32(10, events.beacons);
+}
+
+// 重新认证期间暂停连接：不接受数据、开始广播，但不删除对等设备；认证通过后以新的代数恢复
+static void test_pause_for_reauthentication(void) {
+    VirtualClock clock(0);
+    RecordingEvents events;
+    ConnectionManager connection(kParams, clock, events);
+    connection.packetSeen(kMac);
+    connection.pause();
+    TEST_ASSERT_FALSE(connection.connected());
+    TEST_ASSERT_FALSE(connection.isPeer(kMac));
+    clock.advanceMs(kParams.beaconIntervalMs);
+    connection.service();
+    TEST_ASSERT_EQUAL_UINT32(0, events.disconnects);
+    TEST_ASSERT_EQUAL_UINT32(1, events.beacons);
+
+    connection.connect(kMac, legacyLinkMode());
+    TEST_ASSERT_TRUE(connection.isPeer(kMac));
+    TEST_ASSERT_EQUAL_UINT32(2, connection.generation());
+    TEST_ASSERT_EQUAL_UINT32(0, connection.disconnects());
+}
+
+// --- 连接抖动 ---
+// 虚拟时钟下走完数小时的“发送端出现—持续发包（偶有短暂停顿）—消失”循环。数据包按 mouseTask 的处理：
+// 来自对端时记下心跳时刻，未连接时由控制任务（收到消息立即处理）调用 packetSeen；控制任务的每一拍
+// 先转交心跳时刻再调用 service。核对每个事件发生的时刻：
+//   - 首个数据包立即建立连接，连接期间不广播；
+//   - 短于超时的停顿不会断开，最后一个数据包之后恰好在第一个超过 timeoutMs 的节拍断开；
+//   - 断开后的下一拍立即广播，之后每隔 beaconIntervalMs（按节拍向上取整）广播一次。
+// 虚拟时间从 millis() 回绕前 1 分钟开始，顺带覆盖 49.7 天一次的回绕。
+constexpr uint32_t CHURN_START_MS = UINT32_MAX - 60000;
+constexpr uint32_t CHURN_MIN_SESSION_MS = 1000;
+constexpr uint32_t CHURN_MAX_SESSION_MS = 600000;  // 一次连接持续的最长时间
+constexpr uint32_t CHURN_MAX_ABSENT_MS = 20000;    // 超时之后发送端再离开的最长时间
+constexpr uint32_t CHURN_MAX_INTERVAL_MS = 500;    // 正常发包间隔上限
+constexpr float CHURN_STALL_CHANCE = 0.002f;       // 每个包之后出现短暂停顿（不超过超时）的概率
+
+struct ChurnResult {
+    uint32_t sessions;
+    uint32_t connects;
+    uint32_t disconnects;
+    uint32_t packets;
+    uint32_t stalls;
+    uint32_t beacons;
+    uint32_t earlyDisconnects;     // 停顿未超过超时就断开
+    uint32_t lateDisconnects;      // 超时后的第一拍没有断开
+    uint32_t beaconGapErrors;      // 连续未连接期间广播间隔不等于预期
+    uint32_t lateFirstBeacons;     // 断开后的下一拍没有广播
+    uint32_t beaconsWhileConnected;
+};
+
+static ChurnResult runChurn(uint32_t durationMs, uint32_t seed) {
+    const uint32_t step = kReceiverConfig.loopIntervalMs;
+    const uint32_t timeout = kParams.timeoutMs;
+    const uint32_t beaconGap = (kParams.beaconIntervalMs + step - 1) / step * step;
+    VirtualClock clock(CHURN_START_MS);
+    RecordingEvents events;
+    ConnectionManager connection(kParams, clock, events);
+    SimRandom random;
+    random.seed(seed);
+    ChurnResult r = {};
+
+    uint32_t loopAt = CHURN_START_MS + step;
+    uint32_t packetAt = CHURN_START_MS + 1 + random.next() % CHURN_MAX_ABSENT_MS;
+    bool present = false;
+    uint32_t sessionEnd = 0, lastPacketAt = 0, lastBeaconAt = 0, disconnectedAt = 0;
+    bool beaconRun = false;      // 上次广播之后一直未连接
+    bool awaitingBeacon = false; // 刚断开，下一拍应广播
+    bool timeoutMissed = false;
+    uint32_t peerPacketMs = 0;   // mouseTask 转交给控制任务的心跳时刻（0 = 没有新的）
+
+    while (loopAt - CHURN_START_MS <= durationMs) {
+        // 与节拍同一毫秒到达的数据包先处理
+        if ((int32_t)(packetAt - loopAt) <= 0) {
+            clock.advanceToMs(packetAt);
+            if (!present) {
+                present = true;
+                r.sessions++;
+                sessionEnd = packetAt + CHURN_MIN_SESSION_MS + random.next() % CHURN_MAX_SESSION_MS;
+            }
+            if (connection.snapshot().isPeer(kMac)) {
+                peerPacketMs = packetAt;
+            } else if (connection.packetSeen(kMac)) {
+                r.connects++;
+                beaconRun = false;
+                awaitingBeacon = false;
+                timeoutMissed = false;
+            }
+            lastPacketAt = packetAt;
+            r.packets++;
+
+            uint32_t next = 1 + random.next() % CHURN_MAX_INTERVAL_MS;
+            if (random.chance(CHURN_STALL_CHANCE)) {
+                next = CHURN_MAX_INTERVAL_MS + random.next() % (timeout - CHURN_MAX_INTERVAL_MS + 1);
+                r.stalls++;
+            }
+            if ((int32_t)(packetAt + next - sessionEnd) > 0) {
+                // 离开：至少超时一拍之后才回来，每次会话都应断开一次
+                present = false;
+                next = timeout + step + 1 + random.next() % CHURN_MAX_ABSENT_MS;
+            }
+            packetAt += next;
+            continue;
+        }
+
+        clock.advanceToMs(loopAt);
+        const bool wasConnected = connection.connected();
+        const uint32_t beacons = events.beacons;
+        const uint32_t disconnects = events.disconnects;
+        if (peerPacketMs != 0) {
+            connection.heartbeat(peerPacketMs);
+            peerPacketMs = 0;
+        }
+        connection.service();
+
+        if (events.disconnects != disconnects) {
+            r.disconnects++;
+            const uint32_t silentMs = loopAt - lastPacketAt;
+            if (silentMs <= timeout) {
+                r.earlyDisconnects++;
+            } else if (silentMs > timeout + step) {
+                r.lateDisconnects++;
+            }
+            disconnectedAt = loopAt;
+            awaitingBeacon = true;
+        } else if (connection.connected() && loopAt - lastPacketAt > timeout + step && !timeoutMissed) {
+            r.lateDisconnects++;
+            timeoutMissed = true;
+        }
+
+        if (events.beacons != beacons) {
+            r.beacons++;
+            if (wasConnected) {
+                r.beaconsWhileConnected++;
+            }
+            if (awaitingBeacon && loopAt - disconnectedAt != step) {
+                r.lateFirstBeacons++;
+            }
+            if (beaconRun && loopAt - lastBeaconAt != beaconGap) {
+                r.beaconGapErrors++;
+            }
+            awaitingBeacon = false;
+            beaconRun = true;
+            lastBeaconAt = loopAt;
+        } else if (awaitingBeacon && loopAt != disconnectedAt) {
+            r.lateFirstBeacons++;
+            awaitingBeacon = false;
+        } else if (!connection.connected() && beaconRun && loopAt - lastBeaconAt > beaconGap) {
+            r.beaconGapErrors++;
+            beaconRun = false; // 同一段只计一次
+        }
+        loopAt += step;
+    }
+    TEST_ASSERT_EQUAL_UINT32(r.connects, events.connects);
+    TEST_ASSERT_EQUAL_UINT32(r.connects, connection.generation());
+    return r;
+}
+
+static void checkChurn(uint32_t hours, uint32_t seed) {
+    const ChurnResult r = runChurn(hours * 3600000u, seed);
+    TEST_ASSERT_GREATER_THAN(hours * 10, r.sessions);
+    TEST_ASSERT_GREATER_THAN(0, r.stalls);
+    TEST_ASSERT_EQUAL_UINT32(r.sessions, r.connects);
+    // 最后一次会话可能在结束时仍未超时
+    TEST_ASSERT_UINT32_WITHIN(1, r.sessions, r.disconnects);
+    TEST_ASSERT_EQUAL_UINT32(0, r.earlyDisconnects);
+    TEST_ASSERT_EQUAL_UINT32(0, r.lateDisconnects);
+    TEST_ASSERT_EQUAL_UINT32(0, r.beaconGapErrors);
+    TEST_ASSERT_EQUAL_UINT32(0, r.lateFirstBeacons);
+    TEST_ASSERT_EQUAL_UINT32(0, r.beaconsWhileConnected);
+}
+
+static void test_churn_day(void) { checkChurn(24, 1); }
+static void test_churn_other_seeds(void) {
+    for (uint32_t seed = 2; seed <= 5; seed++) {
+        checkChurn(2, seed);
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_packet_connects_legacy_sender);
+    RUN_TEST(test_snapshot_follows_state_changes);
+    RUN_TEST(test_heartbeat_only_moves_forward);
+    RUN_TEST(test_timeout_disconnects_after_exact_silence);
+    RUN_TEST(test_beacons_only_while_disconnected);
+    RUN_TEST(test_pause_for_reauthentication);
+    RUN_TEST(test_churn_day);
+    RUN_TEST(test_churn_other_seeds);
+    return UNITY_END();
+}
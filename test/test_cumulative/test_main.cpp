@@ -0,0 +1,156 @@
+// 累计计数解码：32 位回绕、截断进位与有损链路（pio test -e native -f test_cumulative）
+
+#include <unity.h>
+
+#include "cumulative.h"
+#include "link_sim.h"
+
+static const uint8_t kMac[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+
+static CumulativeMotionPacket frame(uint16_t seq, uint32_t x, uint32_t y, uint32_t wheel) {
+    CumulativeMotionPacket packet = {};
+    packet.type = PACKET_TYPE_MOTION_CUMULATIVE;
+    packet.seq = seq;
+    packet.intervalUs = 1000;
+    packet.totalX = x;
+    packet.totalY = y;
+    packet.totalWheel = wheel;
+    return packet;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_counters_wrap_in_both_directions(void) {
+    CumulativeDecoder decoder;
+    QueueItem_t item = {};
+    uint32_t x = UINT32_MAX - 25, y = 25, wheel = UINT32_MAX;
+    TEST_ASSERT_TRUE(decoder.decode(kMac, frame(0, x, y, wheel), item));
+    TEST_ASSERT_EQUAL_INT(0, item.deltaX);
+
+    for (uint16_t seq = 1; seq <= 10; seq++) {
+        x += 10;  // 向上越过 UINT32_MAX
+        y -= 10;  // 向下越过 0
+        wheel += 1;
+        TEST_ASSERT_TRUE(decoder.decode(kMac, frame(seq, x, y, wheel), item));
+        TEST_ASSERT_EQUAL_INT(10, item.deltaX);
+        TEST_ASSERT_EQUAL_INT(-10, item.deltaY);
+        TEST_ASSERT_EQUAL_INT(1, item.wheel);
+        TEST_ASSERT_EQUAL_UINT16(seq, item.seq);
+    }
+}
+
+// 超出 int16 的增量分多帧送出，总量不丢
+static void test_large_delta_is_carried_to_next_frame(void) {
+    CumulativeDecoder decoder;
+    QueueItem_t item = {};
+    const uint32_t base = UINT32_MAX - 1000;
+    TEST_ASSERT_TRUE(decoder.decode(kMac, frame(100, base, 0, 0), item));
+    TEST_ASSERT_TRUE(decoder.decode(kMac, frame(101, base + 50000, 0, 0), item));
+    TEST_ASSERT_EQUAL_INT(INT16_MAX, item.deltaX);
+    TEST_ASSERT_TRUE(decoder.decode(kMac, frame(102, base + 50000, 0, 0), item));
+    TEST_ASSERT_EQUAL_INT(50000 - INT16_MAX, item.deltaX);
+}
+
+static void test_stale_frames_and_sequence_wrap(void) {
+    CumulativeDecoder decoder;
+    QueueItem_t item = {};
+    TEST_ASSERT_TRUE(decoder.decode(kMac, frame(65534, 0, 0, 0), item));
+    TEST_ASSERT_TRUE(decoder.decode(kMac, frame(1, 30, 0, 0), item));  // 序号回绕，跳过 65535 和 0
+    TEST_ASSERT_EQUAL_INT(30, item.deltaX);
+    TEST_ASSERT_FALSE(decoder.decode(kMac, frame(1, 30, 0, 0), item));      // 重复
+    TEST_ASSERT_FALSE(decoder.decode(kMac, frame(65535, 20, 0, 0), item));  // 迟到
+    TEST_ASSERT_EQUAL_UINT32(0, decoder.resyncs());
+
+    // 序号大幅回退：发送端重启，重新建立基准
+    TEST_ASSERT_TRUE(decoder.decode(kMac, frame(60000, 5, 0, 0), item));
+    TEST_ASSERT_EQUAL_INT(0, item.deltaX);
+    TEST_ASSERT_EQUAL_UINT32(1, decoder.resyncs());
+}
+
+// 经过有损信道（突发丢包、抖动、重复、乱序）后，累计输出的光标位置与最后一个被接受的帧的
+// 累计值完全一致；计数器在途中回绕
+static void runLossyLink(const char* scenarioName, uint32_t seed) {
+    const LinkSimScenario* scenario = linkSimFindScenario(scenarioName);
+    TEST_ASSERT_NOT_NULL(scenario);
+    LinkSimChannel channel;
+    channel.reset(scenario->params, seed);
+    static SimDeliveryQueue inFlight;
+    inFlight.clear();
+
+    CumulativeDecoder decoder;
+    SimRandom motion;
+    motion.seed(seed);
+    const uint32_t startX = UINT32_MAX - 2000, startY = 2000;
+    uint32_t totalX = startX, totalY = startY;
+    int64_t cursorX = 0, cursorY = 0;
+    uint32_t acceptedX = startX, acceptedY = startY;
+    uint32_t accepted = 0;
+    bool synced = false;
+
+    auto deliver = [&](const SimDelivery& d) {
+        CumulativeMotionPacket packet;
+        memcpy(&packet, d.data, sizeof(packet));
+        QueueItem_t item = {};
+        if (!decoder.decode(kMac, packet, item)) {
+            return;
+        }
+        if (!synced) {
+            // 首帧只建立基准
+            synced = true;
+            cursorX = (int32_t)(packet.totalX - startX);
+            cursorY = (int32_t)(packet.totalY - startY);
+        } else {
+            cursorX += item.deltaX;
+            cursorY += item.deltaY;
+        }
+        acceptedX = packet.totalX;
+        acceptedY = packet.totalY;
+        accepted++;
+    };
+
+    for (uint32_t i = 0; i < 20000; i++) {
+        const uint32_t nowUs = i * SIM_INTERVAL_US;
+        while (inFlight.size() > 0 && (int32_t)(inFlight.top().deliverUs - nowUs) <= 0) {
+            deliver(inFlight.top());
+            inFlight.pop();
+        }
+        // 每样本 -3~+4 计数，X 向上、Y 向下越过 32 位边界
+        totalX += (motion.next() & 7) - 3;
+        totalY -= (motion.next() & 7) - 3;
+        const CumulativeMotionPacket packet = frame((uint16_t)i, totalX, totalY, 0);
+        uint32_t deliverUs[2];
+        const uint8_t copies = channel.transmit(nowUs, deliverUs);
+        for (uint8_t c = 0; c < copies; c++) {
+            inFlight.push(deliverUs[c], nowUs, (const uint8_t*)&packet, sizeof(packet));
+        }
+    }
+    while (inFlight.size() > 0) {
+        deliver(inFlight.top());
+        inFlight.pop();
+    }
+
+    TEST_ASSERT_TRUE(totalX < startX);  // 确实回绕过
+    TEST_ASSERT_TRUE(totalY > startY);
+    TEST_ASSERT_GREATER_THAN(1000, accepted);
+    TEST_ASSERT_EQUAL_INT32((int32_t)(acceptedX - startX), cursorX);
+    TEST_ASSERT_EQUAL_INT32((int32_t)(acceptedY - startY), cursorY);
+    if (scenario->params.lossBad > 0.0f) {
+        TEST_ASSERT_GREATER_THAN(0, channel.lost());
+    }
+}
+
+static void test_lossy_link_typical(void) { runLossyLink("typical", 1); }
+static void test_lossy_link_bursty(void) { runLossyLink("bursty", 2); }
+static void test_lossy_link_congested(void) { runLossyLink("congested", 3); }
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_counters_wrap_in_both_directions);
+    RUN_TEST(test_large_delta_is_carried_to_next_frame);
+    RUN_TEST(test_stale_frames_and_sequence_wrap);
+    RUN_TEST(test_lossy_link_typical);
+    RUN_TEST(test_lossy_link_bursty);
+    RUN_TEST(test_lossy_link_congested);
+    return UNITY_END();
+}
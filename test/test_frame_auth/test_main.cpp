@@ -0,0 +1,148 @@
+// 明文帧认证：SipHash-2-4 参考向量、标签校验与重放窗口（pio test -e native -f test_frame_auth）
+
+#include <unity.h>
+
+#include "frame_auth.h"
+
+static const uint8_t kMac[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+static const uint8_t kOtherMac[6] = {0x02, 0x66, 0x77, 0x88, 0x99, 0xAA};
+
+static void makeKey(uint8_t key[FRAME_KEY_SIZE], uint8_t base) {
+    for (size_t i = 0; i < FRAME_KEY_SIZE; i++) {
+        key[i] = (uint8_t)(base + i);
+    }
+}
+
+// 带标签的运动帧：帧中只有扩展序号的低 16 位，标签按完整的扩展序号计算
+struct SignedFrame {
+    uint8_t data[sizeof(MotionPacket) + FRAME_TAG_SIZE];
+};
+
+static SignedFrame signedFrame(const uint8_t key[FRAME_KEY_SIZE], uint32_t extSeq, int16_t dx = 1) {
+    const MotionPacket packet = {PACKET_TYPE_MOTION, (uint16_t)extSeq, 1000, dx, 0, 0, 0};
+    SignedFrame frame;
+    memcpy(frame.data, &packet, sizeof(packet));
+    frameAuthSign(key, extSeq, frame.data, sizeof(packet), frame.data + sizeof(packet));
+    return frame;
+}
+
+static bool verify(FrameAuthenticator& auth, const SignedFrame& frame, const uint8_t* mac = kMac) {
+    return auth.verify(mac, frame.data, sizeof(frame.data));
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// 参考实现的测试向量：密钥 00..0F，消息 00..(n-1)
+static void test_siphash_reference_vectors(void) {
+    static const struct {
+        size_t len;
+        uint64_t hash;
+    } vectors[] = {
+        {0, 0x726fdb47dd0e0e31ULL},  {1, 0x74f839c593dc67fdULL},  {7, 0xab0200f58b01d137ULL},
+        {8, 0x93f5f5799a932462ULL},  {9, 0x9e0082df0ba9e4b0ULL},  {15, 0xa129ca6149be45e5ULL},
+        {16, 0x3f2acc7f57c29bdbULL}, {63, 0x958a324ceb064572ULL},
+    };
+    uint8_t key[FRAME_KEY_SIZE];
+    makeKey(key, 0);
+    uint8_t message[64];
+    for (size_t i = 0; i < sizeof(message); i++) {
+        message[i] = (uint8_t)i;
+    }
+    for (const auto& v : vectors) {
+        const uint64_t hash = siphash24(key, message, v.len);
+        TEST_ASSERT_EQUAL_HEX32((uint32_t)v.hash, (uint32_t)hash);
+        TEST_ASSERT_EQUAL_HEX32((uint32_t)(v.hash >> 32), (uint32_t)(hash >> 32));
+    }
+}
+
+// 篡改帧内容或标签、其他发送端、未安装或已清除密钥时都拒绝
+static void test_forged_and_foreign_frames_are_rejected(void) {
+    uint8_t key[FRAME_KEY_SIZE], otherKey[FRAME_KEY_SIZE];
+    makeKey(key, 0x40);
+    makeKey(otherKey, 0x41);
+    FrameAuthenticator auth;
+    TEST_ASSERT_FALSE(verify(auth, signedFrame(key, 0)));
+
+    auth.install(kMac, key);
+    SignedFrame frame = signedFrame(key, 0);
+    frame.data[5] ^= 0x01;
+    TEST_ASSERT_FALSE(verify(auth, frame));
+    frame = signedFrame(key, 0);
+    frame.data[sizeof(frame.data) - 1] ^= 0x80;
+    TEST_ASSERT_FALSE(verify(auth, frame));
+    TEST_ASSERT_FALSE(verify(auth, signedFrame(otherKey, 0)));
+    TEST_ASSERT_EQUAL_UINT32(3, auth.forged());
+
+    TEST_ASSERT_FALSE(verify(auth, signedFrame(key, 0), kOtherMac));
+    TEST_ASSERT_TRUE(verify(auth, signedFrame(key, 0)));
+    auth.clear();
+    TEST_ASSERT_FALSE(verify(auth, signedFrame(key, 1)));
+}
+
+// 重放被拒绝；窗口内乱序到达、未出现过的旧序号仍被接受，超出窗口的旧序号被拒绝
+static void test_replay_window(void) {
+    uint8_t key[FRAME_KEY_SIZE];
+    makeKey(key, 0x10);
+    FrameAuthenticator auth;
+    auth.install(kMac, key);
+    for (uint32_t seq = 0; seq < 100; seq += 2) {
+        TEST_ASSERT_TRUE(verify(auth, signedFrame(key, seq)));
+    }
+    TEST_ASSERT_FALSE(verify(auth, signedFrame(key, 98)));
+    TEST_ASSERT_FALSE(verify(auth, signedFrame(key, 40)));
+    TEST_ASSERT_EQUAL_UINT32(2, auth.replayed());
+
+    // 奇数序号都没出现过：98 - 97 = 1 补记；98 - 35 = 63 仍在窗口内；98 - 33 = 65 已出窗口
+    TEST_ASSERT_TRUE(verify(auth, signedFrame(key, 97)));
+    TEST_ASSERT_FALSE(verify(auth, signedFrame(key, 97)));
+    TEST_ASSERT_TRUE(verify(auth, signedFrame(key, 35)));
+    TEST_ASSERT_FALSE(verify(auth, signedFrame(key, 33)));
+    TEST_ASSERT_EQUAL_UINT32(4, auth.replayed());
+
+    // 跳过大于窗口的一段后，旧序号全部出窗口
+    TEST_ASSERT_TRUE(verify(auth, signedFrame(key, 1000)));
+    TEST_ASSERT_FALSE(verify(auth, signedFrame(key, 99)));
+    TEST_ASSERT_TRUE(verify(auth, signedFrame(key, 999)));
+}
+
+// 16 位序号回绕：高 16 位按最近接受的序号推算，回绕前后的帧都能验证，回绕前的重放仍被拒绝
+static void test_sequence_wraparound(void) {
+    uint8_t key[FRAME_KEY_SIZE];
+    makeKey(key, 0x20);
+    FrameAuthenticator auth;
+    auth.install(kMac, key);
+    // 发送端配对后从 0 开始计数；每步小于半个序号空间，接收端一路跟上第一次回绕
+    for (uint32_t extSeq = 0; extSeq < 0x1FFF0; extSeq += 0x7000) {
+        TEST_ASSERT_TRUE(verify(auth, signedFrame(key, extSeq)));
+    }
+    for (uint32_t extSeq = 0x1FFF0; extSeq < 0x20010; extSeq++) {
+        if (extSeq == 0x1FFFE) {
+            continue;  // 晚一点乱序到达
+        }
+        TEST_ASSERT_TRUE(verify(auth, signedFrame(key, extSeq)));
+    }
+    TEST_ASSERT_TRUE(verify(auth, signedFrame(key, 0x1FFFE)));
+    TEST_ASSERT_FALSE(verify(auth, signedFrame(key, 0x1FFFF)));
+    TEST_ASSERT_FALSE(verify(auth, signedFrame(key, 0x20000)));
+
+    // 帧中的 seq 相同，但高 16 位推算错的标签（少算一次回绕）不能通过
+    TEST_ASSERT_FALSE(verify(auth, signedFrame(key, 0x10010)));
+    TEST_ASSERT_TRUE(verify(auth, signedFrame(key, 0x20010)));
+
+    // 键盘帧有独立的序号空间，不受运动帧窗口影响
+    uint8_t frame[sizeof(KeyboardPacket) + FRAME_TAG_SIZE] = {};
+    frame[0] = PACKET_TYPE_KEYBOARD;
+    frameAuthSign(key, 0, frame, sizeof(KeyboardPacket), frame + sizeof(KeyboardPacket));
+    TEST_ASSERT_TRUE(auth.verify(kMac, frame, sizeof(frame)));
+    TEST_ASSERT_FALSE(auth.verify(kMac, frame, sizeof(frame)));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_siphash_reference_vectors);
+    RUN_TEST(test_forged_and_foreign_frames_are_rejected);
+    RUN_TEST(test_replay_window);
+    RUN_TEST(test_sequence_wraparound);
+    return UNITY_END();
+}
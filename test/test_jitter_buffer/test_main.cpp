@@ -0,0 +1,142 @@
+// 抖动缓冲溢出时的样本顺序（pio test -e native -f test_jitter_buffer）
+
+#include <unity.h>
+
+#include "jitter_buffer.h"
+
+static QueueItem_t timedSample(uint16_t seq, uint32_t senderUs, uint32_t arrivalUs) {
+    QueueItem_t item = {};
+    item.type = PACKET_TYPE_MOUSE_DATA;
+    item.flags = QUEUE_ITEM_HAS_SEQ | QUEUE_ITEM_HAS_TIMESTAMP;
+    item.seq = seq;
+    item.deltaX = 1;
+    item.senderTimeUs = senderUs;
+    item.arrivalUs = arrivalUs;
+    return item;
+}
+
+static JitterBuffer makeBuffer(uint16_t delayUs) {
+    JitterBuffer buffer;
+    buffer.setParams({true, delayUs, delayUs, 3});
+    return buffer;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// 播放延迟远大于缓冲容量对应的时长：每个新样本都会挤出最早的一项，输出仍严格按序号递增，
+// 而且没有样本丢失
+static void test_overflow_evicts_oldest_in_order(void) {
+    JitterBuffer buffer = makeBuffer(50000);
+    uint16_t expected = 0;
+    uint32_t outputs = 0;
+    for (uint16_t seq = 0; seq < 100; seq++) {
+        QueueItem_t evicted;
+        if (buffer.push(timedSample(seq, seq * 1000, seq * 1000 + 200), evicted)) {
+            TEST_ASSERT_EQUAL_UINT16(expected, evicted.seq);
+            expected++;
+            outputs++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(100 - JITTER_BUFFER_CAPACITY, outputs);
+    TEST_ASSERT_EQUAL_UINT32(100 - JITTER_BUFFER_CAPACITY, buffer.overflowCount());
+
+    QueueItem_t item;
+    while (buffer.popDue(UINT32_MAX / 2, item)) {
+        TEST_ASSERT_EQUAL_UINT16(expected, item.seq);
+        expected++;
+    }
+    TEST_ASSERT_EQUAL_UINT16(100, expected);
+}
+
+// 满缓冲时到达一个比缓冲内所有样本都早的样本（乱序）：它本身就是最早的，直接放出
+static void test_overflow_with_earliest_new_sample(void) {
+    JitterBuffer buffer = makeBuffer(50000);
+    QueueItem_t evicted;
+    for (uint16_t seq = 1; seq <= JITTER_BUFFER_CAPACITY; seq++) {
+        TEST_ASSERT_FALSE(buffer.push(timedSample(seq, seq * 1000, seq * 1000 + 200), evicted));
+    }
+    TEST_ASSERT_TRUE(buffer.push(timedSample(0, 0, 20000), evicted));
+    TEST_ASSERT_EQUAL_UINT16(0, evicted.seq);
+
+    QueueItem_t item;
+    uint16_t expected = 1;
+    while (buffer.popDue(UINT32_MAX / 2, item)) {
+        TEST_ASSERT_EQUAL_UINT16(expected, item.seq);
+        expected++;
+    }
+    TEST_ASSERT_EQUAL_UINT16(JITTER_BUFFER_CAPACITY + 1, expected);
+}
+
+static void test_samples_play_out_after_delay(void) {
+    JitterBuffer buffer = makeBuffer(800);
+    QueueItem_t evicted, item;
+    TEST_ASSERT_FALSE(buffer.push(timedSample(0, 10000, 10300), evicted));
+    TEST_ASSERT_FALSE(buffer.popDue(10300 + 799, item));
+    TEST_ASSERT_TRUE(buffer.popDue(10300 + 800, item));
+    TEST_ASSERT_EQUAL_UINT16(0, item.seq);
+}
+
+// 发送间隔 1ms，首个样本时延 5000us、其后 1000us：后到的样本使偏移估计下调，算出的播放时间早于
+// 首个样本，但仍要按发送顺序放出
+static void test_faster_frames_do_not_overtake(void) {
+    JitterBuffer buffer = makeBuffer(800);
+    const uint32_t delays[] = {5000, 1000, 1000, 1000};
+    QueueItem_t evicted, item;
+    for (uint16_t seq = 0; seq < 4; seq++) {
+        TEST_ASSERT_FALSE(buffer.push(timedSample(seq, 100000 + seq * 1000, 100000 + seq * 1000 + delays[seq]), evicted));
+    }
+    uint32_t lastPlayAt = 0;
+    for (uint16_t seq = 0; seq < 4; seq++) {
+        uint32_t playAt;
+        TEST_ASSERT_TRUE(buffer.nextPlayAt(playAt));
+        TEST_ASSERT_TRUE(playAt >= lastPlayAt);
+        lastPlayAt = playAt;
+        TEST_ASSERT_TRUE(buffer.popDue(UINT32_MAX / 2, item));
+        TEST_ASSERT_EQUAL_UINT16(seq, item.seq);
+    }
+}
+
+// 大抖动之后链路变干净：播放延迟每个样本收缩 1/16，收缩量超过 125us 的发送间隔，播放时间仍不回退，
+// 输出不乱序
+static void test_shrinking_playout_keeps_order(void) {
+    JitterBuffer buffer;
+    buffer.setParams({true, 500, 20000, 3});
+    QueueItem_t evicted, item;
+    uint32_t seed = 99;
+    for (uint16_t seq = 0; seq < 40; seq++) {
+        seed = seed * 1664525u + 1013904223u;
+        const uint32_t sendUs = 200000 + seq * 125;
+        buffer.push(timedSample(seq, sendUs, sendUs + 300 + (seed >> 20) % 6000), evicted);
+    }
+    while (buffer.popDue(UINT32_MAX / 2, item)) {
+    }
+    const uint32_t playout = buffer.playoutDelayUs();
+
+    for (uint16_t seq = 40; seq < 40 + JITTER_BUFFER_CAPACITY; seq++) {
+        const uint32_t sendUs = 200000 + seq * 125;
+        TEST_ASSERT_FALSE(buffer.push(timedSample(seq, sendUs, sendUs + 300), evicted));
+    }
+    TEST_ASSERT_LESS_THAN(playout, buffer.playoutDelayUs());
+    uint16_t expected = 40;
+    uint32_t lastPlayAt = 0;
+    uint32_t playAt;
+    while (buffer.nextPlayAt(playAt)) {
+        TEST_ASSERT_TRUE(expected == 40 || (int32_t)(playAt - lastPlayAt) >= 0);
+        lastPlayAt = playAt;
+        TEST_ASSERT_TRUE(buffer.popDue(UINT32_MAX / 2, item));
+        TEST_ASSERT_EQUAL_UINT16(expected, item.seq);
+        expected++;
+    }
+    TEST_ASSERT_EQUAL_UINT16(40 + JITTER_BUFFER_CAPACITY, expected);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_overflow_evicts_oldest_in_order);
+    RUN_TEST(test_overflow_with_earliest_new_sample);
+    RUN_TEST(test_samples_play_out_after_delay);
+    RUN_TEST(test_faster_frames_do_not_overtake);
+    RUN_TEST(test_shrinking_playout_keeps_order);
+    return UNITY_END();
+}
@@ -0,0 +1,104 @@
+// 自适应抖动滤波的阶跃响应（pio test -e native -f test_jitter_filter）
+
+#include <unity.h>
+
+#include "jitter_filter.h"
+
+// 1ms 采样周期，速度估计的截止频率 10Hz
+static JitterFilter makeFilter(bool enabled, float minCutoffHz, float beta) {
+    const JitterFilterParams params = {enabled, minCutoffHz, beta, 10.0f, 1.0f};
+    JitterFilterTables tables;
+    TEST_ASSERT_TRUE(buildJitterFilterTables(params, tables));
+    JitterFilter filter;
+    filter.setTables(tables);
+    return filter;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_disabled_filter_is_passthrough(void) {
+    JitterFilter filter = makeFilter(false, 1.0f, 0.0f);
+    for (int16_t d = -40; d <= 40; d += 7) {
+        int16_t dx = d, dy = (int16_t)-d;
+        filter.apply(dx, dy);
+        TEST_ASSERT_EQUAL_INT(d, dx);
+        TEST_ASSERT_EQUAL_INT(-d, dy);
+    }
+}
+
+// 一次位置阶跃（单个样本移动 100 计数）：输出单调逼近，不过冲，约一个时间常数到达 63%，
+// 最终与输入的位置相差不到 1 计数
+static void test_position_step_settles_without_overshoot(void) {
+    const float cutoffHz = 20.0f;
+    JitterFilter filter = makeFilter(true, cutoffHz, 0.0f);
+    const int32_t step = 100;
+    const int tauSamples = (int)(1000.0f / (2.0f * 3.14159265f * cutoffHz) + 0.5f);
+
+    int32_t pos = 0;
+    int reach63 = -1;
+    for (int i = 0; i < 200; i++) {
+        int16_t dx = i == 0 ? (int16_t)step : 0, dy = 0;
+        filter.apply(dx, dy);
+        TEST_ASSERT_TRUE(dx >= 0);
+        TEST_ASSERT_EQUAL_INT(0, dy);
+        pos += dx;
+        TEST_ASSERT_TRUE(pos <= step);
+        if (reach63 < 0 && pos >= step * 63 / 100) {
+            reach63 = i;
+        }
+    }
+    TEST_ASSERT_TRUE(reach63 > 0);
+    TEST_ASSERT_INT_WITHIN(2, tauSamples, reach63);
+    TEST_ASSERT_INT_WITHIN(1, step, pos);
+}
+
+// 速度阶跃：从静止突然以 20 计数/样本匀速移动，速度估计升上来后输出与输入逐样本一致（零滞后），
+// 之前滞后的部分也被补齐
+static void test_velocity_step_reaches_zero_lag(void) {
+    JitterFilter filter = makeFilter(true, 1.0f, 1.0f);
+    int32_t in = 0, out = 0;
+    int firstExact = -1;
+    for (int i = 0; i < 100; i++) {
+        int16_t dx = 20, dy = 0;
+        filter.apply(dx, dy);
+        in += 20;
+        out += dx;
+        if (firstExact < 0 && dx == 20 && out >= in - 1) {
+            firstExact = i;
+        }
+    }
+    TEST_ASSERT_TRUE(firstExact >= 0);
+    TEST_ASSERT_LESS_THAN(20, firstExact);
+    TEST_ASSERT_INT_WITHIN(1, in, out);
+}
+
+// 静止时传感器在相邻两个计数之间来回跳（±1 噪声）：输出的报告远少于输入，位置不漂移
+static void test_stationary_noise_is_suppressed(void) {
+    JitterFilter filter = makeFilter(true, 1.0f, 1.0f);
+    uint32_t seed = 12345;
+    int32_t in = 0, out = 0;
+    int rawReports = 0, reports = 0;
+    for (int i = 0; i < 1000; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        const int32_t next = (int32_t)(seed >> 31);
+        int16_t dx = (int16_t)(next - in), dy = 0;
+        in = next;
+        rawReports += dx != 0;
+        filter.apply(dx, dy);
+        out += dx;
+        reports += dx != 0;
+    }
+    TEST_ASSERT_GREATER_THAN(300, rawReports);
+    TEST_ASSERT_LESS_THAN(rawReports / 10, reports);
+    TEST_ASSERT_INT_WITHIN(1, in, out);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_disabled_filter_is_passthrough);
+    RUN_TEST(test_position_step_settles_without_overshoot);
+    RUN_TEST(test_velocity_step_reaches_zero_lag);
+    RUN_TEST(test_stationary_noise_is_suppressed);
+    return UNITY_END();
+}
@@ -0,0 +1,160 @@
+// 主机链路仿真：场景文件解析与按虚拟时间运行的丢包/断线统计（pio test -e native -f test_link_sim）
+
+#include <unity.h>
+
+#include "config.h"
+#include "sim_runner.h"
+
+constexpr ReceiverConfig withoutTransforms() {
+    ReceiverConfig cfg = kReceiverConfig;
+    cfg.features = {false, false, false, false, false, false, false, false, false, false};
+    return cfg;
+}
+
+// 不做加速/滤波/外推，报告累计出的位移可以与发送端逐计数比较
+inline constexpr ReceiverConfig kBareConfig = withoutTransforms();
+
+static HostLinkSim<kBareConfig> sim;
+
+static SimSettings settingsFor(const char* const lines[], size_t count) {
+    SimSettings settings;
+    simDefaultSettings(settings);
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_TRUE(simParseSettingLine(settings, lines[i]));
+    }
+    return settings;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_setting_lines(void) {
+    const char* lines[] = {"# 注释", "", "  scenario=bursty  # 基础场景\r\n", "format=fec\n", "seconds=12",
+                           "seed=0x10", "jitter=2500", "lossb=0.5"};
+    const SimSettings settings = settingsFor(lines, sizeof(lines) / sizeof(lines[0]));
+    TEST_ASSERT_EQUAL_STRING("bursty", settings.scenario->name);
+    TEST_ASSERT_EQUAL_INT(SIM_FORMAT_FEC, settings.format);
+    TEST_ASSERT_EQUAL_UINT32(12, settings.seconds);
+    TEST_ASSERT_EQUAL_UINT32(16, settings.seed);
+    TEST_ASSERT_EQUAL_UINT32(2500, settings.params.jitterUs);
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, settings.params.lossBad);
+    TEST_ASSERT_EQUAL_FLOAT(linkSimFindScenario("bursty")->params.pBadToGood, settings.params.pBadToGood);
+
+    // 不合法的行被拒绝，设置保持不变
+    const char* bad[] = {"scenario=typical", "scenario=nowhere", "format=raw", "seconds=0", "seconds=61",
+                         "seconds=5s", "seed=", "lossb=1.5", "speed=3", "jitter", "jitter = 5"};
+    for (const char* line : bad) {
+        SimSettings copy = settings;
+        TEST_ASSERT_FALSE(simParseSettingLine(copy, line));
+        TEST_ASSERT_TRUE(copy.scenario == settings.scenario);
+        TEST_ASSERT_EQUAL_MEMORY(&settings.params, &copy.params, sizeof(copy.params));
+        TEST_ASSERT_EQUAL_INT(settings.format, copy.format);
+        TEST_ASSERT_EQUAL_UINT32(settings.seconds, copy.seconds);
+        TEST_ASSERT_EQUAL_UINT32(settings.seed, copy.seed);
+    }
+}
+
+// 无损信道：两遍的结果完全相同，光标终点与发送端的总位移一致
+static void test_clean_link_matches_sender(void) {
+    SimSettings settings;
+    simDefaultSettings(settings);
+    sim.run(settings);
+    const SimPassResult& ref = sim.reference();
+    TEST_ASSERT_EQUAL_MEMORY(&ref, &sim.scenario(), sizeof(ref));
+    TEST_ASSERT_EQUAL_UINT32(0, ref.lost);
+    TEST_ASSERT_EQUAL_UINT32(0, ref.disconnects);
+    TEST_ASSERT_EQUAL_UINT32(0, ref.latencyMax);
+    TEST_ASSERT_EQUAL_UINT32(10, ref.checkpoints);
+    TEST_ASSERT_EQUAL_INT32(sim.truthX(), ref.finalX);
+    TEST_ASSERT_EQUAL_INT32(sim.truthY(), ref.finalY);
+}
+
+// 累计计数帧在拥塞信道（丢包、重复、乱序）上建立基准之后不丢位移；报告延迟包含信道延迟与抖动
+static void test_cumulative_frames_survive_congestion(void) {
+    const char* lines[] = {"scenario=congested", "format=cumulative", "seconds=10", "seed=3"};
+    sim.run(settingsFor(lines, 4));
+    const SimPassResult& run = sim.scenario();
+    TEST_ASSERT_GREATER_THAN(100, run.lost);
+    TEST_ASSERT_GREATER_THAN(0, run.duplicated);
+    TEST_ASSERT_GREATER_THAN(0, run.reordered);
+    TEST_ASSERT_EQUAL_UINT32(0, run.disconnects);
+    // 首个收到的帧只建立基准，之前的位移无从得知；此后每个检查点与参照的偏差都不变
+    const int32_t offsetX = run.finalX - sim.truthX(), offsetY = run.finalY - sim.truthY();
+    TEST_ASSERT_INT_WITHIN(5, 0, offsetX);
+    TEST_ASSERT_INT_WITHIN(5, 0, offsetY);
+    for (uint32_t i = 0; i < run.checkpoints; i++) {
+        TEST_ASSERT_EQUAL_INT32(sim.reference().checkX[i] + offsetX, run.checkX[i]);
+        TEST_ASSERT_EQUAL_INT32(sim.reference().checkY[i] + offsetY, run.checkY[i]);
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(1500, run.latencyP50);
+    TEST_ASSERT_LESS_OR_EQUAL(1500 + 4000 + 5000 + 100, run.latencyMax);
+}
+
+// 长时间中断超过心跳超时：连接断开，恢复后旧发送端的首个数据包重新建立连接，报告继续输出
+static void test_outage_disconnects_and_reconnects(void) {
+    const char* lines[] = {"scenario=outage", "seconds=30", "seed=2"};
+    sim.run(settingsFor(lines, 3));
+    const SimPassResult& ref = sim.reference();
+    const SimPassResult& run = sim.scenario();
+    TEST_ASSERT_GREATER_THAN(kBareConfig.connectionTimeoutMs, run.longestBurst * SIM_INTERVAL_US / 1000);
+    TEST_ASSERT_GREATER_THAN(0, run.disconnects);
+    TEST_ASSERT_EQUAL_UINT32(0, ref.disconnects);
+    // 这个种子下中断发生在中途、最后一段没有丢包：重连后的位移与参照一致
+    const uint32_t last = run.checkpoints - 1;
+    TEST_ASSERT_EQUAL_INT32(ref.checkX[last] - ref.checkX[last - 1], run.checkX[last] - run.checkX[last - 1]);
+    TEST_ASSERT_EQUAL_INT32(ref.checkY[last] - ref.checkY[last - 1], run.checkY[last] - run.checkY[last - 1]);
+}
+
+// 相同的场景、格式和种子结果逐项相同；换种子得到不同的丢包序列
+static void test_runs_are_reproducible(void) {
+    const char* lines[] = {"scenario=bursty", "format=fec", "seconds=5", "seed=7"};
+    const SimSettings settings = settingsFor(lines, 4);
+    static SimPassResult first;
+    sim.run(settings);
+    first = sim.scenario();
+    TEST_ASSERT_GREATER_THAN(0, first.fecRecovered);
+    sim.run(settings);
+    TEST_ASSERT_EQUAL_MEMORY(&first, &sim.scenario(), sizeof(first));
+
+    SimSettings other = settings;
+    other.seed = 8;
+    sim.run(other);
+    TEST_ASSERT_NOT_EQUAL(first.lost, sim.scenario().lost);
+}
+
+// 百分位取所在档的上界，但不超过实际的最大值
+static void test_latency_percentiles_never_exceed_max(void) {
+    LatencyHistogram histogram;
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.percentileUs(50));
+    for (int i = 0; i < 10; i++) {
+        histogram.add(0);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.percentileUs(50));
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.percentileUs(99));
+
+    histogram.reset();
+    for (uint32_t i = 0; i < 100; i++) {
+        histogram.add(i < 90 ? LATENCY_BUCKET_US / 2 : 3 * LATENCY_BUCKET_US + 7);
+    }
+    TEST_ASSERT_EQUAL_UINT32(LATENCY_BUCKET_US, histogram.percentileUs(50));
+    TEST_ASSERT_EQUAL_UINT32(3 * LATENCY_BUCKET_US + 7, histogram.percentileUs(99));
+    TEST_ASSERT_EQUAL_UINT32(histogram.maxUs(), histogram.percentileUs(99));
+
+    // 参照遍（无损信道）的百分位同样不超过最大值
+    static SimPassResult reference;
+    sim.runPass(kLinkSimScenarios[0].params, SIM_FORMAT_MOTION, 2000000, 1, reference);
+    TEST_ASSERT_GREATER_THAN(0, reference.reports);
+    TEST_ASSERT_TRUE(reference.latencyP50 <= reference.latencyMax);
+    TEST_ASSERT_TRUE(reference.latencyP99 <= reference.latencyMax);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_setting_lines);
+    RUN_TEST(test_clean_link_matches_sender);
+    RUN_TEST(test_cumulative_frames_survive_congestion);
+    RUN_TEST(test_outage_disconnects_and_reconnects);
+    RUN_TEST(test_runs_are_reproducible);
+    RUN_TEST(test_latency_percentiles_never_exceed_max);
+    return UNITY_END();
+}
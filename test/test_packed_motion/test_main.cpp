@@ -0,0 +1,136 @@
+// 变长压缩运动帧：varint/zigzag 往返与批量编解码（pio test -e native -f test_packed_motion）
+
+#include <unity.h>
+
+#include "link_sim.h"
+#include "packed_motion.h"
+
+static const uint8_t kMac[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+
+struct Collected {
+    QueueItem_t items[PACKED_MAX_SAMPLES];
+    uint8_t count;
+};
+
+static bool decodeFrame(PackedMotionDecoder& decoder, const uint8_t* frame, size_t len, Collected& out) {
+    out.count = 0;
+    return decoder.decode(kMac, 0, frame, len, [&](const QueueItem_t& item) {
+        TEST_ASSERT_TRUE(out.count < PACKED_MAX_SAMPLES);
+        out.items[out.count++] = item;
+    });
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_zigzag_round_trip(void) {
+    for (int32_t v = INT16_MIN; v <= INT16_MAX; v++) {
+        TEST_ASSERT_EQUAL_INT32(v, zigzagDecode(zigzagEncode(v)));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, zigzagEncode(0));
+    TEST_ASSERT_EQUAL_UINT32(1, zigzagEncode(-1));
+    TEST_ASSERT_EQUAL_UINT32(2, zigzagEncode(1));
+    TEST_ASSERT_EQUAL_UINT32(65535, zigzagEncode(INT16_MIN));
+}
+
+// 单字段最长 3 字节：小值 1 字节，int16 全范围不超过 3 字节
+static void test_varint_lengths_and_limits(void) {
+    uint8_t buf[4] = {0x7F};
+    uint32_t value = 0;
+    TEST_ASSERT_EQUAL_INT(1, readVarint(buf, buf + 1, value) - buf);
+    TEST_ASSERT_EQUAL_UINT32(0x7F, value);
+
+    const uint8_t two[] = {0x80, 0x01};
+    TEST_ASSERT_EQUAL_INT(2, readVarint(two, two + 2, value) - two);
+    TEST_ASSERT_EQUAL_UINT32(0x80, value);
+
+    const uint8_t three[] = {0xFF, 0xFF, 0x7F};
+    TEST_ASSERT_EQUAL_INT(3, readVarint(three, three + 3, value) - three);
+    TEST_ASSERT_EQUAL_UINT32((1u << 21) - 1, value);
+
+    // 截断与超长都被拒绝
+    TEST_ASSERT_NULL(readVarint(two, two + 1, value));
+    const uint8_t overlong[] = {0x80, 0x80, 0x80, 0x01};
+    TEST_ASSERT_NULL(readVarint(overlong, overlong + 4, value));
+}
+
+// 随机样本按 1~8 的批量编码再解码，逐项一致；序号依次递增
+static void test_batches_round_trip(void) {
+    SimRandom random;
+    random.seed(7);
+    PackedMotionDecoder decoder;
+    uint8_t encoderButtons = 0;
+    uint16_t seq = 65530;  // 批量内的序号跨过回绕
+    for (int round = 0; round < 2000; round++) {
+        const uint8_t count = (uint8_t)(1 + round % PACKED_MAX_SAMPLES);
+        PackedSample samples[PACKED_MAX_SAMPLES];
+        for (uint8_t i = 0; i < count; i++) {
+            const uint32_t r = random.next();
+            // 各字段约一半为 0（不写入帧），其余取值覆盖全范围
+            samples[i].deltaX = (r & 1) ? (int16_t)random.next() : 0;
+            samples[i].deltaY = (r & 2) ? (int16_t)(random.next() >> 20) - 2048 : 0;
+            samples[i].wheel = (r & 4) ? (int8_t)random.next() : 0;
+            samples[i].buttons = (r & 0x18) == 0x18 ? (uint8_t)(random.next() & 0x1F) : encoderButtons;
+        }
+        uint8_t frame[PACKED_MAX_FRAME_SIZE];
+        const size_t len = encodePackedMotion(samples, count, seq, 1000, encoderButtons, round == 0, frame,
+                                              sizeof(frame));
+        TEST_ASSERT_GREATER_THAN(0, len);
+        TEST_ASSERT_LESS_OR_EQUAL(PACKED_MAX_FRAME_SIZE, len);
+
+        Collected out;
+        TEST_ASSERT_TRUE(decodeFrame(decoder, frame, len, out));
+        TEST_ASSERT_EQUAL_INT(count, out.count);
+        for (uint8_t i = 0; i < count; i++) {
+            TEST_ASSERT_EQUAL_UINT16((uint16_t)(seq + i), out.items[i].seq);
+            TEST_ASSERT_EQUAL_INT(samples[i].deltaX, out.items[i].deltaX);
+            TEST_ASSERT_EQUAL_INT(samples[i].deltaY, out.items[i].deltaY);
+            TEST_ASSERT_EQUAL_INT(samples[i].wheel, out.items[i].wheel);
+            TEST_ASSERT_EQUAL_HEX8(samples[i].buttons, out.items[i].buttons);
+            TEST_ASSERT_EQUAL_UINT16(1000, out.items[i].intervalUs);
+        }
+        seq = (uint16_t)(seq + count);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, decoder.rejected());
+}
+
+// 静止的批量帧只有头部与掩码
+static void test_idle_batch_is_compact(void) {
+    PackedSample samples[PACKED_MAX_SAMPLES] = {};
+    uint8_t buttons = 0;
+    uint8_t frame[PACKED_MAX_FRAME_SIZE];
+    const size_t len = encodePackedMotion(samples, PACKED_MAX_SAMPLES, 0, 1000, buttons, false, frame, sizeof(frame));
+    TEST_ASSERT_EQUAL_INT(PACKED_HEADER_SIZE + 2 + PACKED_MAX_SAMPLES / 2, len);
+}
+
+// 截断、追加字节或样本数非法的帧整帧拒绝，不产生任何队列项
+static void test_malformed_frames_are_rejected(void) {
+    PackedSample samples[3] = {{5, -5, 1, 1}, {300, 0, 0, 1}, {-7000, 12, -1, 0}};
+    uint8_t buttons = 0;
+    uint8_t frame[PACKED_MAX_FRAME_SIZE + 1];
+    const size_t len = encodePackedMotion(samples, 3, 42, 1000, buttons, true, frame, PACKED_MAX_FRAME_SIZE);
+    PackedMotionDecoder decoder;
+    Collected out;
+    for (size_t cut = 0; cut < len; cut++) {
+        TEST_ASSERT_FALSE(decodeFrame(decoder, frame, cut, out));
+        TEST_ASSERT_EQUAL_INT(0, out.count);
+    }
+    frame[len] = 0;
+    TEST_ASSERT_FALSE(decodeFrame(decoder, frame, len + 1, out));
+
+    frame[3] = PACKED_MAX_SAMPLES + 1;
+    TEST_ASSERT_FALSE(decodeFrame(decoder, frame, len, out));
+    frame[3] = 3;
+    TEST_ASSERT_TRUE(decodeFrame(decoder, frame, len, out));
+    TEST_ASSERT_EQUAL_INT(3, out.count);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_zigzag_round_trip);
+    RUN_TEST(test_varint_lengths_and_limits);
+    RUN_TEST(test_batches_round_trip);
+    RUN_TEST(test_idle_batch_is_compact);
+    RUN_TEST(test_malformed_frames_are_rejected);
+    return UNITY_END();
+}
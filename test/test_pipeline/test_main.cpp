@@ -0,0 +1,198 @@
+// 管线在不同编译期配置下的行为与体积（pio test -e native -f test_pipeline）
+
+#include <unity.h>
+
+#include "config.h"
+#include "pipeline.h"
+
+constexpr ReceiverConfig withFeatures(FeatureToggles features) {
+    ReceiverConfig cfg = kReceiverConfig;
+    cfg.features = features;
+    return cfg;
+}
+
+constexpr ReceiverConfig withAccelGain(ReceiverConfig cfg, float gain) {
+    cfg.accel = {ACCEL_CURVE_LINEAR, gain, 0.0f, 1.0f, 1.0f, {}, 0};
+    return cfg;
+}
+
+constexpr ReceiverConfig withKeepAlive(ReceiverConfig cfg, uint32_t ms) {
+    cfg.hidKeepAliveMs = ms;
+    return cfg;
+}
+
+// features: filters, dpiScale, jitter, predictor, jitterBuffer, feedback, accel, stats, tracing, keyboard
+inline constexpr ReceiverConfig kFullConfig = withAccelGain(kReceiverConfig, 2.0f);
+inline constexpr ReceiverConfig kBareConfig =
+    withFeatures({false, false, false, false, false, false, false, false, false, false});
+inline constexpr ReceiverConfig kAccelOnlyConfig =
+    withAccelGain(withFeatures({true, false, false, false, false, false, true, false, false, false}), 2.0f);
+// filters 总开关关闭时，单独打开的变换阶段也不编译进来
+inline constexpr ReceiverConfig kFiltersOffConfig =
+    withAccelGain(withFeatures({false, true, true, false, false, false, true, true, false, false}), 2.0f);
+inline constexpr ReceiverConfig kPredictorOnlyConfig =
+    withFeatures({false, false, false, true, false, false, false, false, false, false});
+inline constexpr ReceiverConfig kKeepAliveConfig = withKeepAlive(kBareConfig, 50);
+
+// 记录最后一个报告
+struct RecordingSink {
+    bool report(int16_t x, int16_t y, int16_t scroll, int16_t pan, uint8_t buttons, bool force) {
+        reports++;
+        lastForce = force;
+        lastX = x;
+        lastY = y;
+        lastScroll = scroll;
+        lastButtons = buttons;
+        return true;
+    }
+
+    uint32_t reports = 0;
+    int16_t lastX = 0;
+    int16_t lastY = 0;
+    int16_t lastScroll = 0;
+    uint8_t lastButtons = 0;
+    bool lastForce = false;
+};
+
+static QueueItem_t motionItem(int16_t dx, int16_t dy, uint8_t buttons) {
+    QueueItem_t item = {};
+    item.type = PACKET_TYPE_MOUSE_DATA;
+    item.deltaX = dx;
+    item.deltaY = dy;
+    item.buttons = buttons;
+    return item;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// 被关闭的阶段不占存储：全关的管线至少比全开的小四个阶段引擎与其暂存参数
+static void test_disabled_stages_take_no_storage(void) {
+    using Full = MousePipeline<kFullConfig, RecordingSink>;
+    using Bare = MousePipeline<kBareConfig, RecordingSink>;
+    using AccelOnly = MousePipeline<kAccelOnlyConfig, RecordingSink>;
+    const size_t stages = sizeof(AccelEngine) + sizeof(JitterFilter) + sizeof(MotionPredictor) + sizeof(DpiScaler);
+    const size_t pending = sizeof(AccelCurve) + sizeof(JitterFilterTables) + sizeof(PredictorParams);
+    TEST_ASSERT_LESS_OR_EQUAL(sizeof(Full), sizeof(Bare) + stages + pending);
+    TEST_ASSERT_LESS_THAN(sizeof(AccelOnly), sizeof(Bare));
+    TEST_ASSERT_LESS_OR_EQUAL(sizeof(Bare) + sizeof(AccelEngine) + sizeof(AccelCurve), sizeof(AccelOnly));
+    TEST_ASSERT_LESS_THAN(sizeof(AccelOnly), sizeof(MousePipeline<kFiltersOffConfig, RecordingSink>));
+}
+
+static void test_bare_pipeline_passes_motion_through(void) {
+    RecordingSink sink;
+    VirtualClock clock;
+    MousePipeline<kBareConfig, RecordingSink> pipeline(sink, clock);
+    pipeline.process(motionItem(3, -2, 0x01));
+    TEST_ASSERT_EQUAL_UINT32(1, sink.reports);
+    TEST_ASSERT_EQUAL_INT(3, sink.lastX);
+    TEST_ASSERT_EQUAL_INT(-2, sink.lastY);
+    TEST_ASSERT_EQUAL_HEX8(HID_BUTTON_LEFT, sink.lastButtons);
+
+    // 与上次报告相同的空样本不发送
+    pipeline.process(motionItem(0, 0, 0x01));
+    TEST_ASSERT_EQUAL_UINT32(1, sink.reports);
+
+    // 设置被关闭阶段的参数不影响输出
+    pipeline.setDpiScale(DPI_SCALE_ONE * 2, DPI_SCALE_ONE * 2);
+    pipeline.process(motionItem(5, 5, 0));
+    TEST_ASSERT_EQUAL_INT(5, sink.lastX);
+    TEST_ASSERT_EQUAL_INT(5, sink.lastY);
+}
+
+static void test_accel_only_pipeline_applies_curve(void) {
+    RecordingSink sink;
+    VirtualClock clock;
+    MousePipeline<kAccelOnlyConfig, RecordingSink> pipeline(sink, clock);
+    pipeline.process(motionItem(3, -2, 0));
+    TEST_ASSERT_EQUAL_INT(6, sink.lastX);
+    TEST_ASSERT_EQUAL_INT(-4, sink.lastY);
+
+    AccelCurve curve;
+    const AccelCurveParams params = {ACCEL_CURVE_LINEAR, 1.0f, 0.0f, 1.0f, 1.0f, {}, 0};
+    TEST_ASSERT_TRUE(buildAccelCurve(params, curve));
+    pipeline.setAccelCurve(curve);
+    pipeline.process(motionItem(3, -2, 0));
+    TEST_ASSERT_EQUAL_INT(3, sink.lastX);
+    TEST_ASSERT_EQUAL_INT(-2, sink.lastY);
+}
+
+static void test_filters_master_toggle_disables_stages(void) {
+    RecordingSink sink;
+    VirtualClock clock;
+    MousePipeline<kFiltersOffConfig, RecordingSink> pipeline(sink, clock);
+    pipeline.process(motionItem(3, -2, 0));
+    TEST_ASSERT_EQUAL_INT(3, sink.lastX);
+    TEST_ASSERT_EQUAL_INT(-2, sink.lastY);
+    TEST_ASSERT_EQUAL_UINT32(1, pipeline.stats().reports);
+}
+
+static void test_full_pipeline_applies_accel_and_counts(void) {
+    RecordingSink sink;
+    VirtualClock clock;
+    MousePipeline<kFullConfig, RecordingSink> pipeline(sink, clock);
+    pipeline.process(motionItem(3, -2, 0x02));
+    TEST_ASSERT_EQUAL_INT(6, sink.lastX);
+    TEST_ASSERT_EQUAL_INT(-4, sink.lastY);
+    TEST_ASSERT_EQUAL_HEX8(HID_BUTTON_RIGHT, sink.lastButtons);
+    TEST_ASSERT_EQUAL_UINT32(1, pipeline.stats().motionReports);
+    TEST_ASSERT_EQUAL_UINT32(1, pipeline.stats().buttonEvents);
+}
+
+static void test_predictor_only_pipeline_drops_stale_frames(void) {
+    RecordingSink sink;
+    VirtualClock clock;
+    MousePipeline<kPredictorOnlyConfig, RecordingSink> pipeline(sink, clock);
+    QueueItem_t item = motionItem(4, 0, 0);
+    item.flags = QUEUE_ITEM_HAS_SEQ;
+    item.seq = 10;
+    item.intervalUs = 1000;
+    pipeline.process(item);
+    TEST_ASSERT_EQUAL_UINT32(1, sink.reports);
+
+    // 重复的序号被丢弃
+    item.deltaX = 7;
+    pipeline.process(item);
+    TEST_ASSERT_EQUAL_UINT32(1, sink.reports);
+    TEST_ASSERT_EQUAL_INT(4, sink.lastX);
+}
+
+// 保活按虚拟时钟计时：按键按住满 hidKeepAliveMs 才重发，松开后不再重发
+static void test_keep_alive_follows_clock(void) {
+    RecordingSink sink;
+    VirtualClock clock(1000);
+    MousePipeline<kKeepAliveConfig, RecordingSink> pipeline(sink, clock);
+    pipeline.process(motionItem(0, 0, 0x01));
+    TEST_ASSERT_EQUAL_UINT32(1, sink.reports);
+    TEST_ASSERT_EQUAL_UINT32(pdMS_TO_TICKS(50), pipeline.ticksUntilDue());
+
+    clock.advanceMs(49);
+    pipeline.poll();
+    TEST_ASSERT_EQUAL_UINT32(1, sink.reports);
+    TEST_ASSERT_EQUAL_UINT32(pdMS_TO_TICKS(1), pipeline.ticksUntilDue());
+
+    clock.advanceMs(1);
+    pipeline.poll();
+    TEST_ASSERT_EQUAL_UINT32(2, sink.reports);
+    TEST_ASSERT_TRUE(sink.lastForce);
+    TEST_ASSERT_EQUAL_HEX8(HID_BUTTON_LEFT, sink.lastButtons);
+
+    pipeline.process(motionItem(0, 0, 0));
+    TEST_ASSERT_EQUAL_UINT32(3, sink.reports);
+    TEST_ASSERT_EQUAL_UINT32(portMAX_DELAY, pipeline.ticksUntilDue());
+    clock.advanceMs(500);
+    pipeline.poll();
+    TEST_ASSERT_EQUAL_UINT32(3, sink.reports);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_disabled_stages_take_no_storage);
+    RUN_TEST(test_bare_pipeline_passes_motion_through);
+    RUN_TEST(test_accel_only_pipeline_applies_curve);
+    RUN_TEST(test_filters_master_toggle_disables_stages);
+    RUN_TEST(test_full_pipeline_applies_accel_and_counts);
+    RUN_TEST(test_predictor_only_pipeline_drops_stale_frames);
+    RUN_TEST(test_keep_alive_follows_clock);
+    return UNITY_END();
+}
@@ -0,0 +1,176 @@
+// 主机回放：导出记录的解析与经接收路径的重放（pio test -e native -f test_replay）
+
+#include <string.h>
+#include <unity.h>
+
+#include "config.h"
+#include "link_sim.h"
+#include "replay.h"
+
+static const uint8_t kMac[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+
+// 与 capture dump 相同的格式
+static void formatRecord(char* line, size_t size, uint32_t arrivalUs, const uint8_t mac[6], const void* frame,
+                         size_t len) {
+    int n = snprintf(line, size, "C %u %02X%02X%02X%02X%02X%02X ", (unsigned)arrivalUs, mac[0], mac[1], mac[2],
+                     mac[3], mac[4], mac[5]);
+    for (size_t i = 0; i < len; i++) {
+        n += snprintf(line + n, size - n, "%02X", ((const uint8_t*)frame)[i]);
+    }
+    snprintf(line + n, size - n, "\r\n");
+}
+
+constexpr ReceiverConfig withFeatures(FeatureToggles features, bool jitterBuffer) {
+    ReceiverConfig cfg = kReceiverConfig;
+    cfg.features = features;
+    cfg.jitterBuffer.enabled = jitterBuffer;
+    return cfg;
+}
+
+// features: filters, dpiScale, jitter, predictor, jitterBuffer, feedback, accel, stats, tracing, keyboard
+inline constexpr ReceiverConfig kBareConfig =
+    withFeatures({false, false, false, false, false, false, false, false, false, false}, false);
+inline constexpr ReceiverConfig kPlayoutConfig =
+    withFeatures({false, false, false, false, true, false, false, false, false, false}, true);
+
+// 累计光标位置与报告数，并计算摘要
+struct CursorSink {
+    bool report(int16_t x, int16_t y, int16_t scroll, int16_t pan, uint8_t buttons, bool force) {
+        const int16_t fields[4] = {x, y, scroll, pan};
+        uint8_t bytes[sizeof(fields) + 1];
+        memcpy(bytes, fields, sizeof(fields));
+        bytes[sizeof(fields)] = buttons;
+        digest.add(0, bytes, sizeof(bytes));
+        posX += x;
+        posY += y;
+        return true;
+    }
+
+    ReplayDigest digest;
+    int32_t posX = 0;
+    int32_t posY = 0;
+};
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_record_round_trip(void) {
+    uint8_t frame[CAPTURE_MAX_FRAME];
+    for (size_t i = 0; i < sizeof(frame); i++) {
+        frame[i] = (uint8_t)(i * 7);
+    }
+    char line[2 * CAPTURE_MAX_FRAME + 64];
+    formatRecord(line, sizeof(line), UINT32_MAX, kMac, frame, sizeof(frame));
+
+    CaptureRecordHeader header;
+    uint8_t data[CAPTURE_MAX_FRAME];
+    TEST_ASSERT_TRUE(replayParseRecord(line, header, data));
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, header.arrivalUs);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(kMac, header.mac, 6);
+    TEST_ASSERT_EQUAL_INT(CAPTURE_MAX_FRAME, header.len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(frame, data, sizeof(frame));
+
+    TEST_ASSERT_TRUE(replayParseRecord("C 5 0211223344aa 0102", header, data));
+    TEST_ASSERT_EQUAL_HEX8(0xAA, header.mac[5]);
+    TEST_ASSERT_EQUAL_INT(2, header.len);
+}
+
+static void test_malformed_records_are_skipped(void) {
+    CaptureRecordHeader header;
+    uint8_t data[CAPTURE_MAX_FRAME];
+    const char* bad[] = {
+        "",
+        "导出完成，共 3 帧。",
+        "H 100 1 0102",
+        "C  021122334455 01",
+        "C 100 0211223344 01",           // MAC 不足 6 字节
+        "C 100 021122334455",            // 没有帧数据
+        "C 100 021122334455 ",
+        "C 100 021122334455 012",        // 半个字节
+        "C 100 021122334455 01 x",
+        "C 4294967296 021122334455 01",  // 到达时间超出 32 位
+    };
+    for (const char* line : bad) {
+        TEST_ASSERT_FALSE(replayParseRecord(line, header, data));
+    }
+    char line[2 * CAPTURE_MAX_FRAME + 64];
+    uint8_t frame[CAPTURE_MAX_FRAME + 1] = {};
+    formatRecord(line, sizeof(line), 1, kMac, frame, sizeof(frame));
+    TEST_ASSERT_FALSE(replayParseRecord(line, header, data));
+}
+
+// 把帧格式化成导出记录再解析、回放
+template <const ReceiverConfig& Cfg>
+static void replayFrame(FrameReplayer<Cfg, CursorSink>& replayer, uint32_t arrivalUs, const void* frame,
+                        size_t len) {
+    char line[2 * CAPTURE_MAX_FRAME + 64];
+    formatRecord(line, sizeof(line), arrivalUs, kMac, frame, len);
+    CaptureRecordHeader header;
+    uint8_t data[CAPTURE_MAX_FRAME];
+    TEST_ASSERT_TRUE(replayParseRecord(line, header, data));
+    replayer.feed(header, data);
+}
+
+// 旧格式帧逐帧回放，光标位置与输入的位移总和一致
+static void test_replay_reproduces_motion(void) {
+    CursorSink sink;
+    FrameReplayer<kBareConfig, CursorSink> replayer(sink);
+    int32_t sumX = 0, sumY = 0;
+    for (int i = 0; i < 500; i++) {
+        UniversalPacket packet = {};
+        packet.type = PACKET_TYPE_MOUSE_DATA;
+        packet.deltaX = (int16_t)(i % 13 - 6);
+        packet.deltaY = (int16_t)(i % 5 - 1);
+        sumX += packet.deltaX;
+        sumY += packet.deltaY;
+        replayFrame(replayer, 1000000 + i * 1000, &packet, sizeof(packet));
+    }
+    replayer.finish(10000);
+    TEST_ASSERT_EQUAL_UINT32(500, replayer.frames());
+    TEST_ASSERT_EQUAL_UINT32(500, replayer.items());
+    TEST_ASSERT_EQUAL_INT32(sumX, sink.posX);
+    TEST_ASSERT_EQUAL_INT32(sumY, sink.posY);
+}
+
+// 到达时间抖动的带时间戳帧经抖动缓冲按发送端节奏放出：总位移不变，两次回放的输出完全一致
+static uint32_t replayJitteredTimedFrames(int32_t& posX) {
+    CursorSink sink;
+    FrameReplayer<kPlayoutConfig, CursorSink> replayer(sink);
+    SimRandom random;
+    random.seed(9);
+    int32_t sumX = 0;
+    for (uint16_t seq = 0; seq < 2000; seq++) {
+        TimedMotionPacket packet = {};
+        packet.type = PACKET_TYPE_MOTION_TIMED;
+        packet.seq = seq;
+        packet.intervalUs = 1000;
+        packet.senderTimeUs = 50000000u + seq * 1000u;
+        packet.deltaX = (int16_t)(seq % 9 + 1);
+        sumX += packet.deltaX;
+        const uint32_t arrivalUs = 7000000u + seq * 1000u + random.next() % 600;
+        replayFrame(replayer, arrivalUs, &packet, sizeof(packet));
+    }
+    replayer.finish(100000);
+    TEST_ASSERT_EQUAL_UINT32(2000, replayer.items());
+    TEST_ASSERT_EQUAL_INT32(sumX, sink.posX);
+    TEST_ASSERT_GREATER_THAN(0, replayer.path().jitterBuffer().playoutDelayUs());
+    posX = sink.posX;
+    return sink.digest.value();
+}
+
+static void test_replay_through_jitter_buffer_is_deterministic(void) {
+    int32_t firstX = 0, secondX = 0;
+    const uint32_t first = replayJitteredTimedFrames(firstX);
+    const uint32_t second = replayJitteredTimedFrames(secondX);
+    TEST_ASSERT_EQUAL_HEX32(first, second);
+    TEST_ASSERT_EQUAL_INT32(firstX, secondX);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_record_round_trip);
+    RUN_TEST(test_malformed_records_are_skipped);
+    RUN_TEST(test_replay_reproduces_motion);
+    RUN_TEST(test_replay_through_jitter_buffer_is_deterministic);
+    return UNITY_END();
+}